@@ -219,4 +219,94 @@ void AudioSystem::ValidateResult( FMOD_RESULT result )
 }
 
 
+#else // defined( ENGINE_DISABLE_AUDIO )
+
+
+//-----------------------------------------------------------------------------------------------
+// Null backend, never touches fmod so no fmod.dll is required
+//	Sounds are never created, so every call that takes an ID sees MISSING_SOUND_ID
+//
+AudioSystem::AudioSystem()
+	: m_fmodSystem( nullptr )
+{
+}
+
+
+AudioSystem::~AudioSystem()
+{
+}
+
+
+void AudioSystem::Startup() {
+
+}
+
+
+void AudioSystem::Shutdown() {
+
+}
+
+
+void AudioSystem::BeginFrame()
+{
+}
+
+
+void AudioSystem::EndFrame()
+{
+}
+
+
+SoundID AudioSystem::CreateOrGetSound( const std::string& soundFilePath )
+{
+	UNUSED( soundFilePath );
+	return MISSING_SOUND_ID;
+}
+
+
+SoundPlaybackID AudioSystem::PlaySound( SoundID soundID, bool isLooped, float volume, float balance, float speed, bool isPaused )
+{
+	UNUSED( soundID );
+	UNUSED( isLooped );
+	UNUSED( volume );
+	UNUSED( balance );
+	UNUSED( speed );
+	UNUSED( isPaused );
+	return MISSING_SOUND_ID;
+}
+
+
+void AudioSystem::StopSound( SoundPlaybackID soundPlaybackID )
+{
+	UNUSED( soundPlaybackID );
+}
+
+
+void AudioSystem::SetSoundPlaybackVolume( SoundPlaybackID soundPlaybackID, float volume )
+{
+	UNUSED( soundPlaybackID );
+	UNUSED( volume );
+}
+
+
+void AudioSystem::SetSoundPlaybackBalance( SoundPlaybackID soundPlaybackID, float balance )
+{
+	UNUSED( soundPlaybackID );
+	UNUSED( balance );
+}
+
+
+void AudioSystem::SetSoundPlaybackSpeed( SoundPlaybackID soundPlaybackID, float speed )
+{
+	UNUSED( soundPlaybackID );
+	UNUSED( speed );
+}
+
+
+void AudioSystem::ValidateResult( FMOD_RESULT result )
+{
+	UNUSED( result );
+}
+
+
 #endif // !defined( ENGINE_DISABLE_AUDIO )
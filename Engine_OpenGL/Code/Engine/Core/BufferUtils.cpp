@@ -0,0 +1,210 @@
+#include "Engine/Core/BufferUtils.hpp"
+
+#include "stdio.h"
+#include "string.h"
+
+
+//-----------------------------------------------------------------------------------------------
+static FILE* OpenFile( const std::string& filePath, const char* mode ) {
+#if defined( _WIN32 )
+    FILE* file = nullptr;
+    fopen_s( &file, filePath.c_str(), mode );
+    return file;
+#else
+    return fopen( filePath.c_str(), mode );
+#endif
+}
+
+
+bool SaveBufferToFile( const std::string& filePath, const ByteBuffer& buffer ) {
+    FILE* file = OpenFile( filePath, "wb" );
+    if( file == nullptr ) {
+        return false;
+    }
+
+    size_t numWritten = buffer.empty() ? 0 : fwrite( buffer.data(), 1, buffer.size(), file );
+    fclose( file );
+    return (numWritten == buffer.size());
+}
+
+
+bool LoadFileToBuffer( const std::string& filePath, ByteBuffer& out_buffer ) {
+    out_buffer.clear();
+
+    FILE* file = OpenFile( filePath, "rb" );
+    if( file == nullptr ) {
+        return false;
+    }
+
+    fseek( file, 0, SEEK_END );
+    long fileSize = ftell( file );
+    fseek( file, 0, SEEK_SET );
+
+    if( fileSize < 0 ) {
+        fclose( file );
+        return false;
+    }
+
+    out_buffer.resize( (size_t)fileSize );
+    size_t numRead = out_buffer.empty() ? 0 : fread( out_buffer.data(), 1, out_buffer.size(), file );
+    fclose( file );
+    return (numRead == out_buffer.size());
+}
+
+
+//-----------------------------------------------------------------------------------------------
+BufferWriter::BufferWriter( ByteBuffer& buffer ) :
+    m_buffer( buffer ) {
+}
+
+
+void BufferWriter::WriteBytes( const void* data, size_t numBytes ) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    m_buffer.insert( m_buffer.end(), bytes, bytes + numBytes );
+}
+
+
+void BufferWriter::WriteUint8( unsigned char value ) {
+    m_buffer.push_back( value );
+}
+
+
+void BufferWriter::WriteBool( bool value ) {
+    WriteUint8( value ? 1 : 0 );
+}
+
+
+void BufferWriter::WriteUint16( unsigned short value ) {
+    m_buffer.push_back( (unsigned char)(value & 0xff) );
+    m_buffer.push_back( (unsigned char)(value >> 8) );
+}
+
+
+void BufferWriter::WriteInt16( short value ) {
+    WriteUint16( (unsigned short)value );
+}
+
+
+void BufferWriter::WriteUint32( unsigned int value ) {
+    for( int byteIndex = 0; byteIndex < 4; byteIndex++ ) {
+        m_buffer.push_back( (unsigned char)((value >> (8 * byteIndex)) & 0xff) );
+    }
+}
+
+
+void BufferWriter::WriteInt32( int value ) {
+    WriteUint32( (unsigned int)value );
+}
+
+
+void BufferWriter::WriteFloat( float value ) {
+    unsigned int bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    WriteUint32( bits );
+}
+
+
+size_t BufferWriter::GetNumBytesWritten() const {
+    return m_buffer.size();
+}
+
+
+//-----------------------------------------------------------------------------------------------
+BufferReader::BufferReader( const ByteBuffer& buffer, size_t startOffset /*= 0*/ ) :
+    m_buffer( buffer ),
+    m_readOffset( startOffset ) {
+}
+
+
+void BufferReader::ReadBytes( void* out_data, size_t numBytes ) {
+    if( m_readOffset + numBytes > m_buffer.size() ) {
+        memset( out_data, 0, numBytes );
+        m_readOffset = m_buffer.size();
+        m_hasOverrun = true;
+        return;
+    }
+
+    memcpy( out_data, m_buffer.data() + m_readOffset, numBytes );
+    m_readOffset += numBytes;
+}
+
+
+void BufferReader::SkipBytes( size_t numBytes ) {
+    if( m_readOffset + numBytes > m_buffer.size() ) {
+        m_readOffset = m_buffer.size();
+        m_hasOverrun = true;
+        return;
+    }
+
+    m_readOffset += numBytes;
+}
+
+
+unsigned char BufferReader::ReadUint8() {
+    unsigned char value;
+    ReadBytes( &value, 1 );
+    return value;
+}
+
+
+bool BufferReader::ReadBool() {
+    return (ReadUint8() != 0);
+}
+
+
+unsigned short BufferReader::ReadUint16() {
+    unsigned char bytes[2];
+    ReadBytes( bytes, 2 );
+    return (unsigned short)(bytes[0] | (bytes[1] << 8));
+}
+
+
+short BufferReader::ReadInt16() {
+    return (short)ReadUint16();
+}
+
+
+unsigned int BufferReader::ReadUint32() {
+    unsigned char bytes[4];
+    ReadBytes( bytes, 4 );
+    return (unsigned int)bytes[0] | ((unsigned int)bytes[1] << 8) | ((unsigned int)bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+
+int BufferReader::ReadInt32() {
+    return (int)ReadUint32();
+}
+
+
+float BufferReader::ReadFloat() {
+    unsigned int bits = ReadUint32();
+    float value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+}
+
+
+bool BufferReader::IsAtEnd() const {
+    return (m_readOffset >= m_buffer.size());
+}
+
+
+bool BufferReader::HasOverrun() const {
+    return m_hasOverrun;
+}
+
+
+size_t BufferReader::GetReadOffset() const {
+    return m_readOffset;
+}
+
+
+bool BufferReader::CanRead( int numElements, size_t elementSize ) const {
+    if( numElements < 0 || m_hasOverrun ) {
+        return false;
+    }
+
+    // Divided rather than multiplied, so a huge count can't overflow
+    size_t numBytesLeft = m_buffer.size() - m_readOffset;
+    return (elementSize == 0) || ((size_t)numElements <= numBytesLeft / elementSize);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+
+#include <string>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------------------------
+// Little-endian binary streams for compact files (input replays, snapshots)
+// Values are written byte by byte so files are identical regardless of platform or struct padding
+typedef std::vector<unsigned char> ByteBuffer;
+
+bool SaveBufferToFile( const std::string& filePath, const ByteBuffer& buffer );
+bool LoadFileToBuffer( const std::string& filePath, ByteBuffer& out_buffer );
+
+
+//-----------------------------------------------------------------------------------------------
+class BufferWriter {
+    public:
+    explicit BufferWriter( ByteBuffer& buffer );
+
+    void WriteBytes( const void* data, size_t numBytes );
+    void WriteUint8( unsigned char value );
+    void WriteBool( bool value );
+    void WriteUint16( unsigned short value );
+    void WriteInt16( short value );
+    void WriteUint32( unsigned int value );
+    void WriteInt32( int value );
+    void WriteFloat( float value );
+
+    size_t GetNumBytesWritten() const;
+
+    private:
+    ByteBuffer& m_buffer;
+};
+
+
+//-----------------------------------------------------------------------------------------------
+// Reading past the end returns zeros and sets HasOverrun, so callers can check once after a batch of reads
+class BufferReader {
+    public:
+    explicit BufferReader( const ByteBuffer& buffer, size_t startOffset = 0 );
+
+    void ReadBytes( void* out_data, size_t numBytes );
+    void SkipBytes( size_t numBytes );
+    unsigned char ReadUint8();
+    bool ReadBool();
+    unsigned short ReadUint16();
+    short ReadInt16();
+    unsigned int ReadUint32();
+    int ReadInt32();
+    float ReadFloat();
+
+    bool IsAtEnd() const;
+    bool HasOverrun() const;
+    size_t GetReadOffset() const;
+    bool CanRead( int numElements, size_t elementSize ) const; // Check counts read from the buffer before sizing anything by them
+
+    private:
+    const ByteBuffer& m_buffer;
+    size_t m_readOffset = 0;
+    bool m_hasOverrun = false;
+};
@@ -44,7 +44,7 @@ bool DevConsole::Command_Exec( EventArgs& args ) {
         return true;
     }
 
-    XMLDocument document = new XMLDocument();
+    XMLDocument document;
     const XMLElement& root = ParseXMLRootElement( fileName.c_str(), document );
 
     const char* tagName = "DevConsoleCommand";
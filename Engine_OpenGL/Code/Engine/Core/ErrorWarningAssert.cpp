@@ -11,9 +11,13 @@
 
 //-----------------------------------------------------------------------------------------------
 #include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/EngineCommon.hpp"
 #include "Engine/Core/StringUtils.hpp"
 #include <stdarg.h>
+#include <stdio.h>
 #include <iostream>
+#include <stdlib.h>
+#include <string.h>
 
 
 //-----------------------------------------------------------------------------------------------
@@ -46,7 +50,11 @@ void DebuggerPrintf( const char* messageFormat, ... ) {
 	char messageLiteral[MESSAGE_MAX_LENGTH];
 	va_list variableArgumentList;
 	va_start( variableArgumentList, messageFormat );
+#if defined( PLATFORM_WINDOWS )
 	vsnprintf_s( messageLiteral, MESSAGE_MAX_LENGTH, _TRUNCATE, messageFormat, variableArgumentList );
+#else
+	vsnprintf( messageLiteral, MESSAGE_MAX_LENGTH, messageFormat, variableArgumentList );
+#endif
 	va_end( variableArgumentList );
 	messageLiteral[MESSAGE_MAX_LENGTH - 1] = '\0'; // In case vsnprintf overran (doesn't auto-terminate)
 
@@ -105,6 +113,10 @@ void SystemDialogue_Okay( const std::string& messageTitle, const std::string& me
 		MessageBoxA( NULL, messageText.c_str(), messageTitle.c_str(), MB_OK | dialogueIconTypeFlag | MB_TOPMOST );
 		ShowCursor( FALSE );
 	}
+#else
+	UNUSED( messageTitle );
+	UNUSED( messageText );
+	UNUSED( severity );
 #endif
 }
 
@@ -123,6 +135,10 @@ bool SystemDialogue_OkayCancel( const std::string& messageTitle, const std::stri
 		isAnswerOkay = (buttonClicked == IDOK);
 		ShowCursor( FALSE );
 	}
+#else
+	UNUSED( messageTitle );
+	UNUSED( messageText );
+	UNUSED( severity );
 #endif
 
 	return isAnswerOkay;
@@ -143,6 +159,10 @@ bool SystemDialogue_YesNo( const std::string& messageTitle, const std::string& m
 		isAnswerYes = (buttonClicked == IDYES);
 		ShowCursor( FALSE );
 	}
+#else
+	UNUSED( messageTitle );
+	UNUSED( messageText );
+	UNUSED( severity );
 #endif
 
 	return isAnswerYes;
@@ -163,6 +183,10 @@ int SystemDialogue_YesNoCancel( const std::string& messageTitle, const std::stri
 		answerCode = (buttonClicked == IDYES ? 1 : (buttonClicked == IDNO ? 0 : -1));
 		ShowCursor( FALSE );
 	}
+#else
+	UNUSED( messageTitle );
+	UNUSED( messageText );
+	UNUSED( severity );
 #endif
 
 	return answerCode;
@@ -170,7 +194,7 @@ int SystemDialogue_YesNoCancel( const std::string& messageTitle, const std::stri
 
 
 //-----------------------------------------------------------------------------------------------
-__declspec(noreturn) void FatalError( const char* filePath, const char* functionName, int lineNum, const std::string& reasonForError, const char* conditionText ) {
+[[noreturn]] void FatalError( const char* filePath, const char* functionName, int lineNum, const std::string& reasonForError, const char* conditionText ) {
 	std::string errorMessage = reasonForError;
 	if( reasonForError.empty() ) {
 		if( conditionText )
@@ -185,7 +209,7 @@ __declspec(noreturn) void FatalError( const char* filePath, const char* function
 	std::string fullMessageTitle = appName + " :: Error";
 	std::string fullMessageText = errorMessage;
 	fullMessageText += "\n\nThe application will now close.\n";
-	bool isDebuggerPresent = (IsDebuggerPresent() == TRUE);
+	bool isDebuggerPresent = IsDebuggerAvailable();
 	if( isDebuggerPresent ) {
 		fullMessageText += "\nDEBUGGER DETECTED!\nWould you like to break and debug?\n  (Yes=debug, No=quit)\n";
 	}
@@ -206,13 +230,19 @@ __declspec(noreturn) void FatalError( const char* filePath, const char* function
 
 	if( isDebuggerPresent ) {
 		bool isAnswerYes = SystemDialogue_YesNo( fullMessageTitle, fullMessageText, SEVERITY_FATAL );
+#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
 		if( isAnswerYes ) {
 			__debugbreak();
 		}
+#else
+		UNUSED( isAnswerYes );
+#endif
 	} else {
 		SystemDialogue_Okay( fullMessageTitle, fullMessageText, SEVERITY_FATAL );
+#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
+#endif
 	}
 
 	exit( 0 );
@@ -235,7 +265,7 @@ void RecoverableWarning( const char* filePath, const char* functionName, int lin
 	std::string fullMessageTitle = appName + " :: Warning";
 	std::string fullMessageText = errorMessage;
 
-	bool isDebuggerPresent = (IsDebuggerPresent() == TRUE);
+	bool isDebuggerPresent = IsDebuggerAvailable();
 	if( isDebuggerPresent ) {
 		fullMessageText += "\n\nDEBUGGER DETECTED!\nWould you like to continue running?\n  (Yes=continue, No=quit, Cancel=debug)\n";
 	} else {
@@ -258,17 +288,23 @@ void RecoverableWarning( const char* filePath, const char* functionName, int lin
 
 	if( isDebuggerPresent ) {
 		int answerCode = SystemDialogue_YesNoCancel( fullMessageTitle, fullMessageText, SEVERITY_WARNING );
+#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
+#endif
 		if( answerCode == 0 ) // "NO"
 		{
 			exit( 0 );
 		} else if( answerCode == -1 ) // "CANCEL"
 		{
+#if defined( PLATFORM_WINDOWS )
 			__debugbreak();
+#endif
 		}
 	} else {
 		bool isAnswerYes = SystemDialogue_YesNo( fullMessageTitle, fullMessageText, SEVERITY_WARNING );
+#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
+#endif
 		if( !isAnswerYes ) {
 			exit( 0 );
 		}
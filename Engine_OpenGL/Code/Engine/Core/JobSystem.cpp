@@ -0,0 +1,124 @@
+#include "Engine/Core/JobSystem.hpp"
+
+
+JobSystem::JobSystem() {
+
+}
+
+
+JobSystem::~JobSystem() {
+    Shutdown();
+}
+
+
+void JobSystem::Startup( int numWorkerThreads ) {
+    Shutdown();
+
+    if( numWorkerThreads < 0 ) {
+        int numHardwareThreads = (int)std::thread::hardware_concurrency();
+        numWorkerThreads = (numHardwareThreads > 1) ? (numHardwareThreads - 1) : 0;
+    }
+
+    m_isQuitting = false;
+    m_workers.reserve( numWorkerThreads );
+
+    for( int workerIndex = 0; workerIndex < numWorkerThreads; workerIndex++ ) {
+        m_workers.push_back( std::thread( &JobSystem::WorkerMain, this ) );
+    }
+}
+
+
+void JobSystem::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_isQuitting = true;
+    }
+
+    m_workReady.notify_all();
+
+    for( int workerIndex = 0; workerIndex < (int)m_workers.size(); workerIndex++ ) {
+        m_workers[workerIndex].join();
+    }
+
+    m_workers.clear();
+}
+
+
+int JobSystem::GetNumWorkerThreads() const {
+    return (int)m_workers.size();
+}
+
+
+void JobSystem::ParallelFor( int numJobs, JobFunction function, void* userData ) {
+    if( m_workers.empty() || numJobs <= 1 ) {
+        for( int jobIndex = 0; jobIndex < numJobs; jobIndex++ ) {
+            function( userData, jobIndex );
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_function = function;
+        m_userData = userData;
+        m_numJobs = numJobs;
+        m_nextJob = 0;
+        m_numJobsDone = 0;
+        m_batchIndex++;
+    }
+
+    m_workReady.notify_all();
+
+    while( RunNextJob() ) {
+    }
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_workDone.wait( lock, [this]() { return m_numJobsDone == m_numJobs; } );
+}
+
+
+void JobSystem::WorkerMain() {
+    unsigned int lastBatchIndex = 0;
+
+    while( true ) {
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_workReady.wait( lock, [this, lastBatchIndex]() { return m_isQuitting || m_batchIndex != lastBatchIndex; } );
+
+            if( m_isQuitting ) {
+                return;
+            }
+
+            lastBatchIndex = m_batchIndex;
+        }
+
+        while( RunNextJob() ) {
+        }
+    }
+}
+
+
+bool JobSystem::RunNextJob() {
+    // Jobs are coarse, so taking them under the lock costs nothing and keeps a late worker from mixing up batches
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if( m_nextJob >= m_numJobs ) {
+        return false;
+    }
+
+    int jobIndex = m_nextJob++;
+    JobFunction function = m_function;
+    void* userData = m_userData;
+    lock.unlock();
+
+    function( userData, jobIndex );
+
+    lock.lock();
+    m_numJobsDone++;
+
+    if( m_numJobsDone == m_numJobs ) {
+        m_workDone.notify_all();
+    }
+
+    return true;
+}
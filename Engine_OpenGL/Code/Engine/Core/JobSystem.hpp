@@ -0,0 +1,43 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------------------------
+// Fixed pool of worker threads for data-parallel work
+// ParallelFor runs every job index once and blocks until they are all done, the calling thread runs jobs too,
+//	so a pool with no workers runs everything inline in index order
+typedef void( *JobFunction )(void* userData, int jobIndex);
+
+class JobSystem {
+    public:
+    JobSystem();
+    ~JobSystem();
+
+    void Startup( int numWorkerThreads ); // Negative uses one worker per extra hardware thread
+    void Shutdown();
+
+    int GetNumWorkerThreads() const;
+    void ParallelFor( int numJobs, JobFunction function, void* userData );
+
+    private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_workReady;
+    std::condition_variable m_workDone;
+
+    JobFunction m_function = nullptr;
+    void* m_userData = nullptr;
+    int m_numJobs = 0;
+    int m_nextJob = 0;
+    int m_numJobsDone = 0;
+    unsigned int m_batchIndex = 0;
+    bool m_isQuitting = false;
+
+    void WorkerMain();
+    bool RunNextJob(); // False once every job in the batch has been taken
+};
@@ -1,5 +1,6 @@
 #include "Engine/Core/StringUtils.hpp"
 #include <stdarg.h>
+#include <stdio.h>
 #include <cctype>
 
 
@@ -12,7 +13,11 @@ const std::string Stringf( const char* format, ... ) {
 	char textLiteral[STRINGF_STACK_LOCAL_TEMP_LENGTH];
 	va_list variableArgumentList;
 	va_start( variableArgumentList, format );
+#if defined( _WIN32 )
 	vsnprintf_s( textLiteral, STRINGF_STACK_LOCAL_TEMP_LENGTH, _TRUNCATE, format, variableArgumentList );
+#else
+	vsnprintf( textLiteral, STRINGF_STACK_LOCAL_TEMP_LENGTH, format, variableArgumentList );
+#endif
 	va_end( variableArgumentList );
 	textLiteral[STRINGF_STACK_LOCAL_TEMP_LENGTH - 1] = '\0'; // In case vsnprintf overran (doesn't auto-terminate)
 
@@ -29,7 +34,11 @@ const std::string Stringf( const int maxLength, const char* format, ... ) {
 
 	va_list variableArgumentList;
 	va_start( variableArgumentList, format );
+#if defined( _WIN32 )
 	vsnprintf_s( textLiteral, maxLength, _TRUNCATE, format, variableArgumentList );
+#else
+	vsnprintf( textLiteral, maxLength, format, variableArgumentList );
+#endif
 	va_end( variableArgumentList );
 	textLiteral[maxLength - 1] = '\0'; // In case vsnprintf overran (doesn't auto-terminate)
 
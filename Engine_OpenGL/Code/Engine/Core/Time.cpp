@@ -4,6 +4,8 @@
 
 //-----------------------------------------------------------------------------------------------
 #include "Engine/Core/Time.hpp"
+
+#if defined( _WIN32 )
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 
@@ -31,4 +33,16 @@ double GetCurrentTimeSeconds()
 	return currentSeconds;
 }
 
+#else
+#include <chrono>
+
+
+//-----------------------------------------------------------------------------------------------
+double GetCurrentTimeSeconds()
+{
+	static std::chrono::steady_clock::time_point initialTime = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsedSinceInitialTime = std::chrono::steady_clock::now() - initialTime;
+	return elapsedSinceInitialTime.count();
+}
 
+#endif
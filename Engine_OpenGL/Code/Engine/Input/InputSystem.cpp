@@ -12,6 +12,10 @@ void InputSystem::Shutdown() {
 
 
 void InputSystem::BeginFrame() {
+    if( m_isControllerPlayback ) {
+        return;
+    }
+
     for( int i = 0; i < MAX_CONTROLLERS; i++ ) {
         m_controllers[i].UpdateInput();
     }
@@ -26,3 +30,18 @@ void InputSystem::EndFrame() {
 const XboxController& InputSystem::GetController( int controllerID ) const {
     return m_controllers[controllerID];
 }
+
+
+void InputSystem::SetControllerPlayback( bool isPlayback ) {
+    m_isControllerPlayback = isPlayback;
+}
+
+
+bool InputSystem::IsControllerPlayback() const {
+    return m_isControllerPlayback;
+}
+
+
+void InputSystem::ApplyControllerState( int controllerID, const XboxControllerState& state ) {
+    m_controllers[controllerID].ApplyState( state );
+}
@@ -14,7 +14,14 @@ class InputSystem {
 
     const XboxController& GetController( int controllerID ) const;
 
+    // Playback stops BeginFrame from polling, controllers only change through ApplyControllerState
+    void SetControllerPlayback( bool isPlayback );
+    bool IsControllerPlayback() const;
+    void ApplyControllerState( int controllerID, const XboxControllerState& state );
+
     private:
+    bool m_isControllerPlayback = false;
+
     XboxController m_controllers[MAX_CONTROLLERS] = {
         XboxController( 0 ),
         XboxController( 1 ),
@@ -1,9 +1,31 @@
 #include "Engine/Input/XboxController.hpp"
 #include "Engine/Math/MathUtils.hpp"
+
+// #define ENGINE_DISABLE_INPUT in your game's Code/Game/EngineBuildPreferences.hpp to build without XInput
+#include "Game/EngineBuildPreferences.hpp"
+#if !defined( ENGINE_DISABLE_INPUT )
 #define WIN32_LEAN_AND_MEAN
 #include "Windows.h"
 #include "Xinput.h"
 #pragma comment( lib, "xinput9_1_0" )
+#endif
+
+
+bool XboxControllerState::operator==( const XboxControllerState& compare ) const {
+    return (isConnected == compare.isConnected &&
+        buttonFlags == compare.buttonFlags &&
+        leftTrigger == compare.leftTrigger &&
+        rightTrigger == compare.rightTrigger &&
+        leftStickX == compare.leftStickX &&
+        leftStickY == compare.leftStickY &&
+        rightStickX == compare.rightStickX &&
+        rightStickY == compare.rightStickY);
+}
+
+
+bool XboxControllerState::operator!=( const XboxControllerState& compare ) const {
+    return !(*this == compare);
+}
 
 
 XboxController::XboxController( int controllerID )
@@ -22,45 +44,81 @@ void XboxController::Shutdown() {
 
 
 void XboxController::UpdateInput() {
+    XboxControllerState state;
+
+#if !defined( ENGINE_DISABLE_INPUT )
     XINPUT_STATE xboxControllerState;
     memset( &xboxControllerState, 0, sizeof( xboxControllerState ) );
     DWORD errorStatus = XInputGetState( m_controllerID, &xboxControllerState );
 
     // Check connection status
-    if( errorStatus != ERROR_SUCCESS ) {
+    if( errorStatus == ERROR_SUCCESS ) {
+        // XInput flag for each simple button, in XboxButtonID order
+        static const unsigned short s_xinputButtonFlags[XBOX_BUTTON_ID_LTRIGGER] = {
+            XINPUT_GAMEPAD_A,
+            XINPUT_GAMEPAD_B,
+            XINPUT_GAMEPAD_X,
+            XINPUT_GAMEPAD_Y,
+            XINPUT_GAMEPAD_DPAD_UP,
+            XINPUT_GAMEPAD_DPAD_DOWN,
+            XINPUT_GAMEPAD_DPAD_LEFT,
+            XINPUT_GAMEPAD_DPAD_RIGHT,
+            XINPUT_GAMEPAD_BACK,
+            XINPUT_GAMEPAD_START,
+            XINPUT_GAMEPAD_LEFT_SHOULDER,
+            XINPUT_GAMEPAD_RIGHT_SHOULDER,
+            XINPUT_GAMEPAD_LEFT_THUMB,
+            XINPUT_GAMEPAD_RIGHT_THUMB
+        };
+
+        state.isConnected = true;
+        unsigned short keyStates = xboxControllerState.Gamepad.wButtons;
+
+        for( int buttonIndex = 0; buttonIndex < XBOX_BUTTON_ID_LTRIGGER; buttonIndex++ ) {
+            if( (keyStates & s_xinputButtonFlags[buttonIndex]) != 0 ) {
+                state.buttonFlags |= (unsigned short)(1 << buttonIndex);
+            }
+        }
+
+        state.leftTrigger = xboxControllerState.Gamepad.bLeftTrigger;
+        state.rightTrigger = xboxControllerState.Gamepad.bRightTrigger;
+        state.leftStickX = xboxControllerState.Gamepad.sThumbLX;
+        state.leftStickY = xboxControllerState.Gamepad.sThumbLY;
+        state.rightStickX = xboxControllerState.Gamepad.sThumbRX;
+        state.rightStickY = xboxControllerState.Gamepad.sThumbRY;
+    }
+#endif
+
+    ApplyState( state );
+}
+
+
+void XboxController::ApplyState( const XboxControllerState& state ) {
+    m_state = state;
+
+    // Check connection status
+    if( !state.isConnected ) {
         m_isConnected = false;
         Reset();
         return;
     }
 
     m_isConnected = true;
-    unsigned short keyStates = xboxControllerState.Gamepad.wButtons;
 
     // Update Buttons
-    m_buttons[XBOX_BUTTON_ID_A].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_A );
-    m_buttons[XBOX_BUTTON_ID_B].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_B );
-    m_buttons[XBOX_BUTTON_ID_X].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_X );
-    m_buttons[XBOX_BUTTON_ID_Y].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_Y );
-    m_buttons[XBOX_BUTTON_ID_DUP].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_DPAD_UP );
-    m_buttons[XBOX_BUTTON_ID_DDOWN].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_DPAD_DOWN );
-    m_buttons[XBOX_BUTTON_ID_DLEFT].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_DPAD_LEFT );
-    m_buttons[XBOX_BUTTON_ID_DRIGHT].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_DPAD_RIGHT );
-    m_buttons[XBOX_BUTTON_ID_SELECT].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_BACK );
-    m_buttons[XBOX_BUTTON_ID_START].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_START );
-    m_buttons[XBOX_BUTTON_ID_LBUMPER].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_LEFT_SHOULDER );
-    m_buttons[XBOX_BUTTON_ID_RBUMPER].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_RIGHT_SHOULDER );
-    m_buttons[XBOX_BUTTON_ID_LSTICK].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_LEFT_THUMB );
-    m_buttons[XBOX_BUTTON_ID_RSTICK].UpdateSimpleButton( keyStates, XINPUT_GAMEPAD_RIGHT_THUMB );
+    for( int buttonIndex = 0; buttonIndex < XBOX_BUTTON_ID_LTRIGGER; buttonIndex++ ) {
+        m_buttons[buttonIndex].UpdateSimpleButton( state.buttonFlags, (unsigned short)(1 << buttonIndex) );
+    }
 
     // Update Triggers
-    m_leftTrigger = RangeMapFloat( xboxControllerState.Gamepad.bLeftTrigger, 0, 255, 0, 1 );
-    m_rightTrigger = RangeMapFloat( xboxControllerState.Gamepad.bRightTrigger, 0, 255, 0, 1 );
+    m_leftTrigger = RangeMapFloat( state.leftTrigger, 0, 255, 0, 1 );
+    m_rightTrigger = RangeMapFloat( state.rightTrigger, 0, 255, 0, 1 );
     m_buttons[XBOX_BUTTON_ID_LTRIGGER].UpdateAnalogButton( m_leftTrigger );
     m_buttons[XBOX_BUTTON_ID_RTRIGGER].UpdateAnalogButton( m_rightTrigger );
 
     // Update Joysticks
-    m_leftJoystick.UpdateInput( Vec2( xboxControllerState.Gamepad.sThumbLX, xboxControllerState.Gamepad.sThumbLY ) );
-    m_rightJoystick.UpdateInput( Vec2( xboxControllerState.Gamepad.sThumbRX, xboxControllerState.Gamepad.sThumbRY ) );
+    m_leftJoystick.UpdateInput( Vec2( state.leftStickX, state.leftStickY ) );
+    m_rightJoystick.UpdateInput( Vec2( state.rightStickX, state.rightStickY ) );
 }
 
 
@@ -107,3 +165,8 @@ float XboxController::GetRightTrigger() const {
 const KeyButtonState& XboxController::GetKeyButtonState( XboxButtonID keyCode )  const {
     return m_buttons[keyCode];
 }
+
+
+const XboxControllerState& XboxController::GetState() const {
+    return m_state;
+}
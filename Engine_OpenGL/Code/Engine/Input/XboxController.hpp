@@ -31,6 +31,23 @@ enum XboxButtonID {
 };
 
 
+// Everything UpdateInput reads from the hardware in one poll
+// Apply the same sequence of states to get the same button edges and joystick values, used for input replays
+struct XboxControllerState {
+    bool isConnected = false;
+    unsigned short buttonFlags = 0; // Bit per XboxButtonID, triggers are derived from the trigger values
+    unsigned char leftTrigger = 0;
+    unsigned char rightTrigger = 0;
+    short leftStickX = 0;
+    short leftStickY = 0;
+    short rightStickX = 0;
+    short rightStickY = 0;
+
+    bool operator==( const XboxControllerState& compare ) const;
+    bool operator!=( const XboxControllerState& compare ) const;
+};
+
+
 class XboxController {
     public:
     explicit XboxController( int controllerID );
@@ -39,6 +56,7 @@ class XboxController {
 	void Shutdown();
 
     void UpdateInput();
+    void ApplyState( const XboxControllerState& state ); // Same as UpdateInput, but with a given state instead of polling
     void Reset();
 
     bool IsConnected() const;
@@ -48,10 +66,12 @@ class XboxController {
     float GetLeftTrigger() const;
     float GetRightTrigger() const;
     const KeyButtonState& GetKeyButtonState( XboxButtonID keyCode ) const;
+    const XboxControllerState& GetState() const;
 
     private:
     const int m_controllerID = -1;
     bool m_isConnected = false;
+    XboxControllerState m_state;
     AnalogJoystick m_leftJoystick = AnalogJoystick( 0.3f, 0.9f );
     AnalogJoystick m_rightJoystick = AnalogJoystick( 0.3f, 0.9f );
     KeyButtonState m_buttons[NUM_XBOX_BUTTON_IDS]{};
@@ -237,6 +237,132 @@ void PushDiscsOutOfEachOther( Vec2& centerA, float radiusA, Vec2& centerB, float
 }
 
 
+bool SweepDiscVsDisc( const Vec2& start, const Vec2& displacement, float radius, const Vec2& otherCenter, float otherRadius, float& out_impactFraction, Vec2& out_impactNormal ) {
+    float displacementLengthSquared = displacement.GetLengthSquared();
+    if( displacementLengthSquared <= 0.f ) {
+        return false;
+    }
+
+    float combinedRadii = radius + otherRadius;
+    Vec2 fromOther = start - otherCenter;
+    float fromOtherLengthSquared = fromOther.GetLengthSquared();
+    float projection = DotProduct( fromOther, displacement );
+
+    if( fromOtherLengthSquared < (combinedRadii * combinedRadii) ) {
+        Vec2 normal = (fromOtherLengthSquared > 0.f) ? fromOther.GetNormalized() : (displacement.GetNormalized() * -1.f);
+        if( DotProduct( displacement, normal ) >= 0.f ) {
+            return false;
+        }
+
+        out_impactFraction = 0.f;
+        out_impactNormal = normal;
+        return true;
+    }
+
+    if( projection >= 0.f ) {
+        return false; // Moving away
+    }
+
+    // Solve |fromOther + t * displacement| = combinedRadii for the first t
+    float discriminant = (projection * projection) - (displacementLengthSquared * (fromOtherLengthSquared - (combinedRadii * combinedRadii)));
+    if( discriminant < 0.f ) {
+        return false;
+    }
+
+    float fraction = (-projection - sqrtf( discriminant )) / displacementLengthSquared;
+    if( fraction > 1.f ) {
+        return false;
+    }
+
+    fraction = (fraction > 0.f) ? fraction : 0.f;
+    out_impactFraction = fraction;
+    out_impactNormal = (fromOther + (displacement * fraction)).GetNormalized();
+    return true;
+}
+
+
+bool SweepDiscVsAABB2( const Vec2& start, const Vec2& displacement, float radius, const AABB2& aabb2, float& out_impactFraction, Vec2& out_impactNormal ) {
+    if( displacement.GetLengthSquared() <= 0.f ) {
+        return false;
+    }
+
+    Vec2 fromBox = start - aabb2.GetClosestPointOnAABB2( start );
+    float fromBoxLengthSquared = fromBox.GetLengthSquared();
+
+    if( fromBoxLengthSquared < (radius * radius) ) {
+        Vec2 normal = (fromBoxLengthSquared > 0.f) ? fromBox.GetNormalized() : (displacement.GetNormalized() * -1.f);
+        if( DotProduct( displacement, normal ) >= 0.f ) {
+            return false;
+        }
+
+        out_impactFraction = 0.f;
+        out_impactNormal = normal;
+        return true;
+    }
+
+    // Disc center against the box grown by radius, one slab per axis
+    const float starts[2] = { start.x, start.y };
+    const float displacements[2] = { displacement.x, displacement.y };
+    const float mins[2] = { aabb2.mins.x - radius, aabb2.mins.y - radius };
+    const float maxs[2] = { aabb2.maxs.x + radius, aabb2.maxs.y + radius };
+
+    float entryFraction = 0.f;
+    float exitFraction = 1.f;
+    int entryAxis = -1;
+
+    for( int axis = 0; axis < 2; axis++ ) {
+        if( displacements[axis] == 0.f ) {
+            if( starts[axis] < mins[axis] || starts[axis] > maxs[axis] ) {
+                return false;
+            }
+
+            continue;
+        }
+
+        float nearFraction = (mins[axis] - starts[axis]) / displacements[axis];
+        float farFraction = (maxs[axis] - starts[axis]) / displacements[axis];
+
+        if( nearFraction > farFraction ) {
+            float swapFraction = nearFraction;
+            nearFraction = farFraction;
+            farFraction = swapFraction;
+        }
+
+        if( nearFraction > entryFraction ) {
+            entryFraction = nearFraction;
+            entryAxis = axis;
+        }
+
+        exitFraction = (farFraction < exitFraction) ? farFraction : exitFraction;
+
+        if( entryFraction > exitFraction ) {
+            return false;
+        }
+    }
+
+    // Grown box corners are really rounded, hits there are against the original box's corner
+    Vec2 entryPosition = start + (displacement * entryFraction);
+    bool isOutsideX = (entryPosition.x < aabb2.mins.x) || (entryPosition.x > aabb2.maxs.x);
+    bool isOutsideY = (entryPosition.y < aabb2.mins.y) || (entryPosition.y > aabb2.maxs.y);
+
+    if( entryAxis < 0 || (isOutsideX && isOutsideY) ) {
+        Vec2 corner = aabb2.GetClosestPointOnAABB2( entryPosition );
+        return SweepDiscVsDisc( start, displacement, radius, corner, 0.f, out_impactFraction, out_impactNormal );
+    }
+
+    out_impactFraction = entryFraction;
+    out_impactNormal = Vec2::ZERO;
+
+    if( entryAxis == 0 ) {
+        out_impactNormal.x = (displacement.x > 0.f) ? -1.f : 1.f;
+    } else {
+        out_impactNormal.y = (displacement.y > 0.f) ? -1.f : 1.f;
+    }
+
+    return true;
+}
+
+
 float DotProduct( const Vec2& vecA, const Vec2& vecB ) {
     return (
         (vecA.x * vecB.x) +
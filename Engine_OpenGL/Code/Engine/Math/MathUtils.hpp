@@ -49,6 +49,12 @@ void PushDiscOutOfAABB2( Vec2& discCenter, float discRadius, const AABB2& aabb2
 void PushDiscOutOfDisc( Vec2& discCenterToPush, float discRadiusA, const Vec2& discCenterToPushOutOf, float discRadiusB );
 void PushDiscsOutOfEachOther( Vec2& centerA, float radiusA, Vec2& centerB, float radiusB );
 
+// Swept Disc Physics
+// Moves a disc along displacement, out_impactFraction is how much of it happens before first contact,
+//  out_impactNormal points from the obstacle to the disc. Already touching only hits when moving further in
+bool SweepDiscVsDisc( const Vec2& start, const Vec2& displacement, float radius, const Vec2& otherCenter, float otherRadius, float& out_impactFraction, Vec2& out_impactNormal );
+bool SweepDiscVsAABB2( const Vec2& start, const Vec2& displacement, float radius, const AABB2& aabb2, float& out_impactFraction, Vec2& out_impactNormal );
+
 
 // Dot Products
 float DotProduct( const Vec2& vecA, const Vec2& vecB );
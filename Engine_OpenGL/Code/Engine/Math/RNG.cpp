@@ -27,6 +27,16 @@ void RNG::SetPosition( unsigned int position ) {
 }
 
 
+unsigned int RNG::GetSeed() const {
+    return m_seed;
+}
+
+
+unsigned int RNG::GetPosition() const {
+    return m_position;
+}
+
+
 int RNG::GetRandomIntLessThan( int maxNotInclusive ) {
     unsigned int random = Get1dNoiseUint( m_position++, m_seed );
     return random % maxNotInclusive;
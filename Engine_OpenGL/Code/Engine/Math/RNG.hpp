@@ -12,6 +12,9 @@ class RNG {
     void SetSeed( unsigned int seed );
     void SetPosition( unsigned int position );
 
+    unsigned int GetSeed() const;
+    unsigned int GetPosition() const;
+
     int GetRandomIntLessThan( int maxNotInclusive );
     int GetRandomIntInRange( int minInclusive, int maxInclusive );
     int GetRandomIntInRange( IntRange rangeInclusive );
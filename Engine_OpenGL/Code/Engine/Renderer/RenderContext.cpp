@@ -1,11 +1,19 @@
 #include "Engine/Renderer/RenderContext.hpp"
 
+//-----------------------------------------------------------------------------------------------
+// #define ENGINE_DISABLE_RENDERING in your game's Code/Game/EngineBuildPreferences.hpp to build
+//	without OpenGL. Textures and fonts still load on the CPU so sprite UVs and text layout work,
+//	but nothing is uploaded or drawn.
+#include "Game/EngineBuildPreferences.hpp"
+#if !defined( ENGINE_DISABLE_RENDERING )
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <gl/gl.h>
 #pragma comment( lib, "opengl32" )	// Link in the OpenGL32.lib static library
+#endif
 
 #include "Engine/Core/DevConsole.hpp"
+#include "Engine/Math/Matrix44.hpp"
 #include "Engine/Renderer/BitmapFont.hpp"
 #include "Engine/Renderer/Texture.hpp"
 
@@ -15,8 +23,10 @@ void RenderContext::Startup() {
     m_consoleChannel |= DevConsole::CHANNEL_INFO;
 
     g_theDevConsole->PrintString( "(Renderer) Startup Begun...", Rgba::MAGENTA, m_consoleChannel );
+#if !defined( ENGINE_DISABLE_RENDERING )
 	glEnable( GL_BLEND );
 	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+#endif
     g_theDevConsole->PrintString( "(Renderer) Startup Complete", Rgba::MAGENTA, m_consoleChannel );
 }
 
@@ -67,12 +77,16 @@ Texture* RenderContext::CreateOrGetTextureFromFile( const char* imageFilePath )
 
 
 void RenderContext::BindTexture( const Texture* texture ) const {
+#if !defined( ENGINE_DISABLE_RENDERING )
     if( texture ) {
         glEnable( GL_TEXTURE_2D );
         glBindTexture( GL_TEXTURE_2D, texture->GetTextureID() );
     } else {
         glDisable( GL_TEXTURE_2D );
     }
+#else
+    UNUSED( texture );
+#endif
 }
 
 
@@ -88,9 +102,13 @@ BitmapFont* RenderContext::CreateOrGetBitmapFontFromFile( const char* fontName )
 
 
 void RenderContext::ClearScreen( const Rgba& clearColor ) {
+#if !defined( ENGINE_DISABLE_RENDERING )
 	// Clear all screen (back buffer) pixels to black
 	glClearColor( clearColor.r, clearColor.g, clearColor.b, clearColor.a );
 	glClear( GL_COLOR_BUFFER_BIT );
+#else
+	UNUSED( clearColor );
+#endif
 }
 
 
@@ -98,8 +116,10 @@ void RenderContext::BeginCamera( const Camera& camera ) {
 	currentCameraBottomLeft = camera.GetOrthoBottomLeft();
 	currentCameraTopRight = camera.GetOrthoTopRight();
 
+#if !defined( ENGINE_DISABLE_RENDERING )
 	glLoadIdentity();
 	glOrtho( currentCameraBottomLeft.x, currentCameraTopRight.x, currentCameraBottomLeft.y, currentCameraTopRight.y, 0.f, 1.f );
+#endif
 }
 
 
@@ -108,7 +128,19 @@ void RenderContext::EndCamera( const Camera& camera ) {
 }
 
 
+void RenderContext::SetModelMatrix( const Matrix44& modelMatrix ) {
+#if !defined( ENGINE_DISABLE_RENDERING )
+	glLoadIdentity();
+	glOrtho( currentCameraBottomLeft.x, currentCameraTopRight.x, currentCameraBottomLeft.y, currentCameraTopRight.y, 0.f, 1.f );
+	glMultMatrixf( modelMatrix.m_values ); // Basis-major matches GL's column-major layout
+#else
+	UNUSED( modelMatrix );
+#endif
+}
+
+
 void RenderContext::DrawVertexArray( int numVertexes, const Vertex_PCU* vertexes, DrawMode mode /*= DRAW_MODE_MULTIPLICATIVE*/ ) {
+#if !defined( ENGINE_DISABLE_RENDERING )
 	const Vertex_PCU* vert;
 
     switch( mode ) {
@@ -129,10 +161,15 @@ void RenderContext::DrawVertexArray( int numVertexes, const Vertex_PCU* vertexes
 		glVertex2f( vert->m_position.x, vert->m_position.y );
 	}
 	glEnd();
+#else
+	UNUSED( numVertexes );
+	UNUSED( vertexes );
+	UNUSED( mode );
+#endif
 }
 
 
-void RenderContext::DrawVertexArray( std::vector<Vertex_PCU> vertexes, DrawMode mode /*= DRAW_MODE_MULTIPLICATIVE*/ ) {
+void RenderContext::DrawVertexArray( const std::vector<Vertex_PCU>& vertexes, DrawMode mode /*= DRAW_MODE_MULTIPLICATIVE*/ ) {
     int size = (int)vertexes.size();
     const Vertex_PCU* data = vertexes.data();
     DrawVertexArray( size, data, mode );
@@ -145,6 +182,7 @@ Texture* RenderContext::CreateTextureFromFile( const char* imageFilePath ) {
     Texture* newTexture = new Texture( imageFilePath );
     m_loadedTextures.insert( { imageFilePath, newTexture } );
 
+#if !defined( ENGINE_DISABLE_RENDERING )
     int imageTexelSizeX = newTexture->m_dimensions.x;
     int imageTexelSizeY = newTexture->m_dimensions.y;
     unsigned char* imageData = newTexture->m_image->GetRawData();
@@ -185,6 +223,7 @@ Texture* RenderContext::CreateTextureFromFile( const char* imageFilePath ) {
         bufferFormat,		// Pixel format describing the composition of the pixel data in buffer
         GL_UNSIGNED_BYTE,	// Pixel color components are unsigned bytes (one byte per color channel/component)
         imageData );		// Address of the actual pixel data bytes/buffer in system memory
+#endif
 
     return newTexture;
 }
@@ -13,6 +13,7 @@ enum DrawMode {
 
 class Texture;
 class BitmapFont;
+struct Matrix44;
 
 class RenderContext {
 	public:
@@ -30,8 +31,9 @@ class RenderContext {
 	void ClearScreen( const Rgba& clearColor );
 	void BeginCamera( const Camera& camera );
 	void EndCamera( const Camera& camera );
+	void SetModelMatrix( const Matrix44& modelMatrix ); // Applied to everything drawn until the next call or BeginCamera
 	void DrawVertexArray( int numVertexes, const Vertex_PCU* vertexes, DrawMode mode = DRAW_MODE_ALPHA );
-    void DrawVertexArray( std::vector<Vertex_PCU> vertexes, DrawMode mode = DRAW_MODE_ALPHA );
+    void DrawVertexArray( const std::vector<Vertex_PCU>& vertexes, DrawMode mode = DRAW_MODE_ALPHA );
 
 	Vec2 currentCameraBottomLeft;
 	Vec2 currentCameraTopRight;
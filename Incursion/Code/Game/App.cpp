@@ -1,6 +1,8 @@
 #include "Game/App.hpp"
 
 #include "Engine/Audio/AudioSystem.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Core/Time.hpp"
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Math/MathUtils.hpp"
@@ -16,6 +18,7 @@ Game* g_theGame;
 RenderContext* g_theRenderer;
 InputSystem* g_theInput;
 AudioSystem* g_theAudio;
+JobSystem* g_theJobSystem;
 RNG* g_RNG;
 
 App::App() {
@@ -31,6 +34,19 @@ App::~App() {
 void App::Startup() {
     g_RNG = new RNG();
 
+    int tickRate = g_theGameConfigBlackboard.GetValue( "tickRate", APP_DEFAULT_TICK_RATE );
+    GUARANTEE_OR_DIE( tickRate > 0, Stringf( "tickRate (%d) must be positive", tickRate ) );
+    m_tickSeconds = 1.f / (float)tickRate;
+    m_tickAccumulatorSeconds = 0.f;
+    m_tickAlpha = 1.f;
+
+    m_replayTicksPerFrame = g_theGameConfigBlackboard.GetValue( "replayTicksPerFrame", APP_DEFAULT_REPLAY_TICKS_PER_FRAME );
+    GUARANTEE_OR_DIE( m_replayTicksPerFrame > 0, Stringf( "replayTicksPerFrame (%d) must be positive", m_replayTicksPerFrame ) );
+
+    int numWorkerThreads = g_theGameConfigBlackboard.GetValue( "workerThreads", APP_DEFAULT_WORKER_THREADS );
+    g_theJobSystem = new JobSystem();
+    g_theJobSystem->Startup( numWorkerThreads );
+
 	g_theRenderer = new RenderContext();
 	g_theRenderer->Startup();
 
@@ -62,6 +78,10 @@ void App::Shutdown() {
 	delete g_theRenderer;
 	g_theRenderer = nullptr;
 
+    g_theJobSystem->Shutdown();
+    delete g_theJobSystem;
+    g_theJobSystem = nullptr;
+
     delete g_RNG;
     g_RNG = nullptr;
 }
@@ -76,14 +96,12 @@ void App::RunFrame() {
 
 
 void App::BeginFrame() {
-    g_theInput->BeginFrame();
 	g_theRenderer->BeginFrame();
     g_theAudio->BeginFrame();
 }
 
 
 void App::EndFrame() {
-    g_theInput->EndFrame();
 	g_theRenderer->EndFrame();
     g_theAudio->EndFrame();
 }
@@ -101,14 +119,46 @@ void App::Update() {
         deltaSeconds *= 4.f;
     }
 
-	g_theGame->Update( deltaSeconds );
+    // Simulation always steps by m_tickSeconds, rendering blends by whatever is left over
+    m_tickAccumulatorSeconds += deltaSeconds;
+    int maxTicks = APP_MAX_TICKS_PER_FRAME;
+
+    if( g_theGame->GetInputReplay().IsReplaying() ) {
+        // Faster than real time, a fixed number of ticks every frame (the extra half tick absorbs float error)
+        maxTicks = m_replayTicksPerFrame;
+        m_tickAccumulatorSeconds = m_tickSeconds * ((float)maxTicks + 0.5f);
+    }
+
+    int numTicks = 0;
+
+    while( m_tickAccumulatorSeconds >= m_tickSeconds ) {
+        if( numTicks == maxTicks ) {
+            // Can't keep up, drop the backlog instead of spiraling
+            m_tickAccumulatorSeconds = fmodf( m_tickAccumulatorSeconds, m_tickSeconds );
+            break;
+        }
+
+        UpdateTick();
+        m_tickAccumulatorSeconds -= m_tickSeconds;
+        numTicks++;
+    }
+
+    m_tickAlpha = m_tickAccumulatorSeconds / m_tickSeconds;
+}
+
+
+void App::UpdateTick() {
+    // Input is sampled once per tick so presses aren't doubled or lost when a frame runs several ticks or none
+    g_theInput->BeginFrame();
+	g_theGame->Update( m_tickSeconds );
+    g_theInput->EndFrame();
 }
 
 
 void App::Render() const {
 	g_theRenderer->ClearScreen( Rgba( 0.f, 0.f, 0.f, 1.f ) );
 
-	g_theGame->Render();
+	g_theGame->Render( m_tickAlpha );
 }
 
 
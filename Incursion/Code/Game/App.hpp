@@ -20,11 +20,16 @@ class App {
 	private:
 	void BeginFrame();
 	void Update();
+	void UpdateTick();
 	void Render() const;
 	void EndFrame();
 
 	private:
     double m_timeLastFrame = 0.0;
+    float m_tickSeconds = 1.f / (float)APP_DEFAULT_TICK_RATE;
+    float m_tickAccumulatorSeconds = 0.f;
+    float m_tickAlpha = 1.f; // Fraction of a tick left in the accumulator, used to interpolate rendering
+    int m_replayTicksPerFrame = APP_DEFAULT_REPLAY_TICKS_PER_FRAME;
 
 	bool m_isQuitting = false;
 	bool m_isSlowMo = false;
@@ -0,0 +1,876 @@
+#include "Game/Benchmark.hpp"
+
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Matrix44.hpp"
+#include "Engine/Math/RNG.hpp"
+#include "Engine/Renderer/RenderContext.hpp"
+
+#include "Game/Boulder.hpp"
+#include "Game/EnemyTank.hpp"
+#include "Game/EnemyTurret.hpp"
+#include "Game/EntityComponents.hpp"
+#include "Game/FlowField.hpp"
+#include "Game/GridPathfinder.hpp"
+#include "Game/Map.hpp"
+#include "Game/ParticleSystem.hpp"
+#include "Game/PlayerTank.hpp"
+#include "Game/RaycastResult.hpp"
+#include "Game/StateHash.hpp"
+
+
+const std::string BenchmarkResult::GetReport() const {
+    double baselineMS = (baselineSeconds * 1000.0) / (double)numIterations;
+    double optimizedMS = (optimizedSeconds * 1000.0) / (double)numIterations;
+    double speedup = (optimizedSeconds > 0.0) ? (baselineSeconds / optimizedSeconds) : 0.0;
+
+    std::string report;
+    if( baselineName.empty() ) {
+        report = Stringf( "%s x%d: %s %.3fms", name.c_str(), workPerIteration, optimizedName.c_str(), optimizedMS );
+    } else {
+        report = Stringf( "%s x%d: %s %.3fms, %s %.3fms (%.2fx)", name.c_str(), workPerIteration, baselineName.c_str(), baselineMS, optimizedName.c_str(), optimizedMS, speedup );
+    }
+
+    if( !details.empty() ) {
+        report += ", " + details;
+    }
+
+    return report;
+}
+
+
+const BenchmarkResult RunRaycastBenchmark( const Map& map, int numRays /*= BENCHMARK_RAYCAST_NUM_RAYS*/, int numIterations /*= BENCHMARK_NUM_ITERATIONS*/ ) {
+    // Own RNG so running the benchmark doesn't change the game's random sequence
+    RNG rng( BENCHMARK_RNG_SEED );
+    IntVec2 dimensions = map.GetDimensions();
+
+    std::vector<RayQuery> queries( numRays );
+    std::vector<RaycastResult> scalarResults( numRays );
+    std::vector<RaycastResult> batchedResults( numRays );
+
+    for( int rayIndex = 0; rayIndex < numRays; rayIndex++ ) {
+        RayQuery& query = queries[rayIndex];
+        query.startPosition.x = rng.GetRandomFloatInRange( 0.f, (float)dimensions.x );
+        query.startPosition.y = rng.GetRandomFloatInRange( 0.f, (float)dimensions.y );
+        query.normalizedDirection = Vec2::MakeFromPolarDegrees( rng.GetRandomFloatInRange( 0.f, 360.f ) );
+        query.maxDistance = MAP_RAYCAST_MAX_DISTANCE;
+    }
+
+    BenchmarkResult result;
+    result.name = "Raycast";
+    result.baselineName = "scalar";
+    result.optimizedName = "batched";
+    result.workPerIteration = numRays;
+    result.numIterations = numIterations;
+
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int iteration = 0; iteration < numIterations; iteration++ ) {
+        for( int rayIndex = 0; rayIndex < numRays; rayIndex++ ) {
+            const RayQuery& query = queries[rayIndex];
+            scalarResults[rayIndex] = map.Raycast( query.startPosition, query.normalizedDirection, query.maxDistance );
+        }
+    }
+
+    result.baselineSeconds = GetCurrentTimeSeconds() - startTime;
+    startTime = GetCurrentTimeSeconds();
+
+    for( int iteration = 0; iteration < numIterations; iteration++ ) {
+        map.RaycastBatch( numRays, queries.data(), batchedResults.data() );
+    }
+
+    result.optimizedSeconds = GetCurrentTimeSeconds() - startTime;
+
+    int numMismatches = 0;
+    for( int rayIndex = 0; rayIndex < numRays; rayIndex++ ) {
+        const RaycastResult& scalar = scalarResults[rayIndex];
+        const RaycastResult& batched = batchedResults[rayIndex];
+
+        if( scalar.didImpact != batched.didImpact || scalar.impactTile != batched.impactTile || scalar.impactDistance != batched.impactDistance ) {
+            numMismatches++;
+        }
+    }
+
+    GUARANTEE_RECOVERABLE( numMismatches == 0, Stringf( "RaycastBatch disagreed with Raycast on %d of %d rays", numMismatches, numRays ) );
+    return result;
+}
+
+
+const BenchmarkResult RunMapBuildBenchmark( int mapSize /*= BENCHMARK_MAP_BUILD_SIZE*/, int numIterations /*= BENCHMARK_MAP_BUILD_NUM_ITERATIONS*/ ) {
+    std::map<TileType, float> tileFractions = {
+        { TILE_TYPE_STONE, MAP_STONE_TILES_FRACTION },
+        { TILE_TYPE_MUD, 0.1f }
+    };
+    std::map<EntityType, int> numEntities = {}; // Only timing the map itself, players join on the first Update
+    Map map( IntVec2( mapSize, mapSize ), TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntities, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+
+    int numTiles = mapSize * mapSize;
+    size_t tileMemoryBytes = 0;
+
+    BenchmarkResult result;
+    result.name = Stringf( "Map Build %dx%d", mapSize, mapSize );
+    result.optimizedName = "build";
+    result.workPerIteration = numTiles;
+    result.numIterations = numIterations;
+
+    // One player camera's view in the middle of the map, so the mesh chunks it needs are built and counted
+    Vec2 viewCenter( 0.5f * (float)mapSize, 0.5f * (float)mapSize );
+    Vec2 viewHalfDimensions( 0.5f * CAMERA_PLAYER_WIDTH, 0.5f * CAMERA_PLAYER_HEIGHT );
+    AABB2 viewBounds( viewCenter - viewHalfDimensions, viewCenter + viewHalfDimensions );
+
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int iteration = 0; iteration < numIterations; iteration++ ) {
+        map.Startup();
+        map.Render( viewBounds );
+        tileMemoryBytes = map.GetTileMemoryBytes();
+        map.Shutdown();
+    }
+
+    result.optimizedSeconds = GetCurrentTimeSeconds() - startTime;
+
+    double bytesPerTile = (double)tileMemoryBytes / (double)numTiles;
+    double megabytes = (double)tileMemoryBytes / (1024.0 * 1024.0);
+    result.details = Stringf( "Map::Startup, %.2f bytes/tile (%.1fMB)", bytesPerTile, megabytes );
+    return result;
+}
+
+
+const BenchmarkResult RunParticleBenchmark( int numParticles /*= BENCHMARK_PARTICLES_NUM_PARTICLES*/, int numFrames /*= BENCHMARK_PARTICLES_NUM_FRAMES*/ ) {
+    RNG rng( BENCHMARK_RNG_SEED );
+    float deltaSeconds = 1.f / 60.f;
+    float benchmarkSeconds = deltaSeconds * (float)numFrames;
+
+    ParticleSystem particles;
+    particles.Startup();
+
+    // Outlive the benchmark so every frame updates the full count
+    for( int particleIndex = 0; particleIndex < numParticles; particleIndex++ ) {
+        Vec2 position( rng.GetRandomFloatInRange( 0.f, 100.f ), rng.GetRandomFloatInRange( 0.f, 100.f ) );
+        float duration = benchmarkSeconds + rng.GetRandomFloatInRange( 1.f, 2.f );
+        particles.SpawnParticle( position, EXPLOSION_SCALE_LARGE, duration );
+    }
+
+    BenchmarkResult result;
+    result.name = "Explosion Particles";
+    result.optimizedName = "update";
+    result.workPerIteration = numParticles;
+    result.numIterations = numFrames;
+
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int frameIndex = 0; frameIndex < numFrames; frameIndex++ ) {
+        particles.Update( deltaSeconds );
+    }
+
+    result.optimizedSeconds = GetCurrentTimeSeconds() - startTime;
+
+    int numAlive = particles.GetNumParticles();
+    particles.Shutdown();
+
+    double frameBudgetMS = 1000.0 / 60.0;
+    double frameMS = (result.optimizedSeconds * 1000.0) / (double)numFrames;
+    result.details = Stringf( "%.1f%% of 60Hz frame, %d alive", 100.0 * frameMS / frameBudgetMS, numAlive );
+    return result;
+}
+
+
+const BenchmarkResult RunSnapshotBenchmark( int numEntities /*= BENCHMARK_SNAPSHOT_NUM_ENTITIES*/, int numIterations /*= BENCHMARK_NUM_ITERATIONS*/ ) {
+    std::map<TileType, float> tileFractions = {
+        { TILE_TYPE_STONE, MAP_STONE_TILES_FRACTION }
+    };
+
+    int numEnemies = numEntities / 3;
+    std::map<EntityType, int> numEntitiesByType = {
+        { ENTITY_TYPE_ENEMYTANK, numEnemies },
+        { ENTITY_TYPE_ENEMYTURRET, numEnemies },
+        { ENTITY_TYPE_BOULDER, numEntities - (2 * numEnemies) }
+    };
+
+    IntVec2 dimensions( BENCHMARK_SNAPSHOT_MAP_SIZE, BENCHMARK_SNAPSHOT_MAP_SIZE );
+    Map map( dimensions, TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntitiesByType, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+    map.Startup();
+
+    // Explosions in flight are part of the snapshot too
+    RNG rng( BENCHMARK_RNG_SEED );
+    for( int explosionIndex = 0; explosionIndex < numEntities / 10; explosionIndex++ ) {
+        Vec2 position( rng.GetRandomFloatInRange( 0.f, (float)dimensions.x ), rng.GetRandomFloatInRange( 0.f, (float)dimensions.y ) );
+        map.SpawnNewExplosion( position, EXPLOSION_SCALE_LARGE );
+    }
+
+    unsigned int savedHash = map.ComputeStateHash();
+    ByteBuffer snapshot;
+
+    BenchmarkResult result;
+    result.name = "Map Snapshot";
+    result.optimizedName = "save";
+    result.workPerIteration = map.GetNumEntities();
+    result.numIterations = numIterations;
+
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int iteration = 0; iteration < numIterations; iteration++ ) {
+        map.SaveSnapshot( snapshot );
+    }
+
+    result.optimizedSeconds = GetCurrentTimeSeconds() - startTime;
+    startTime = GetCurrentTimeSeconds();
+
+    bool didRestore = true;
+    for( int iteration = 0; iteration < numIterations; iteration++ ) {
+        didRestore = map.RestoreSnapshot( snapshot ) && didRestore;
+    }
+
+    double restoreSeconds = GetCurrentTimeSeconds() - startTime;
+    unsigned int restoredHash = map.ComputeStateHash();
+    map.Shutdown();
+
+    GUARANTEE_RECOVERABLE( didRestore && restoredHash == savedHash, Stringf( "Map snapshot restored to state %08x, saved from %08x", restoredHash, savedHash ) );
+
+    double restoreMS = (restoreSeconds * 1000.0) / (double)numIterations;
+    double kilobytes = (double)snapshot.size() / 1024.0;
+    result.details = Stringf( "restore %.3fms, %.1fKB", restoreMS, kilobytes );
+    return result;
+}
+
+
+static double RunUpdateTicks( int numEntities, int numTicks, double& out_entityPhaseSeconds, unsigned int& out_stateHash ) {
+    std::map<TileType, float> tileFractions = {
+        { TILE_TYPE_STONE, MAP_STONE_TILES_FRACTION }
+    };
+
+    int numEnemies = numEntities / 3;
+    std::map<EntityType, int> numEntitiesByType = {
+        { ENTITY_TYPE_ENEMYTANK, numEnemies },
+        { ENTITY_TYPE_ENEMYTURRET, numEnemies },
+        { ENTITY_TYPE_BOULDER, numEntities - (2 * numEnemies) }
+    };
+
+    IntVec2 dimensions( BENCHMARK_UPDATE_MAP_SIZE, BENCHMARK_UPDATE_MAP_SIZE );
+    Map map( dimensions, TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntitiesByType, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+    map.Startup();
+    map.ResetPhaseTimings();
+
+    float deltaSeconds = 1.f / (float)APP_DEFAULT_TICK_RATE;
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int tickIndex = 0; tickIndex < numTicks; tickIndex++ ) {
+        map.Update( deltaSeconds );
+    }
+
+    double seconds = GetCurrentTimeSeconds() - startTime;
+    out_entityPhaseSeconds = map.GetPhaseSeconds( MAP_PHASE_ENTITIES );
+    out_stateHash = map.ComputeStateHash();
+    map.Shutdown();
+
+    return seconds;
+}
+
+
+const BenchmarkResult RunParallelUpdateBenchmark( int numEntities /*= BENCHMARK_UPDATE_NUM_ENTITIES*/, int numTicks /*= BENCHMARK_UPDATE_NUM_TICKS*/ ) {
+    BenchmarkResult result;
+    result.name = "Map Update";
+    result.workPerIteration = numEntities;
+    result.numIterations = numTicks;
+
+    if( g_theJobSystem->GetNumWorkerThreads() == 0 ) {
+        // Serial against serial compares nothing, just time the one run
+        double entitySeconds = 0.0;
+        unsigned int stateHash = 0;
+        result.optimizedName = "1 thread";
+        result.optimizedSeconds = RunUpdateTicks( numEntities, numTicks, entitySeconds, stateHash );
+        result.details = Stringf( "entity phase %.3fms, no worker threads so no parallel comparison", (entitySeconds * 1000.0) / (double)numTicks );
+        return result;
+    }
+
+    result.baselineName = "1 thread";
+    result.optimizedName = Stringf( "%d threads", g_theJobSystem->GetNumWorkerThreads() + 1 );
+
+    // Same map and ticks with no workers, then with the game's workers
+    JobSystem* gameJobSystem = g_theJobSystem;
+    JobSystem serialJobSystem;
+    serialJobSystem.Startup( 0 );
+    g_theJobSystem = &serialJobSystem;
+
+    double serialEntitySeconds = 0.0;
+    unsigned int serialHash = 0;
+    result.baselineSeconds = RunUpdateTicks( numEntities, numTicks, serialEntitySeconds, serialHash );
+
+    g_theJobSystem = gameJobSystem;
+    serialJobSystem.Shutdown();
+
+    double parallelEntitySeconds = 0.0;
+    unsigned int parallelHash = 0;
+    result.optimizedSeconds = RunUpdateTicks( numEntities, numTicks, parallelEntitySeconds, parallelHash );
+
+    GUARANTEE_RECOVERABLE( parallelHash == serialHash, Stringf( "Parallel map update ended in state %08x, serial in %08x", parallelHash, serialHash ) );
+
+    // Only the entity phase runs in parallel, raycasts and collision are still serial
+    double serialEntityMS = (serialEntitySeconds * 1000.0) / (double)numTicks;
+    double parallelEntityMS = (parallelEntitySeconds * 1000.0) / (double)numTicks;
+    result.details = Stringf( "entity phase %.3fms -> %.3fms", serialEntityMS, parallelEntityMS );
+    return result;
+}
+
+
+// Before the component stores, every read in the collision pass went through the entity pointer,
+//  and position, radius and flags sat on two cache lines of the object
+static constexpr int ENTITY_OBJECT_BYTES_PER_READ = sizeof( Entity* ) + (2 * 64);
+
+
+const BenchmarkResult RunComponentBenchmark( int numEntities /*= BENCHMARK_COMPONENTS_NUM_ENTITIES*/, int numTicks /*= BENCHMARK_COMPONENTS_NUM_TICKS*/ ) {
+    BenchmarkResult result;
+    result.name = "Entity Components";
+    result.optimizedName = "update";
+    result.workPerIteration = numEntities;
+    result.numIterations = numTicks;
+
+    std::map<TileType, float> tileFractions = {
+        { TILE_TYPE_STONE, MAP_STONE_TILES_FRACTION }
+    };
+
+    int numEnemies = numEntities / 3;
+    std::map<EntityType, int> numEntitiesByType = {
+        { ENTITY_TYPE_ENEMYTANK, numEnemies },
+        { ENTITY_TYPE_ENEMYTURRET, numEnemies },
+        { ENTITY_TYPE_BOULDER, numEntities - (2 * numEnemies) }
+    };
+
+    IntVec2 dimensions( BENCHMARK_UPDATE_MAP_SIZE, BENCHMARK_UPDATE_MAP_SIZE );
+    Map map( dimensions, TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntitiesByType, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+    map.Startup();
+    map.ResetPhaseTimings();
+
+    // Collision reads per pass: flags, position and sleep state for the tile test, flags, disc and faction for the broadphase,
+    //  flags and disc of both entities for every candidate pair, then positions again to update sleep state
+    size_t tileBytesPerEntity = sizeof( EntityComponentRef ) + (2 * sizeof( bool )) + (2 * sizeof( Vec2 )) + sizeof( int );
+    size_t broadphaseBytesPerEntity = sizeof( EntityComponentRef ) + (2 * sizeof( bool )) + sizeof( Vec2 ) + sizeof( float ) + sizeof( FactionID ) + sizeof( int );
+    size_t sleepBytesPerEntity = sizeof( EntityComponentRef ) + (2 * sizeof( Vec2 ));
+    size_t bytesPerPairSide = (2 * sizeof( bool )) + sizeof( Vec2 ) + sizeof( float );
+
+    double componentBytes = 0.0;
+    double entityObjectBytes = 0.0;
+    double numEntityUpdates = 0.0;
+
+    float deltaSeconds = 1.f / (float)APP_DEFAULT_TICK_RATE;
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int tickIndex = 0; tickIndex < numTicks; tickIndex++ ) {
+        map.Update( deltaSeconds );
+
+        int numCandidatePairs = 0;
+        int numBruteForcePairs = 0;
+        map.GetCollisionPairStats( numCandidatePairs, numBruteForcePairs );
+        double numLiveEntities = (double)map.GetNumEntities();
+
+        componentBytes += (numLiveEntities * (double)(tileBytesPerEntity + broadphaseBytesPerEntity + sleepBytesPerEntity)) + ((double)numCandidatePairs * (double)(sizeof( CollisionPair ) + (2 * bytesPerPairSide)));
+        entityObjectBytes += (numLiveEntities * 3.0 * ENTITY_OBJECT_BYTES_PER_READ) + ((double)numCandidatePairs * (double)(2 * ENTITY_OBJECT_BYTES_PER_READ));
+        numEntityUpdates += numLiveEntities;
+    }
+
+    result.optimizedSeconds = GetCurrentTimeSeconds() - startTime;
+    double collisionSeconds = map.GetPhaseSeconds( MAP_PHASE_COLLISION );
+    map.Shutdown();
+
+    double collisionMS = (collisionSeconds * 1000.0) / (double)numTicks;
+    double entitiesPerMS = numEntityUpdates / (result.optimizedSeconds * 1000.0);
+    double componentKB = componentBytes / ((double)numTicks * 1024.0);
+    double entityObjectKB = entityObjectBytes / ((double)numTicks * 1024.0);
+    result.details = Stringf( "%.0f entities/ms, collision %.3fms reading %.1fKB/pass (entity objects ~%.1fKB)", entitiesPerMS, collisionMS, componentKB, entityObjectKB );
+    return result;
+}
+
+
+// What the map does per entity every frame (draw) and every hashed tick, through the mixed list with virtual calls
+static void DispatchEntitiesVirtual( const EntityList& entities, StateHash& hash ) {
+    int numEntities = (int)entities.size();
+
+    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
+        const Entity* entity = entities[entityIndex];
+        g_theRenderer->SetModelMatrix( entity->GetInterpolationTransform( 1.f ) );
+        entity->Render();
+        entity->AddToStateHash( hash );
+    }
+}
+
+
+// The same work over one type's list, the qualified calls skip the vtable and let T's versions inline
+template< typename T >
+static void DispatchEntitiesOfType( const EntityList& entities, StateHash& hash ) {
+    int numEntities = (int)entities.size();
+
+    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
+        const T* entity = static_cast<const T*>(entities[entityIndex]);
+        g_theRenderer->SetModelMatrix( entity->GetInterpolationTransform( 1.f ) );
+        entity->T::Render();
+        entity->T::AddToStateHash( hash );
+    }
+}
+
+
+static void DispatchEntitiesBatched( const EntityRegistry& registry, StateHash& hash ) {
+    DispatchEntitiesOfType<Boulder>( registry.GetEntitiesOfType( ENTITY_TYPE_BOULDER ), hash );
+    DispatchEntitiesOfType<EnemyTank>( registry.GetEntitiesOfType( ENTITY_TYPE_ENEMYTANK ), hash );
+    DispatchEntitiesOfType<EnemyTurret>( registry.GetEntitiesOfType( ENTITY_TYPE_ENEMYTURRET ), hash );
+    DispatchEntitiesOfType<PlayerTank>( registry.GetEntitiesOfType( ENTITY_TYPE_PLAYERTANK ), hash );
+    DispatchEntitiesOfType<Bullet>( registry.GetEntitiesOfType( ENTITY_TYPE_BULLET ), hash );
+}
+
+
+const BenchmarkResult RunDispatchBenchmark( int numEntities /*= BENCHMARK_DISPATCH_NUM_ENTITIES*/, int numTicks /*= BENCHMARK_DISPATCH_NUM_TICKS*/ ) {
+    std::map<TileType, float> tileFractions = {
+        { TILE_TYPE_STONE, MAP_STONE_TILES_FRACTION }
+    };
+
+    int numEnemies = numEntities / 3;
+    std::map<EntityType, int> numEntitiesByType = {
+        { ENTITY_TYPE_ENEMYTANK, numEnemies },
+        { ENTITY_TYPE_ENEMYTURRET, numEnemies },
+        { ENTITY_TYPE_BOULDER, numEntities - (2 * numEnemies) }
+    };
+
+    IntVec2 dimensions( BENCHMARK_UPDATE_MAP_SIZE, BENCHMARK_UPDATE_MAP_SIZE );
+    Map map( dimensions, TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntitiesByType, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+    map.Startup();
+
+    BenchmarkResult result;
+    result.name = "Entity Dispatch";
+    result.baselineName = "virtual";
+    result.optimizedName = "type batched";
+    result.workPerIteration = numEntities;
+    result.numIterations = numTicks;
+
+    float deltaSeconds = 1.f / (float)APP_DEFAULT_TICK_RATE;
+    AABB2 mapBounds( Vec2::ZERO, Vec2( (float)dimensions.x, (float)dimensions.y ) );
+    const EntityRegistry& registry = map.GetEntityRegistry();
+    double virtualSeconds = 0.0;
+    double batchedSeconds = 0.0;
+
+    for( int tickIndex = 0; tickIndex < numTicks; tickIndex++ ) {
+        map.Update( deltaSeconds );
+        map.Render( mapBounds ); // Rebuilds dirty verts, so both loops below only dispatch and draw
+
+        // Each tick's first loop warms the cache for the second, so they take turns going first
+        for( int passIndex = 0; passIndex < 2; passIndex++ ) {
+            bool isBatchedPass = ((tickIndex + passIndex) % 2) == 1;
+            StateHash hash;
+            double startTime = GetCurrentTimeSeconds();
+
+            if( isBatchedPass ) {
+                DispatchEntitiesBatched( registry, hash );
+                batchedSeconds += GetCurrentTimeSeconds() - startTime;
+            } else {
+                DispatchEntitiesVirtual( registry.GetEntities(), hash );
+                virtualSeconds += GetCurrentTimeSeconds() - startTime;
+            }
+        }
+    }
+
+    double entityPhaseSeconds = map.GetPhaseSeconds( MAP_PHASE_ENTITIES );
+    map.Shutdown();
+
+    result.baselineSeconds = virtualSeconds;
+    result.optimizedSeconds = batchedSeconds;
+
+    double entityPhaseMS = (entityPhaseSeconds * 1000.0) / (double)numTicks;
+    result.details = Stringf( "Render and AddToStateHash per entity, the map stays virtual (entity update %.3fms/tick)", entityPhaseMS );
+    return result;
+}
+
+
+// Bullets as Bullet entities or as projectiles on the same map and spawns, the only other entities are boulders
+static void RunProjectileTicks( int numProjectiles, int numTicks, bool areBulletsProjectiles, double& out_tickSeconds, double& out_bulletSeconds, double& out_numBulletUpdates, int& out_numAlive ) {
+    std::map<TileType, float> tileFractions = {
+        { TILE_TYPE_STONE, MAP_STONE_TILES_FRACTION }
+    };
+
+    std::map<EntityType, int> numEntitiesByType = {
+        { ENTITY_TYPE_BOULDER, BENCHMARK_PROJECTILES_NUM_BOULDERS },
+        { ENTITY_TYPE_BULLET, numProjectiles }
+    };
+
+    IntVec2 dimensions( BENCHMARK_UPDATE_MAP_SIZE, BENCHMARK_UPDATE_MAP_SIZE );
+    Map map( dimensions, TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntitiesByType, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+    map.SetBulletProjectilesEnabled( areBulletsProjectiles );
+    map.Startup();
+    map.ResetPhaseTimings();
+
+    float deltaSeconds = 1.f / (float)APP_DEFAULT_TICK_RATE;
+    AABB2 mapBounds( Vec2::ZERO, Vec2( (float)dimensions.x, (float)dimensions.y ) );
+    int numProjectilesAlive = 0;
+    int highWaterMark = 0;
+    out_numBulletUpdates = 0.0;
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int tickIndex = 0; tickIndex < numTicks; tickIndex++ ) {
+        map.GetProjectileStats( numProjectilesAlive, highWaterMark );
+        out_numBulletUpdates += areBulletsProjectiles ? (double)numProjectilesAlive : (double)(map.GetNumEntities() - BENCHMARK_PROJECTILES_NUM_BOULDERS);
+
+        map.Update( deltaSeconds );
+        map.Render( mapBounds );
+    }
+
+    out_tickSeconds = GetCurrentTimeSeconds() - startTime;
+
+    // Bullet entities are updated in the entity phase and collide in the collision pass, projectiles do both in their own phase
+    if( areBulletsProjectiles ) {
+        out_bulletSeconds = map.GetPhaseSeconds( MAP_PHASE_PROJECTILES );
+        map.GetProjectileStats( out_numAlive, highWaterMark );
+    } else {
+        out_bulletSeconds = map.GetPhaseSeconds( MAP_PHASE_ENTITIES ) + map.GetPhaseSeconds( MAP_PHASE_COLLISION );
+        out_numAlive = map.GetNumEntities() - BENCHMARK_PROJECTILES_NUM_BOULDERS;
+    }
+
+    map.Shutdown();
+}
+
+
+const BenchmarkResult RunProjectileBenchmark( int numProjectiles /*= BENCHMARK_PROJECTILES_NUM_PROJECTILES*/, int numTicks /*= BENCHMARK_PROJECTILES_NUM_TICKS*/ ) {
+    BenchmarkResult result;
+    result.name = "Projectiles";
+    result.baselineName = "bullet entities";
+    result.optimizedName = "projectile kernel";
+    result.workPerIteration = numProjectiles;
+    result.numIterations = numTicks;
+
+    double entityBulletSeconds = 0.0;
+    double numEntityBulletUpdates = 0.0;
+    int numEntityBulletsAlive = 0;
+    RunProjectileTicks( numProjectiles, numTicks, false, result.baselineSeconds, entityBulletSeconds, numEntityBulletUpdates, numEntityBulletsAlive );
+
+    double kernelSeconds = 0.0;
+    double numProjectileUpdates = 0.0;
+    int numProjectilesAlive = 0;
+    RunProjectileTicks( numProjectiles, numTicks, true, result.optimizedSeconds, kernelSeconds, numProjectileUpdates, numProjectilesAlive );
+
+    // Bounces are simpler than Bullet's swept ones, so the two runs don't end in the same state
+    double projectilesPerMS = numProjectileUpdates / (kernelSeconds * 1000.0);
+    double entityBulletsPerMS = numEntityBulletUpdates / (entityBulletSeconds * 1000.0);
+    result.details = Stringf( "%.0f projectiles/ms (bullet entities %.0f/ms), %d alive (entities %d)", projectilesPerMS, entityBulletsPerMS, numProjectilesAlive, numEntityBulletsAlive );
+    return result;
+}
+
+
+// Goal random walks to a neighboring open tile every tick, so the shared field fully rebuilds every tick
+static int GetNextFlowFieldGoal( const Map& map, int goalTileIndex, RNG& rng ) {
+    const IntVec2& dimensions = map.GetDimensions();
+    int neighborTiles[4] = { goalTileIndex - 1, goalTileIndex + 1, goalTileIndex - dimensions.x, goalTileIndex + dimensions.x };
+    int firstNeighbor = rng.GetRandomIntLessThan( 4 );
+
+    for( int neighborIndex = 0; neighborIndex < 4; neighborIndex++ ) {
+        int neighborTile = neighborTiles[(firstNeighbor + neighborIndex) % 4];
+
+        if( !map.IsTileSolid( neighborTile ) ) { // Border walls keep the neighbors in bounds
+            return neighborTile;
+        }
+    }
+
+    return goalTileIndex;
+}
+
+
+static double RunFlowFieldTicks( const Map& map, const std::vector<Vec2>& agentPositions, int numTicks, bool isShared, int& out_numFollowing ) {
+    RNG rng( BENCHMARK_RNG_SEED );
+    const IntVec2& dimensions = map.GetDimensions();
+    int goalTileIndex = map.GetTileIndexFromTileCoords( dimensions.x / 2, dimensions.y / 2 );
+    int numAgents = (int)agentPositions.size();
+
+    FlowField flowField;
+    flowField.Startup( dimensions );
+
+    Vec2 direction;
+    int distance = 0;
+    out_numFollowing = 0;
+    double startTime = GetCurrentTimeSeconds();
+
+    for( int tickIndex = 0; tickIndex < numTicks; tickIndex++ ) {
+        goalTileIndex = GetNextFlowFieldGoal( map, goalTileIndex, rng );
+
+        if( isShared ) {
+            flowField.SetGoal( map, goalTileIndex );
+        }
+
+        for( int agentIndex = 0; agentIndex < numAgents; agentIndex++ ) {
+            if( !isShared ) { // Every agent searches the whole map on its own
+                flowField.ClearGoal();
+                flowField.SetGoal( map, goalTileIndex );
+            }
+
+            if( flowField.GetFlowDirection( agentPositions[agentIndex], direction, distance ) ) {
+                out_numFollowing++;
+            }
+        }
+    }
+
+    double seconds = GetCurrentTimeSeconds() - startTime;
+    flowField.Shutdown();
+    return seconds;
+}
+
+
+const BenchmarkResult RunFlowFieldBenchmark( int numAgents /*= BENCHMARK_FLOWFIELD_NUM_AGENTS*/, int numTicks /*= BENCHMARK_FLOWFIELD_NUM_TICKS*/ ) {
+    std::map<TileType, float> tileFractions = {
+        { TILE_TYPE_STONE, MAP_STONE_TILES_FRACTION }
+    };
+    std::map<EntityType, int> numEntities = {}; // Only tiles are searched
+    IntVec2 dimensions( BENCHMARK_FLOWFIELD_MAP_SIZE, BENCHMARK_FLOWFIELD_MAP_SIZE );
+    Map map( dimensions, TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntities, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+    map.StartupTiles();
+
+    // Agents on random open tiles, enough for the largest shared run
+    RNG rng( BENCHMARK_RNG_SEED );
+    int maxAgents = numAgents * 100;
+    std::vector<Vec2> agentPositions;
+    agentPositions.reserve( maxAgents );
+
+    while( (int)agentPositions.size() < maxAgents ) {
+        Vec2 position = Vec2( rng.GetRandomFloatInRange( 1.f, (float)dimensions.x - 1.f ), rng.GetRandomFloatInRange( 1.f, (float)dimensions.y - 1.f ) );
+
+        if( !map.IsTileSolidAtWorldCoords( position ) ) {
+            agentPositions.push_back( position );
+        }
+    }
+
+    BenchmarkResult result;
+    result.name = "Flow Fields";
+    result.baselineName = "per-agent search";
+    result.optimizedName = "shared field";
+    result.workPerIteration = numAgents;
+    result.numIterations = numTicks;
+
+    std::vector<Vec2> someAgents( agentPositions.begin(), agentPositions.begin() + numAgents );
+    int numFollowing = 0;
+    result.baselineSeconds = RunFlowFieldTicks( map, someAgents, numTicks, false, numFollowing );
+    result.optimizedSeconds = RunFlowFieldTicks( map, someAgents, numTicks, true, numFollowing );
+
+    // Same rebuild per tick however many agents follow, only the O(1) lookups grow
+    someAgents.clear();
+    int numFollowingNone = 0;
+    double rebuildSeconds = RunFlowFieldTicks( map, someAgents, numTicks, true, numFollowingNone );
+
+    someAgents.assign( agentPositions.begin(), agentPositions.begin() + (numAgents * 10) );
+    int numFollowingTen = 0;
+    double tenSeconds = RunFlowFieldTicks( map, someAgents, numTicks, true, numFollowingTen );
+
+    int numFollowingHundred = 0;
+    double hundredSeconds = RunFlowFieldTicks( map, agentPositions, numTicks, true, numFollowingHundred );
+
+    double msPerTick = 1000.0 / (double)numTicks;
+    double nsPerLookup = ((hundredSeconds - rebuildSeconds) * 1.0e9) / (double)(maxAgents * numTicks);
+    result.details = Stringf( "shared field with 0 agents %.3fms, %d agents %.3fms, %d agents %.3fms (%.0fns/lookup), %d%% following",
+        rebuildSeconds * msPerTick, numAgents * 10, tenSeconds * msPerTick, maxAgents, hundredSeconds * msPerTick, nsPerLookup, (100 * numFollowingHundred) / (maxAgents * numTicks) );
+
+    map.Shutdown();
+    return result;
+}
+
+
+static int GetRandomOpenTileIndex( const Map& map, RNG& rng ) {
+    const IntVec2& dimensions = map.GetDimensions();
+    int numTiles = dimensions.x * dimensions.y;
+    int tileIndex = rng.GetRandomIntLessThan( numTiles );
+
+    while( map.IsTileSolid( tileIndex ) ) {
+        tileIndex = rng.GetRandomIntLessThan( numTiles );
+    }
+
+    return tileIndex;
+}
+
+
+static void AddRoomWalls( Map& map, RNG& rng ) {
+    // Walls every BENCHMARK_PATHFINDING_ROOM_SIZE tiles both ways, each room gets one doorway east and one north
+    const IntVec2& dimensions = map.GetDimensions();
+    int roomSize = BENCHMARK_PATHFINDING_ROOM_SIZE;
+
+    for( int tileY = 0; tileY < dimensions.y; tileY++ ) {
+        for( int tileX = 0; tileX < dimensions.x; tileX++ ) {
+            if( (tileX % roomSize) == 0 || (tileY % roomSize) == 0 ) {
+                map.SetTileType( map.GetTileIndexFromTileCoords( tileX, tileY ), TILE_TYPE_STONE );
+            }
+        }
+    }
+
+    for( int roomY = 0; roomY * roomSize < dimensions.y - 1; roomY++ ) {
+        for( int roomX = 0; roomX * roomSize < dimensions.x - 1; roomX++ ) {
+            // Inside of the room, the last row and column are cut short by the border
+            int firstX = (roomX * roomSize) + 1;
+            int firstY = (roomY * roomSize) + 1;
+            int lastX = ClampInt( ((roomX + 1) * roomSize) - 1, firstX, dimensions.x - 2 );
+            int lastY = ClampInt( ((roomY + 1) * roomSize) - 1, firstY, dimensions.y - 2 );
+
+            if( lastX + 1 < dimensions.x - 1 ) {
+                int doorY = firstY + rng.GetRandomIntLessThan( lastY - firstY + 2 - BENCHMARK_PATHFINDING_DOOR_WIDTH );
+                for( int doorIndex = 0; doorIndex < BENCHMARK_PATHFINDING_DOOR_WIDTH; doorIndex++ ) {
+                    map.SetTileType( map.GetTileIndexFromTileCoords( lastX + 1, doorY + doorIndex ), TILE_TYPE_GRASS );
+                }
+            }
+
+            if( lastY + 1 < dimensions.y - 1 ) {
+                int doorX = firstX + rng.GetRandomIntLessThan( lastX - firstX + 2 - BENCHMARK_PATHFINDING_DOOR_WIDTH );
+                for( int doorIndex = 0; doorIndex < BENCHMARK_PATHFINDING_DOOR_WIDTH; doorIndex++ ) {
+                    map.SetTileType( map.GetTileIndexFromTileCoords( doorX + doorIndex, lastY + 1 ), TILE_TYPE_GRASS );
+                }
+            }
+        }
+    }
+}
+
+
+const BenchmarkResult RunPathfindingBenchmark( PathfindingLayout layout, int mapSize /*= BENCHMARK_PATHFINDING_MAP_SIZE*/, int numQueries /*= BENCHMARK_PATHFINDING_NUM_QUERIES*/ ) {
+    std::map<TileType, float> tileFractions;
+    if( layout == PATHFINDING_LAYOUT_RANDOM_STONE ) {
+        tileFractions[TILE_TYPE_STONE] = MAP_STONE_TILES_FRACTION;
+    }
+
+    std::map<EntityType, int> numEntities = {}; // Only tiles are searched
+    Map map( IntVec2( mapSize, mapSize ), TILE_TYPE_GRASS, TILE_TYPE_STONE, tileFractions, numEntities, false );
+    map.SetSeed( BENCHMARK_RNG_SEED );
+    map.StartupTiles();
+
+    RNG rng( BENCHMARK_RNG_SEED );
+    if( layout == PATHFINDING_LAYOUT_ROOMS ) {
+        AddRoomWalls( map, rng );
+    }
+
+    GridPathfinder pathfinder;
+    double startTime = GetCurrentTimeSeconds();
+    pathfinder.Startup( map );
+    double buildSeconds = GetCurrentTimeSeconds() - startTime;
+
+    std::vector<int> startTiles( numQueries );
+    std::vector<int> goalTiles( numQueries );
+
+    for( int queryIndex = 0; queryIndex < numQueries; queryIndex++ ) {
+        startTiles[queryIndex] = GetRandomOpenTileIndex( map, rng );
+        goalTiles[queryIndex] = GetRandomOpenTileIndex( map, rng );
+    }
+
+    // Tanks investigate where they last saw their target, so most game queries end within sight range
+    std::vector<int> nearbyGoalTiles( numQueries );
+    int sightRange = (int)ENEMYTANK_MAX_SIGHT_RANGE;
+
+    for( int queryIndex = 0; queryIndex < numQueries; queryIndex++ ) {
+        IntVec2 startCoords = map.GetTileCoordsFromTileIndex( startTiles[queryIndex] );
+        IntVec2 goalCoords;
+
+        do {
+            goalCoords.x = startCoords.x - sightRange + rng.GetRandomIntLessThan( (2 * sightRange) + 1 );
+            goalCoords.y = startCoords.y - sightRange + rng.GetRandomIntLessThan( (2 * sightRange) + 1 );
+        } while( map.IsTileSolid( goalCoords.x, goalCoords.y ) );
+
+        nearbyGoalTiles[queryIndex] = map.GetTileIndexFromTileCoords( goalCoords );
+    }
+
+    BenchmarkResult result;
+    const char* layoutName = (layout == PATHFINDING_LAYOUT_ROOMS) ? "rooms" : "random stone, worst case";
+    result.name = Stringf( "Pathfinding %dx%d %s", mapSize, mapSize, layoutName );
+    result.baselineName = "A*";
+    result.optimizedName = "JPS+";
+    result.workPerIteration = numQueries;
+    result.numIterations = 1;
+
+    std::vector<float> aStarLengths( numQueries, 0.f );
+    std::vector<float> jumpPointLengths( numQueries, 0.f );
+    IntVec2 waypoints[2];
+    int numPaths = 0;
+
+    startTime = GetCurrentTimeSeconds();
+    for( int queryIndex = 0; queryIndex < numQueries; queryIndex++ ) {
+        pathfinder.FindPathAStar( map, startTiles[queryIndex], goalTiles[queryIndex], waypoints, 2, &aStarLengths[queryIndex] );
+    }
+    result.baselineSeconds = GetCurrentTimeSeconds() - startTime;
+
+    startTime = GetCurrentTimeSeconds();
+    for( int queryIndex = 0; queryIndex < numQueries; queryIndex++ ) {
+        if( pathfinder.FindPath( map, startTiles[queryIndex], goalTiles[queryIndex], waypoints, 2, &jumpPointLengths[queryIndex] ) > 0 ) {
+            numPaths++;
+        }
+    }
+    result.optimizedSeconds = GetCurrentTimeSeconds() - startTime;
+
+    startTime = GetCurrentTimeSeconds();
+    for( int queryIndex = 0; queryIndex < numQueries; queryIndex++ ) {
+        pathfinder.FindPath( map, startTiles[queryIndex], nearbyGoalTiles[queryIndex], waypoints, 2 );
+    }
+    double nearbySeconds = GetCurrentTimeSeconds() - startTime;
+
+    // Both are optimal, only the order diagonal and straight steps are added in can differ
+    int numMismatches = 0;
+    for( int queryIndex = 0; queryIndex < numQueries; queryIndex++ ) {
+        if( fabsf( aStarLengths[queryIndex] - jumpPointLengths[queryIndex] ) > 0.01f ) {
+            numMismatches++;
+        }
+    }
+
+    GUARANTEE_RECOVERABLE( numMismatches == 0, Stringf( "JPS+ path lengths disagreed with A* on %d of %d paths", numMismatches, numQueries ) );
+
+    // Walls going up, each patches the jump tables, then regions are relabelled once before the next searches like Map::Update does
+    int patchTiles[BENCHMARK_PATHFINDING_NUM_PATCHES];
+    TileType patchTileTypes[BENCHMARK_PATHFINDING_NUM_PATCHES];
+    double patchSeconds = 0.0;
+
+    for( int patchIndex = 0; patchIndex < BENCHMARK_PATHFINDING_NUM_PATCHES; patchIndex++ ) {
+        int tileIndex = GetRandomOpenTileIndex( map, rng );
+        patchTiles[patchIndex] = tileIndex;
+        patchTileTypes[patchIndex] = map.GetTileFromTileCoords( map.GetTileCoordsFromTileIndex( tileIndex ) ).GetTileType();
+
+        startTime = GetCurrentTimeSeconds();
+        map.SetTileType( tileIndex, TILE_TYPE_STONE );
+        pathfinder.OnTileChanged( map, tileIndex );
+        patchSeconds += GetCurrentTimeSeconds() - startTime;
+    }
+
+    startTime = GetCurrentTimeSeconds();
+    pathfinder.UpdateRegionsIfDirty( map );
+    double relabelSeconds = GetCurrentTimeSeconds() - startTime;
+
+    // Patched tables have to agree with A* on the changed map too, a tenth of the queries keeps A* from dominating the run
+    int numPatchedQueries = numQueries / 10;
+    numMismatches = 0;
+    for( int queryIndex = 0; queryIndex < numPatchedQueries; queryIndex++ ) {
+        float aStarLength = 0.f;
+        float jumpPointLength = 0.f;
+        pathfinder.FindPathAStar( map, startTiles[queryIndex], goalTiles[queryIndex], waypoints, 2, &aStarLength );
+        pathfinder.FindPath( map, startTiles[queryIndex], goalTiles[queryIndex], waypoints, 2, &jumpPointLength );
+
+        if( fabsf( aStarLength - jumpPointLength ) > 0.01f ) {
+            numMismatches++;
+        }
+    }
+
+    GUARANTEE_RECOVERABLE( numMismatches == 0, Stringf( "JPS+ path lengths disagreed with A* on %d of %d paths after patching", numMismatches, numPatchedQueries ) );
+
+    // And back down, newest first so each tile gets its original type back
+    for( int patchIndex = BENCHMARK_PATHFINDING_NUM_PATCHES - 1; patchIndex >= 0; patchIndex-- ) {
+        startTime = GetCurrentTimeSeconds();
+        map.SetTileType( patchTiles[patchIndex], patchTileTypes[patchIndex] );
+        pathfinder.OnTileChanged( map, patchTiles[patchIndex] );
+        patchSeconds += GetCurrentTimeSeconds() - startTime;
+    }
+
+    pathfinder.UpdateRegionsIfDirty( map );
+
+    double queryMicroseconds = (result.optimizedSeconds * 1.0e6) / (double)numQueries;
+    double aStarQueryMicroseconds = (result.baselineSeconds * 1.0e6) / (double)numQueries;
+    double nearbyQueryMicroseconds = (nearbySeconds * 1.0e6) / (double)numQueries;
+    double patchMS = (patchSeconds * 1000.0) / (double)(BENCHMARK_PATHFINDING_NUM_PATCHES * 2);
+    double tableMegabytes = (double)pathfinder.GetJumpTableBytes() / (1024.0 * 1024.0);
+    // The target is judged on paths across the whole map, paths within sight range (what tanks ask for) are only reported
+    double targetMicroseconds = BENCHMARK_PATHFINDING_TARGET_MICROSECONDS;
+    const char* targetResult = (queryMicroseconds <= targetMicroseconds) ? "met" : "missed";
+    result.details = Stringf( "across the map %.2fus/query (%s the %.0fus target, A* %.2fus), within sight range %.2fus/query, %d of %d found, jump tables %.1fMB built in %.2fms, %.3fms per tile patch, %.2fms region relabel",
+        queryMicroseconds, targetResult, targetMicroseconds, aStarQueryMicroseconds, nearbyQueryMicroseconds, numPaths, numQueries, tableMegabytes, buildSeconds * 1000.0, patchMS, relabelSeconds * 1000.0 );
+
+    pathfinder.Shutdown();
+    map.Shutdown();
+    return result;
+}
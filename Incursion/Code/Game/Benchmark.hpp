@@ -0,0 +1,42 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+
+#include "string"
+
+
+class Map;
+
+enum PathfindingLayout {
+    PATHFINDING_LAYOUT_ROOMS, // Rooms joined by doorways, like a built level
+    PATHFINDING_LAYOUT_RANDOM_STONE, // Stone scattered like the generated maps, a jump point every few tiles makes it the worst case
+
+    NUM_PATHFINDING_LAYOUTS
+};
+
+// Times the same workload through the original code path and its optimized replacement
+// With no baselineName it just times the optimized path
+struct BenchmarkResult {
+    public:
+    std::string name = "";
+    std::string baselineName = "";
+    std::string optimizedName = "";
+    int workPerIteration = 0;
+    int numIterations = 0;
+    double baselineSeconds = 0.0;
+    double optimizedSeconds = 0.0;
+    std::string details = "";
+
+    const std::string GetReport() const;
+};
+
+
+const BenchmarkResult RunRaycastBenchmark( const Map& map, int numRays = BENCHMARK_RAYCAST_NUM_RAYS, int numIterations = BENCHMARK_NUM_ITERATIONS );
+const BenchmarkResult RunMapBuildBenchmark( int mapSize = BENCHMARK_MAP_BUILD_SIZE, int numIterations = BENCHMARK_MAP_BUILD_NUM_ITERATIONS );
+const BenchmarkResult RunParticleBenchmark( int numParticles = BENCHMARK_PARTICLES_NUM_PARTICLES, int numFrames = BENCHMARK_PARTICLES_NUM_FRAMES );
+const BenchmarkResult RunSnapshotBenchmark( int numEntities = BENCHMARK_SNAPSHOT_NUM_ENTITIES, int numIterations = BENCHMARK_NUM_ITERATIONS );
+const BenchmarkResult RunParallelUpdateBenchmark( int numEntities = BENCHMARK_UPDATE_NUM_ENTITIES, int numTicks = BENCHMARK_UPDATE_NUM_TICKS );
+const BenchmarkResult RunComponentBenchmark( int numEntities = BENCHMARK_COMPONENTS_NUM_ENTITIES, int numTicks = BENCHMARK_COMPONENTS_NUM_TICKS );
+const BenchmarkResult RunDispatchBenchmark( int numEntities = BENCHMARK_DISPATCH_NUM_ENTITIES, int numTicks = BENCHMARK_DISPATCH_NUM_TICKS );
+const BenchmarkResult RunProjectileBenchmark( int numProjectiles = BENCHMARK_PROJECTILES_NUM_PROJECTILES, int numTicks = BENCHMARK_PROJECTILES_NUM_TICKS );
+const BenchmarkResult RunFlowFieldBenchmark( int numAgents = BENCHMARK_FLOWFIELD_NUM_AGENTS, int numTicks = BENCHMARK_FLOWFIELD_NUM_TICKS );
+const BenchmarkResult RunPathfindingBenchmark( PathfindingLayout layout, int mapSize = BENCHMARK_PATHFINDING_MAP_SIZE, int numQueries = BENCHMARK_PATHFINDING_NUM_QUERIES );
@@ -1,6 +1,6 @@
 #include "Game/Boulder.hpp"
 
-#include "Engine/core/VertexUtils.hpp"
+#include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Renderer/SpriteDef.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
@@ -33,7 +33,7 @@ void Boulder::Startup() {
     g_theGame->GetExtrasSprite( BOULDER_SPRITE_INDEX ).GetUVs( m_uvMins, m_uvMaxs );
     m_boulderVertOffsets = AABB2( Vec2( -BOULDER_COSMETIC_BOX_OFFSET, -BOULDER_COSMETIC_BOX_OFFSET ), Vec2( BOULDER_COSMETIC_BOX_OFFSET, BOULDER_COSMETIC_BOX_OFFSET ) );
 
-    UpdateBoulderVerts();
+    m_areVertsDirty = true;
 }
 
 
@@ -48,6 +48,10 @@ void Boulder::Update( float deltaSeconds ) {
 
 
 void Boulder::Render() const {
+    if( m_areVertsDirty ) {
+        UpdateBoulderVerts();
+    }
+
     if( g_theGame->IsDebugDrawingOn() ) {
         g_theRenderer->BindTexture( nullptr );
         g_theRenderer->DrawVertexArray( m_debugCosmeticVerts );
@@ -68,15 +72,13 @@ void Boulder::OnCollisionEntity( Entity* collidingEntity ) {
 }
 
 
-void Boulder::OnCollisionTile( Tile* collidingTile ) {
-    if( collidingTile->IsSolid() ) {
-        PushDiscOutOfAABB2( m_position, m_physicsRadius, collidingTile->GetBounds() );
-        UpdateBoulderVerts();
-    }
+void Boulder::OnCollisionTile( const AABB2& tileBounds ) {
+    PushDiscOutOfAABB2( m_position, m_physicsRadius, tileBounds );
+    m_areVertsDirty = true;
 }
 
 
-void Boulder::UpdateBoulderVerts() {
+void Boulder::UpdateBoulderVerts() const {
     m_boulderVerts.clear();
 
     // Base Verts
@@ -86,5 +88,7 @@ void Boulder::UpdateBoulderVerts() {
     if( g_theGame->IsDebugDrawingOn() ) {
         UpdateDebugVerts();
     }
+
+    m_areVertsDirty = false;
 }
 
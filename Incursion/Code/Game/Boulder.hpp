@@ -21,14 +21,14 @@ class Boulder : public Entity {
     void Render() const;
 
     void OnCollisionEntity( Entity* collidingEntity );
-    void OnCollisionTile( Tile* collidingTile );
+    void OnCollisionTile( const AABB2& tileBounds );
 
     private:
     const Texture* m_texture = nullptr;
     Vec2 m_uvMins = Vec2::ZERO;
     Vec2 m_uvMaxs = Vec2::ONE;
     AABB2 m_boulderVertOffsets = AABB2();
-    std::vector<Vertex_PCU> m_boulderVerts;
+    mutable std::vector<Vertex_PCU> m_boulderVerts;
 
-    void UpdateBoulderVerts();
+    void UpdateBoulderVerts() const;
 };
\ No newline at end of file
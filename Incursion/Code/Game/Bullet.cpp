@@ -1,21 +1,29 @@
 #include "Game/Bullet.hpp"
 
+#include "Engine/Core/BufferUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 
 #include "Game/Game.hpp"
+#include "Game/StateHash.hpp"
 #include "Game/Tile.hpp"
 
 
-Bullet::Bullet( Map* map, Entity* source ) :
-    Entity( ENTITY_TYPE_BULLET, source->GetFaction() ),
-    m_source(source) {
+Bullet::Bullet( Map* map ) :
+    Entity( ENTITY_TYPE_BULLET, FACTION_UNKNOWN ) {
     m_map = map;
 }
 
 
+void Bullet::Reset( FactionID faction, const EntityHandle& sourceHandle ) {
+    ResetEntity( faction );
+    m_sourceHandle = sourceHandle;
+    m_destructionCountdown = BULLET_LIFETIME_BOUNCES;
+}
+
+
 void Bullet::Die() {
     m_map->SpawnNewExplosion( m_position, EXPLOSION_SCALE_SMALL );
 
@@ -33,11 +41,14 @@ void Bullet::Startup() {
 
     m_physicsRadius = BULLET_PHYSICS_RADIUS;
     m_cosmeticRadius = BULLET_COSMETIC_RADIUS;
+
+    m_isSwept = true;
+    StartSweep();
     m_bulletTexture = g_theRenderer->CreateOrGetTextureFromFile( TEXTURE_BULLET );
 
     m_bulletVertOffsets = AABB2( Vec2( -BULLET_COSMETIC_BOX_OFFSET, -BULLET_COSMETIC_BOX_OFFSET ), Vec2( BULLET_COSMETIC_BOX_OFFSET, BULLET_COSMETIC_BOX_OFFSET ) );
 
-    UpdateBulletVerts();
+    m_areVertsDirty = true;
 }
 
 
@@ -47,33 +58,42 @@ void Bullet::Shutdown() {
 
 
 void Bullet::Update( float deltaSeconds ) {
-    if( m_map->GetTileFromWorldCoords( m_position ).IsSolid() ) {
+    if( m_map->IsTileSolidAtWorldCoords( m_position ) ) {
         Die();
     }
 
-    float distanceX = m_velocity.x * deltaSeconds;
-    float distanceY = m_velocity.y * deltaSeconds;
+    // Swept against the tiles so no speed or tick length tunnels through a wall
+    // Each bounce reflects at the real contact and spends the rest of the tick on the new heading,
+    //  the bounce points are kept so collision sweeps entities along every leg
+    float remainingFraction = 1.f;
+    StartSweep();
 
-    Vec2 translation = Vec2( distanceX, distanceY );
+    for( int sweepIndex = 0; sweepIndex < BULLET_MAX_SWEEPS_PER_TICK && remainingFraction > 0.f && !m_isDead; sweepIndex++ ) {
+        Vec2 translation = m_velocity * (deltaSeconds * remainingFraction);
 
-    Vec2 newPosition = m_position + translation;
-    Tile newTile = m_map->GetTileFromWorldCoords( newPosition );
+        float impactFraction;
+        AABB2 tileBounds;
 
-    if( newTile.IsSolid() ) {
-        OnCollisionTile( &newTile );
-
-        distanceX = m_velocity.x * deltaSeconds;
-        distanceY = m_velocity.y * deltaSeconds;
+        if( !m_map->SweepDiscVsTiles( m_position, translation, m_physicsRadius, impactFraction, tileBounds ) ) {
+            m_position += translation;
+            break;
+        }
 
-        translation = Vec2( distanceX, distanceY );
+        m_position += translation * impactFraction;
+        remainingFraction *= (1.f - impactFraction);
+        AddSweepCorner( 1.f - remainingFraction );
+        OnCollisionTile( tileBounds );
     }
 
-    m_position += translation;
-    UpdateBulletVerts();
+    m_areVertsDirty = true;
 }
 
 
 void Bullet::Render() const {
+    if( m_areVertsDirty ) {
+        UpdateBulletVerts();
+    }
+
     if( g_theGame->IsDebugDrawingOn() ) {
         g_theRenderer->BindTexture( nullptr );
         g_theRenderer->DrawVertexArray( m_debugCosmeticVerts );
@@ -91,19 +111,36 @@ void Bullet::Render() const {
 
 void Bullet::OnCollisionEntity( Entity* collidingEntity ) {
     EntityType collidingType = collidingEntity->GetEntityType();
-    if( collidingType == ENTITY_TYPE_BULLET || collidingType == ENTITY_TYPE_EXPLOSION ) {
+    if( collidingType == ENTITY_TYPE_BULLET ) {
         return;
     }
 
     // Check if can take damage, hurt/reflect
     if( collidingEntity->GetFaction() != m_faction ) {
+        Vec2 collidingPosition;
+        float collidingRadius;
+        collidingEntity->GetPhysicsDisc( collidingPosition, collidingRadius );
+
+        // Back along this tick's legs to where it first touched, so explosions and reflections happen at the contact
+        Vec2 sweepPoints[ENTITY_MAX_SWEEP_CORNERS + 2];
+        int numSweepPoints = GetSweepPoints( sweepPoints );
+
+        for( int legIndex = 0; legIndex < numSweepPoints - 1; legIndex++ ) {
+            Vec2 legDisplacement = sweepPoints[legIndex + 1] - sweepPoints[legIndex];
+            float impactFraction;
+            Vec2 impactNormal;
+
+            if( SweepDiscVsDisc( sweepPoints[legIndex], legDisplacement, m_physicsRadius, collidingPosition, collidingRadius, impactFraction, impactNormal ) ) {
+                m_position = sweepPoints[legIndex] + (legDisplacement * impactFraction);
+                m_numSweepCorners = legIndex; // Later legs never happened
+                break;
+            }
+        }
+
         if( collidingEntity->IsKillable() ) {
             collidingEntity->TakeDamage( 1 );
             Die();
         } else {
-            Vec2 collidingPosition;
-            float collidingRadius;
-            collidingEntity->GetPhysicsDisc( collidingPosition, collidingRadius );
             PushDiscOutOfDisc( m_position, m_physicsRadius, collidingPosition, collidingRadius );
 
             Vec2 normal = collidingPosition - m_position;
@@ -121,10 +158,9 @@ void Bullet::OnCollisionEntity( Entity* collidingEntity ) {
 }
 
 
-void Bullet::OnCollisionTile( Tile* collidingTile ) {
+void Bullet::OnCollisionTile( const AABB2& tileBounds ) {
     // Unlike most entities, this only called when a reflection is needed
-    // Determined by Bullet's Update instead of Map
-    AABB2 tileBounds = collidingTile->GetBounds();
+    // Determined by Bullet's Update instead of Map, at the point its sweep touched the tile
     Vec2 contactPoint = tileBounds.GetClosestPointOnAABB2( m_position );
     Vec2 normal = m_position - contactPoint;
     normal.Normalize();
@@ -139,7 +175,39 @@ void Bullet::OnCollisionTile( Tile* collidingTile ) {
 }
 
 
-void Bullet::UpdateBulletVerts() {
+void Bullet::AddToStateHash( StateHash& hash ) const {
+    Entity::AddToStateHash( hash );
+
+    hash.AddHandle( m_sourceHandle );
+    hash.AddInt( m_destructionCountdown );
+}
+
+
+void Bullet::WriteSnapshot( BufferWriter& writer ) const {
+    Entity::WriteSnapshot( writer );
+
+    writer.WriteInt32( m_sourceHandle.index );
+    writer.WriteUint32( m_sourceHandle.generation );
+    writer.WriteInt32( m_destructionCountdown );
+}
+
+
+void Bullet::ReadSnapshot( BufferReader& reader ) {
+    Entity::ReadSnapshot( reader );
+
+    m_sourceHandle.index = reader.ReadInt32();
+    m_sourceHandle.generation = reader.ReadUint32();
+    m_destructionCountdown = reader.ReadInt32();
+}
+
+
+int Bullet::GetSnapshotNumBytes() {
+    // Source handle, destruction countdown
+    return Entity::GetSnapshotNumBytes() + 4 + 4 + 4;
+}
+
+
+void Bullet::UpdateBulletVerts() const {
     m_bulletVerts.clear();
 
     // Base Verts
@@ -149,4 +217,6 @@ void Bullet::UpdateBulletVerts() {
     if( g_theGame->IsDebugDrawingOn() ) {
         UpdateDebugVerts();
     }
+
+    m_areVertsDirty = false;
 }
@@ -12,7 +12,8 @@ class Texture;
 class Bullet
     : public Entity {
     public:
-    explicit Bullet( Map* map, Entity* source);
+    explicit Bullet( Map* map );
+    void Reset( FactionID faction, const EntityHandle& sourceHandle ); // Source may be gone by the time the bullet spawns
     void Die();
 
     void Startup();
@@ -22,15 +23,20 @@ class Bullet
     void Render() const;
 
     void OnCollisionEntity( Entity* collidingEntity );
-    void OnCollisionTile( Tile* collidingTile );
+    void OnCollisionTile( const AABB2& tileBounds );
+
+    void AddToStateHash( StateHash& hash ) const override;
+    void WriteSnapshot( BufferWriter& writer ) const override;
+    void ReadSnapshot( BufferReader& reader ) override;
+    static int GetSnapshotNumBytes();
 
     private:
-    const Entity* m_source = nullptr;
+    EntityHandle m_sourceHandle;
     Texture* m_bulletTexture = nullptr;
-    std::vector<Vertex_PCU> m_bulletVerts;
+    mutable std::vector<Vertex_PCU> m_bulletVerts;
     AABB2 m_bulletVertOffsets = AABB2();
 
     int m_destructionCountdown = BULLET_LIFETIME_BOUNCES;
 
-    void UpdateBulletVerts();
+    void UpdateBulletVerts() const;
 };
\ No newline at end of file
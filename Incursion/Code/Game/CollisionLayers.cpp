@@ -0,0 +1,120 @@
+#include "Game/CollisionLayers.hpp"
+
+
+static const char* ENTITY_TYPE_NAMES[NUM_ENTITY_TYPES] = {
+    "Boulder",
+    "EnemyTank",
+    "EnemyTurret",
+    "PlayerTank",
+    "Bullet"
+};
+
+static const char* COLLISION_RULE_NAMES[NUM_COLLISION_RULES] = {
+    "never",
+    "enemies",
+    "always"
+};
+
+
+static const std::string TrimSpaces( const std::string& text ) {
+    size_t first = text.find_first_not_of( " \t\r\n" );
+    if( first == std::string::npos ) {
+        return "";
+    }
+
+    size_t last = text.find_last_not_of( " \t\r\n" );
+    return text.substr( first, last - first + 1 );
+}
+
+
+CollisionLayers::CollisionLayers() {
+    SetDefaults();
+}
+
+
+void CollisionLayers::SetDefaults() {
+    for( int typeA = 0; typeA < NUM_ENTITY_TYPES; typeA++ ) {
+        for( int typeB = 0; typeB < NUM_ENTITY_TYPES; typeB++ ) {
+            m_rules[typeA][typeB] = COLLISION_RULE_ALWAYS;
+        }
+    }
+
+    // Boulders and turrets never react to a collision, tanks push themselves out of them
+    SetRule( ENTITY_TYPE_BOULDER, ENTITY_TYPE_BOULDER, COLLISION_RULE_NEVER );
+    SetRule( ENTITY_TYPE_BOULDER, ENTITY_TYPE_ENEMYTURRET, COLLISION_RULE_NEVER );
+    SetRule( ENTITY_TYPE_ENEMYTURRET, ENTITY_TYPE_ENEMYTURRET, COLLISION_RULE_NEVER );
+
+    // Bullets aren't solid, so only the bullet reacts, and only to other factions
+    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
+        SetRule( ENTITY_TYPE_BULLET, (EntityType)typeIndex, COLLISION_RULE_ENEMIES );
+    }
+
+    SetRule( ENTITY_TYPE_BULLET, ENTITY_TYPE_BULLET, COLLISION_RULE_NEVER );
+}
+
+
+void CollisionLayers::SetFromString( const std::string& rulesText ) {
+    Strings entries = SplitStringOnDelimeter( rulesText, ',' );
+    int numEntries = (int)entries.size();
+
+    for( int entryIndex = 0; entryIndex < numEntries; entryIndex++ ) {
+        std::string entry = TrimSpaces( entries[entryIndex] );
+        if( entry.empty() ) {
+            continue;
+        }
+
+        Strings pairAndRule = SplitStringOnDelimeter( entry, ':' );
+        Strings types = (pairAndRule.size() == 2) ? SplitStringOnDelimeter( pairAndRule[0], '-' ) : Strings();
+
+        if( types.size() != 2 ) {
+            GUARANTEE_RECOVERABLE( false, Stringf( "Invalid collision layer (%s), expected TypeA-TypeB:rule", entry.c_str() ) );
+            continue;
+        }
+
+        EntityType typeA = GetEntityTypeFromName( TrimSpaces( types[0] ) );
+        EntityType typeB = GetEntityTypeFromName( TrimSpaces( types[1] ) );
+        CollisionRule rule = GetRuleFromName( TrimSpaces( pairAndRule[1] ) );
+
+        if( typeA == ENTITY_TYPE_UNKNOWN || typeB == ENTITY_TYPE_UNKNOWN || rule == NUM_COLLISION_RULES ) {
+            GUARANTEE_RECOVERABLE( false, Stringf( "Unknown type or rule in collision layer (%s)", entry.c_str() ) );
+            continue;
+        }
+
+        SetRule( typeA, typeB, rule );
+    }
+}
+
+
+void CollisionLayers::SetRule( EntityType typeA, EntityType typeB, CollisionRule rule ) {
+    m_rules[typeA][typeB] = rule;
+    m_rules[typeB][typeA] = rule;
+}
+
+
+CollisionRule CollisionLayers::GetRule( EntityType typeA, EntityType typeB ) const {
+    return m_rules[typeA][typeB];
+}
+
+
+EntityType CollisionLayers::GetEntityTypeFromName( const std::string& name ) {
+    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
+        if( name == ENTITY_TYPE_NAMES[typeIndex] ) {
+            return (EntityType)typeIndex;
+        }
+    }
+
+    return ENTITY_TYPE_UNKNOWN;
+}
+
+
+CollisionRule CollisionLayers::GetRuleFromName( const std::string& name ) {
+    std::string lowerName = StringToLower( name );
+
+    for( int ruleIndex = 0; ruleIndex < NUM_COLLISION_RULES; ruleIndex++ ) {
+        if( lowerName == COLLISION_RULE_NAMES[ruleIndex] ) {
+            return (CollisionRule)ruleIndex;
+        }
+    }
+
+    return NUM_COLLISION_RULES;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/Entity.hpp"
+
+#include "string"
+
+
+enum CollisionRule {
+    COLLISION_RULE_NEVER,
+    COLLISION_RULE_ENEMIES, // Only when the two factions differ
+    COLLISION_RULE_ALWAYS,
+
+    NUM_COLLISION_RULES
+};
+
+
+// Symmetric EntityType x EntityType matrix deciding which broadphase pairs reach the narrowphase
+// Defaults only skip pairs whose OnCollisionEntity does nothing on either side, so skipping never changes the game
+// Overrides come from data as "TypeA-TypeB:rule" entries split by commas, e.g. "Bullet-Bullet:never, Bullet-Boulder:enemies"
+class CollisionLayers {
+    public:
+    CollisionLayers();
+    ~CollisionLayers() {};
+
+    void SetDefaults();
+    void SetFromString( const std::string& rulesText ); // Applied on top of the current rules
+    void SetRule( EntityType typeA, EntityType typeB, CollisionRule rule );
+
+    CollisionRule GetRule( EntityType typeA, EntityType typeB ) const;
+    bool ShouldCollide( EntityType typeA, FactionID factionA, EntityType typeB, FactionID factionB ) const;
+
+    static EntityType GetEntityTypeFromName( const std::string& name ); // ENTITY_TYPE_UNKNOWN if no match
+    static CollisionRule GetRuleFromName( const std::string& name ); // NUM_COLLISION_RULES if no match
+
+    private:
+    CollisionRule m_rules[NUM_ENTITY_TYPES][NUM_ENTITY_TYPES];
+};
+
+
+//-----------------------------------------------------------------------------------------------
+inline bool CollisionLayers::ShouldCollide( EntityType typeA, FactionID factionA, EntityType typeB, FactionID factionB ) const {
+    CollisionRule rule = m_rules[typeA][typeB];
+    return (rule == COLLISION_RULE_ALWAYS) || (rule == COLLISION_RULE_ENEMIES && factionA != factionB);
+}
@@ -1,11 +1,13 @@
 #include "Game/EnemyTank.hpp"
 
+#include "Engine/Core/BufferUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 
 #include "Game/Game.hpp"
 #include "Game/Map.hpp"
+#include "Game/StateHash.hpp"
 #include "Game/RaycastResult.hpp"
 
 
@@ -39,10 +41,11 @@ void EnemyTank::Startup() {
 
     m_baseTexture = g_theRenderer->CreateOrGetTextureFromFile( TEXTURE_ENEMYTANK_BASE );
     m_topTexture = g_theRenderer->CreateOrGetTextureFromFile( TEXTURE_ENEMYTANK_TOP );
+    m_shootSound = g_theAudio->CreateOrGetSound( AUDIO_ENEMY_SHOOT );
 
     m_tankVertOffsets = AABB2( Vec2( -ENEMYTANK_COSMETIC_BOX_OFFSET, -ENEMYTANK_COSMETIC_BOX_OFFSET ), Vec2( ENEMYTANK_COSMETIC_BOX_OFFSET, ENEMYTANK_COSMETIC_BOX_OFFSET ) );
 
-    UpdateTankVerts();
+    m_areVertsDirty = true;
 }
 
 
@@ -52,43 +55,104 @@ void EnemyTank::Shutdown() {
 }
 
 
+void EnemyTank::QueueRaycasts() {
+    Entity* target = m_map->GetOrAcquireTarget( m_targetHandle );
+
+    m_lineOfSightTargetHandle = m_targetHandle;
+    m_lineOfSightRay = -1;
+
+    if( target != nullptr ) {
+        m_lineOfSightRay = m_map->SubmitLineOfSight( this, target );
+    }
+
+    // Whiskers are only needed while wandering, but which branch runs isn't known until Update
+    Vec2 lNormVec = Vec2::MakeFromPolarDegrees( m_orientationDegrees + ENEMYTANK_WHISKER_ANGLE );
+    Vec2 rNormVec = Vec2::MakeFromPolarDegrees( m_orientationDegrees - ENEMYTANK_WHISKER_ANGLE );
+    Vec2 cNormVec = Vec2::MakeFromPolarDegrees( m_orientationDegrees );
+
+    m_leftWhiskerRay = m_map->SubmitRaycast( m_position, lNormVec, ENEMYTANK_WHISKER_RANGE );
+    m_rightWhiskerRay = m_map->SubmitRaycast( m_position, rNormVec, ENEMYTANK_WHISKER_RANGE );
+    m_centerWhiskerRay = m_map->SubmitRaycast( m_position, cNormVec, m_cosmeticRadius );
+}
+
+
 void EnemyTank::Update( float deltaSeconds ) {
     m_gunCooldown -= deltaSeconds;
 
-    if( m_target == nullptr || !m_target->IsAlive() ) {
-        m_target = m_map->AcquireNewTarget();
+    const EntityTickState* target = m_map->GetTickState( m_targetHandle ); // Acquired in QueueRaycasts
 
-        if( m_target == nullptr ) {
-            UpdateWanderAround( deltaSeconds );
-            UpdateTankVerts();
-            return;
-        }
+    if( target == nullptr || !target->isAlive ) {
+        UpdateWanderAround( deltaSeconds );
+        m_areVertsDirty = true;
+        return;
+    }
+
+    bool hasLoS = false;
+
+    if( m_targetHandle == m_lineOfSightTargetHandle ) { // Otherwise the target changed after rays were queued, look next tick
+        hasLoS = !m_map->GetSubmittedRaycastResult( m_lineOfSightRay ).DidImpact();
     }
 
-    bool hasLoS = m_map->HasLineOfSight( this, m_target );
-    Vec2 targetDisplacement = (m_target->GetPosition() - m_position);
+    Vec2 targetDisplacement = (target->position - m_position);
+    Vec2 flowDirection;
+    int flowDistance = 0;
 
     if( hasLoS && targetDisplacement.GetLength() < ENEMYTANK_MAX_SIGHT_RANGE ) { // Have LoS, Chase
         m_investigateTarget = true;
-        m_targetLastKnownPosition = m_target->GetPosition();
+        m_targetLastKnownPosition = target->position;
 
         UpdateChaseTarget( deltaSeconds, targetDisplacement.GetAngleDegrees(), hasLoS );
     } else if( m_investigateTarget ) { // No LoS, Investigate last known position
         targetDisplacement = m_targetLastKnownPosition - m_position;
-        UpdateChaseTarget( deltaSeconds, targetDisplacement.GetAngleDegrees(), hasLoS );
+        Vec2 headingDisplacement = targetDisplacement;
+
+        // Walls in the way, head for the end of the path's current leg instead
+        // Paths arrive a tick or more after asking, until then keep to the last one toward the same spot
+        IntVec2 tileCoords = m_map->GetTileCoordsFromWorldCoords( m_position );
+        IntVec2 lastKnownTileCoords = m_map->GetTileCoordsFromWorldCoords( m_targetLastKnownPosition );
+        int tileIndex = m_map->GetTileIndexFromTileCoords( tileCoords );
+        int lastKnownTileIndex = m_map->GetTileIndexFromTileCoords( lastKnownTileCoords );
+        const PathResult* path = m_map->GetPathResult( m_handle );
+
+        if( path == nullptr || path->startTileIndex != tileIndex || path->goalTileIndex != lastKnownTileIndex ) {
+            m_map->RequestPath( m_handle, tileCoords, lastKnownTileCoords );
+        }
+
+        if( path != nullptr && path->goalTileIndex == lastKnownTileIndex && path->numWaypoints > 2 ) {
+            // Past a waypoint already, aim for the one after it
+            int numStoredWaypoints = path->GetNumStoredWaypoints();
+            int nextWaypointIndex = 1;
+
+            for( int waypointIndex = 1; waypointIndex < numStoredWaypoints - 1; waypointIndex++ ) {
+                if( path->waypoints[waypointIndex] == tileCoords ) {
+                    nextWaypointIndex = waypointIndex + 1;
+                }
+            }
+
+            const IntVec2& waypoint = path->waypoints[nextWaypointIndex];
+            headingDisplacement = Vec2( (float)waypoint.x + 0.5f, (float)waypoint.y + 0.5f ) - m_position;
+        }
+
+        UpdateChaseTarget( deltaSeconds, headingDisplacement.GetAngleDegrees(), hasLoS );
 
         if( targetDisplacement.GetLengthSquared() < 0.01f ) {
             m_investigateTarget = false;
         }
+    } else if( m_map->GetFlowDirectionToward( m_targetHandle, m_position, flowDirection, flowDistance ) && flowDistance <= ENEMYTANK_FLOW_FIELD_RANGE ) { // Nothing to investigate, follow the target's flow field
+        UpdateChaseTarget( deltaSeconds, flowDirection.GetAngleDegrees(), hasLoS );
     } else {
         UpdateWanderAround( deltaSeconds );
     }
 
-    UpdateTankVerts();
+    m_areVertsDirty = true;
 }
 
 
 void EnemyTank::Render() const {
+    if( m_areVertsDirty ) {
+        UpdateTankVerts();
+    }
+
     if( g_theGame->IsDebugDrawingOn() ) {
         g_theRenderer->BindTexture( nullptr );
         g_theRenderer->DrawVertexArray( m_debugCosmeticVerts );
@@ -122,11 +186,55 @@ void EnemyTank::OnCollisionEntity( Entity* collidingEntity ) {
 }
 
 
-void EnemyTank::OnCollisionTile( Tile* collidingTile ) {
-    if( collidingTile->IsSolid() ) {
-        PushDiscOutOfAABB2( m_position, m_physicsRadius, collidingTile->GetBounds() );
-        UpdateTankVerts();
-    }
+void EnemyTank::OnCollisionTile( const AABB2& tileBounds ) {
+    PushDiscOutOfAABB2( m_position, m_physicsRadius, tileBounds );
+    m_areVertsDirty = true;
+}
+
+
+void EnemyTank::AddToStateHash( StateHash& hash ) const {
+    Entity::AddToStateHash( hash );
+
+    hash.AddHandle( m_targetHandle );
+    hash.AddVec2( m_targetLastKnownPosition );
+    hash.AddBool( m_investigateTarget );
+    hash.AddFloat( m_desiredOrientationDegrees );
+    hash.AddFloat( m_orientationTopDegrees );
+    hash.AddFloat( m_gunCooldown );
+}
+
+
+void EnemyTank::WriteSnapshot( BufferWriter& writer ) const {
+    Entity::WriteSnapshot( writer );
+
+    writer.WriteInt32( m_targetHandle.index );
+    writer.WriteUint32( m_targetHandle.generation );
+    writer.WriteFloat( m_targetLastKnownPosition.x );
+    writer.WriteFloat( m_targetLastKnownPosition.y );
+    writer.WriteBool( m_investigateTarget );
+    writer.WriteFloat( m_desiredOrientationDegrees );
+    writer.WriteFloat( m_orientationTopDegrees );
+    writer.WriteFloat( m_gunCooldown );
+}
+
+
+void EnemyTank::ReadSnapshot( BufferReader& reader ) {
+    Entity::ReadSnapshot( reader );
+
+    m_targetHandle.index = reader.ReadInt32();
+    m_targetHandle.generation = reader.ReadUint32();
+    m_targetLastKnownPosition.x = reader.ReadFloat();
+    m_targetLastKnownPosition.y = reader.ReadFloat();
+    m_investigateTarget = reader.ReadBool();
+    m_desiredOrientationDegrees = reader.ReadFloat();
+    m_orientationTopDegrees = reader.ReadFloat();
+    m_gunCooldown = reader.ReadFloat();
+}
+
+
+int EnemyTank::GetSnapshotNumBytes() {
+    // Target handle and last known position, investigating, desired and top orientations, gun cooldown
+    return Entity::GetSnapshotNumBytes() + 4 + 4 + 8 + 1 + 4 + 4 + 4;
 }
 
 
@@ -149,13 +257,9 @@ void EnemyTank::UpdateChaseTarget( float deltaSeconds, float targetDegrees, bool
 
 
 void EnemyTank::UpdateWanderAround( float deltaSeconds ) {
-    Vec2 lNormVec = Vec2::MakeFromPolarDegrees( m_orientationDegrees + ENEMYTANK_WHISKER_ANGLE );
-    Vec2 rNormVec = Vec2::MakeFromPolarDegrees( m_orientationDegrees - ENEMYTANK_WHISKER_ANGLE );
-    Vec2 cNormVec = Vec2::MakeFromPolarDegrees( m_orientationDegrees );
-
-    RaycastResult lWhisker = m_map->Raycast( m_position, lNormVec, ENEMYTANK_WHISKER_RANGE );
-    RaycastResult rWhisker = m_map->Raycast( m_position, rNormVec, ENEMYTANK_WHISKER_RANGE );
-    RaycastResult cWhisker = m_map->Raycast( m_position, cNormVec, m_cosmeticRadius );
+    const RaycastResult& lWhisker = m_map->GetSubmittedRaycastResult( m_leftWhiskerRay );
+    const RaycastResult& rWhisker = m_map->GetSubmittedRaycastResult( m_rightWhiskerRay );
+    const RaycastResult& cWhisker = m_map->GetSubmittedRaycastResult( m_centerWhiskerRay );
 
     bool lImpact = lWhisker.DidImpact();
     bool rImpact = rWhisker.DidImpact();
@@ -197,7 +301,7 @@ void EnemyTank::UpdateWanderAround( float deltaSeconds ) {
 }
 
 
-void EnemyTank::UpdateTankVerts() {
+void EnemyTank::UpdateTankVerts() const {
     m_tankBaseVerts.clear();
     m_tankTopVerts.clear();
 
@@ -221,6 +325,7 @@ void EnemyTank::UpdateTankVerts() {
         AddVertsForLine2D( m_debugCosmeticVerts, m_position, m_position + cWhisker, 0.05f, Rgba( 1.f, 0.f, 0.f, 0.75f ) );
     }
 
+    m_areVertsDirty = false;
 }
 
 
@@ -231,8 +336,7 @@ const Vec2 EnemyTank::GetForwardVectorTop() const {
 
 void EnemyTank::ShootGun() {
     if( m_gunCooldown <= 0 ) {
-        SoundID shootSound = g_theAudio->CreateOrGetSound( AUDIO_ENEMY_SHOOT );
-        g_theAudio->PlaySound( shootSound );
+        m_map->PlaySound( m_shootSound );
 
         Vec2 barrelPosition = TransformPosition( GetForwardVectorTop(), 0.4f, 0.f, m_position );
         m_map->SpawnNewEntity( ENTITY_TYPE_BULLET, barrelPosition, m_orientationTopDegrees, (Entity*)this );
@@ -18,30 +18,44 @@ class EnemyTank
     void Startup();
     void Shutdown();
 
+    void QueueRaycasts();
     void Update( float deltaSeconds );
     void Render() const;
 
     void OnCollisionEntity( Entity* collidingEntity );
-    void OnCollisionTile( Tile* collidingTile );
+    void OnCollisionTile( const AABB2& tileBounds );
+
+    void AddToStateHash( StateHash& hash ) const override;
+    void WriteSnapshot( BufferWriter& writer ) const override;
+    void ReadSnapshot( BufferReader& reader ) override;
+    static int GetSnapshotNumBytes();
 
     private:
-    Entity* m_target = nullptr;
+    EntityHandle m_targetHandle;
     Vec2 m_targetLastKnownPosition = Vec2::ZERO;
     bool m_investigateTarget = false;
 
+    // Indices into the map's ray batch for this tick
+    EntityHandle m_lineOfSightTargetHandle;
+    int m_lineOfSightRay = -1;
+    int m_leftWhiskerRay = -1;
+    int m_rightWhiskerRay = -1;
+    int m_centerWhiskerRay = -1;
+
     Texture* m_baseTexture = nullptr;
     Texture* m_topTexture = nullptr;
     AABB2 m_tankVertOffsets = AABB2();
-    std::vector<Vertex_PCU> m_tankBaseVerts = {};
-    std::vector<Vertex_PCU> m_tankTopVerts = {};
+    mutable std::vector<Vertex_PCU> m_tankBaseVerts = {};
+    mutable std::vector<Vertex_PCU> m_tankTopVerts = {};
 
     float m_desiredOrientationDegrees = 0.f;
     float m_orientationTopDegrees = 0.f;
     float m_gunCooldown = 0.f;
+    SoundID m_shootSound = MISSING_SOUND_ID; // Looked up at Startup, ShootGun runs on worker threads
 
     void UpdateChaseTarget( float deltaSeconds, float targetDegrees, bool hasLoS );
     void UpdateWanderAround( float deltaSeconds );
-    void UpdateTankVerts();
+    void UpdateTankVerts() const;
     const Vec2 GetForwardVectorTop() const;
     void ShootGun();
 };
@@ -1,11 +1,13 @@
 #include "Game/EnemyTurret.hpp"
 
+#include "Engine/Core/BufferUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 
 #include "Game/Game.hpp"
 #include "Game/Map.hpp"
+#include "Game/StateHash.hpp"
 #include "Game/RaycastResult.hpp"
 
 
@@ -38,10 +40,11 @@ void EnemyTurret::Startup() {
 
     m_baseTexture = g_theRenderer->CreateOrGetTextureFromFile( TEXTURE_ENEMYTURRET_BASE );
     m_topTexture = g_theRenderer->CreateOrGetTextureFromFile( TEXTURE_ENEMYTURRET_TOP );
+    m_shootSound = g_theAudio->CreateOrGetSound( AUDIO_ENEMY_SHOOT );
 
     m_turretVertOffsets = AABB2( Vec2( -ENEMYTURRET_COSMETIC_BOX_OFFSET, -ENEMYTURRET_COSMETIC_BOX_OFFSET ), Vec2( ENEMYTURRET_COSMETIC_BOX_OFFSET, ENEMYTURRET_COSMETIC_BOX_OFFSET ) );
 
-    UpdateTurretVerts();
+    m_areVertsDirty = true;
 }
 
 
@@ -51,27 +54,46 @@ void EnemyTurret::Shutdown() {
 }
 
 
+void EnemyTurret::QueueRaycasts() {
+    Entity* target = m_map->GetOrAcquireTarget( m_targetHandle );
+
+    m_lineOfSightTargetHandle = m_targetHandle;
+    m_lineOfSightRay = -1;
+
+    if( target != nullptr ) {
+        m_lineOfSightRay = m_map->SubmitLineOfSight( (Entity*)this, target );
+    }
+
+    // Laser is aimed where the top faces at the start of the tick
+    m_laserDirection = Vec2::MakeFromPolarDegrees( m_orientationTopDegrees );
+    m_laserRay = m_map->SubmitRaycast( m_position, m_laserDirection, ENEMYTURRET_MAX_SIGHT_RANGE );
+}
+
+
 void EnemyTurret::Update( float deltaSeconds ) {
     m_gunCooldown -= deltaSeconds;
 
-    if( m_target == nullptr || !m_target->IsAlive() ) {
-        m_target = m_map->AcquireNewTarget();
+    const EntityTickState* target = m_map->GetTickState( m_targetHandle ); // Acquired in QueueRaycasts
 
-        if( m_target == nullptr ) {
-            m_orientationTopDegrees += ENEMYTURRET_TOP_TURN_SPEED * deltaSeconds;
-            UpdateTurretVerts();
-            UpdateLaserVerts();
-            return;
-        }
+    if( target == nullptr || !target->isAlive ) {
+        m_orientationTopDegrees += ENEMYTURRET_TOP_TURN_SPEED * deltaSeconds;
+        m_areVertsDirty = true;
+        UpdateLaserVerts();
+        return;
+    }
+
+    bool hasLoS = false;
+
+    if( m_targetHandle == m_lineOfSightTargetHandle ) { // Otherwise the target changed after rays were queued, look next tick
+        hasLoS = !m_map->GetSubmittedRaycastResult( m_lineOfSightRay ).DidImpact();
     }
 
-    bool hasLoS = m_map->HasLineOfSight( (Entity*)this, m_target );
-    Vec2 targetDisplacement = (m_target->GetPosition() - m_position);
+    Vec2 targetDisplacement = (target->position - m_position);
     float targetDegrees = targetDisplacement.GetAngleDegrees();
 
     if( hasLoS && (targetDisplacement.GetLength() < ENEMYTURRET_MAX_SIGHT_RANGE) ) {
         m_scanForTarget = ENEMYTURRET_SCAN_TIME_SECONDS;
-        m_targetLastKnownPosition = m_target->GetPosition();
+        m_targetLastKnownPosition = target->position;
 
         UpdateChaseTarget( deltaSeconds, targetDegrees, hasLoS );
     } else if( m_scanForTarget > 0.f ) {
@@ -94,13 +116,17 @@ void EnemyTurret::Update( float deltaSeconds ) {
         m_orientationTopDegrees += ENEMYTURRET_TOP_TURN_SPEED * deltaSeconds;
     }
 
-    UpdateTurretVerts();
+    m_areVertsDirty = true;
     UpdateLaserVerts();
 
 }
 
 
 void EnemyTurret::Render() const {
+    if( m_areVertsDirty ) {
+        UpdateTurretVerts();
+    }
+
     if( g_theGame->IsDebugDrawingOn() ) {
         g_theRenderer->BindTexture( nullptr );
         g_theRenderer->DrawVertexArray( m_debugCosmeticVerts );
@@ -128,12 +154,60 @@ void EnemyTurret::OnCollisionEntity( Entity* collidingEntity ) {
 }
 
 
-void EnemyTurret::OnCollisionTile( Tile* collidingTile ) {
-    UNUSED( collidingTile );
+void EnemyTurret::OnCollisionTile( const AABB2& tileBounds ) {
+    UNUSED( tileBounds );
     // Not sure yet
 }
 
 
+void EnemyTurret::AddToStateHash( StateHash& hash ) const {
+    Entity::AddToStateHash( hash );
+
+    hash.AddHandle( m_targetHandle );
+    hash.AddFloat( m_scanForTarget );
+    hash.AddVec2( m_targetLastKnownPosition );
+    hash.AddBool( m_scanLeft );
+    hash.AddFloat( m_orientationTopDegrees );
+    hash.AddFloat( m_gunCooldown );
+}
+
+
+void EnemyTurret::WriteSnapshot( BufferWriter& writer ) const {
+    Entity::WriteSnapshot( writer );
+
+    writer.WriteInt32( m_targetHandle.index );
+    writer.WriteUint32( m_targetHandle.generation );
+    writer.WriteFloat( m_scanForTarget );
+    writer.WriteFloat( m_targetLastKnownPosition.x );
+    writer.WriteFloat( m_targetLastKnownPosition.y );
+    writer.WriteBool( m_scanLeft );
+    writer.WriteFloat( m_orientationTopDegrees );
+    writer.WriteFloat( m_gunCooldown );
+}
+
+
+void EnemyTurret::ReadSnapshot( BufferReader& reader ) {
+    Entity::ReadSnapshot( reader );
+
+    m_targetHandle.index = reader.ReadInt32();
+    m_targetHandle.generation = reader.ReadUint32();
+    m_scanForTarget = reader.ReadFloat();
+    m_targetLastKnownPosition.x = reader.ReadFloat();
+    m_targetLastKnownPosition.y = reader.ReadFloat();
+    m_scanLeft = reader.ReadBool();
+    m_orientationTopDegrees = reader.ReadFloat();
+    m_gunCooldown = reader.ReadFloat();
+
+    m_laserVerts.clear(); // Comes from this tick's ray batch, back after the next Update
+}
+
+
+int EnemyTurret::GetSnapshotNumBytes() {
+    // Target handle, scan time, last known position, scan direction, top orientation, gun cooldown
+    return Entity::GetSnapshotNumBytes() + 4 + 4 + 4 + 8 + 1 + 4 + 4;
+}
+
+
 void EnemyTurret::UpdateChaseTarget( float deltaSeconds, float targetDegrees, bool hasLoS ) {
     float maxDD = ENEMYTURRET_TOP_TURN_SPEED * deltaSeconds;
     m_orientationTopDegrees = GetTurnedTowards( m_orientationTopDegrees, targetDegrees, maxDD );
@@ -144,7 +218,7 @@ void EnemyTurret::UpdateChaseTarget( float deltaSeconds, float targetDegrees, bo
 }
 
 
-void EnemyTurret::UpdateTurretVerts() {
+void EnemyTurret::UpdateTurretVerts() const {
     m_turretBaseVerts.clear();
     m_turretTopVerts.clear();
 
@@ -160,20 +234,20 @@ void EnemyTurret::UpdateTurretVerts() {
         UpdateDebugVerts();
     }
 
+    m_areVertsDirty = false;
 }
 
 
 void EnemyTurret::UpdateLaserVerts() {
     m_laserVerts.clear();
 
-    Vec2 direction = Vec2::MakeFromPolarDegrees( m_orientationTopDegrees );
-    RaycastResult raycast = m_map->Raycast( m_position, direction, ENEMYTURRET_MAX_SIGHT_RANGE );
+    const RaycastResult& raycast = m_map->GetSubmittedRaycastResult( m_laserRay );
     Vec2 laserEnd;
 
     if( raycast.DidImpact() ) {
         laserEnd = raycast.impactPosition;
     } else {
-        laserEnd = m_position + (direction * ENEMYTURRET_MAX_SIGHT_RANGE);
+        laserEnd = m_position + (m_laserDirection * ENEMYTURRET_MAX_SIGHT_RANGE);
     }
 
     AddVertsForLine2D( m_laserVerts, m_position, laserEnd, 0.05f, Rgba( 1.f, 0.f, 0.f, 0.75f ) );
@@ -187,8 +261,7 @@ const Vec2 EnemyTurret::GetForwardVectorTop() const {
 
 void EnemyTurret::ShootGun() {
     if( m_gunCooldown <= 0 ) {
-        SoundID shootSound = g_theAudio->CreateOrGetSound( AUDIO_ENEMY_SHOOT );
-        g_theAudio->PlaySound( shootSound );
+        m_map->PlaySound( m_shootSound );
 
         Vec2 barrelPosition = TransformPosition( GetForwardVectorTop(), 0.5f, 0.f, m_position );
         m_map->SpawnNewEntity( ENTITY_TYPE_BULLET, barrelPosition, m_orientationTopDegrees, (Entity*)this );
@@ -18,29 +18,42 @@ class EnemyTurret
     void Startup();
     void Shutdown();
 
+    void QueueRaycasts();
     void Update( float deltaSeconds );
     void Render() const;
 
     void OnCollisionEntity( Entity* collidingEntity );
-    void OnCollisionTile( Tile* collidingTile );
+    void OnCollisionTile( const AABB2& tileBounds );
+
+    void AddToStateHash( StateHash& hash ) const override;
+    void WriteSnapshot( BufferWriter& writer ) const override;
+    void ReadSnapshot( BufferReader& reader ) override;
+    static int GetSnapshotNumBytes();
 
     private:
-    Entity* m_target = nullptr;
+    EntityHandle m_targetHandle;
     float m_scanForTarget = -1.f;
     Vec2 m_targetLastKnownPosition = Vec2::ZERO;
     bool m_scanLeft = true;
 
+    // Indices into the map's ray batch for this tick
+    EntityHandle m_lineOfSightTargetHandle;
+    int m_lineOfSightRay = -1;
+    int m_laserRay = -1;
+    Vec2 m_laserDirection = Vec2::ZERO;
+
     Texture* m_baseTexture = nullptr;
     Texture* m_topTexture = nullptr;
     AABB2 m_turretVertOffsets = AABB2();
-    std::vector<Vertex_PCU> m_turretBaseVerts = {};
-    std::vector<Vertex_PCU> m_turretTopVerts = {};
+    mutable std::vector<Vertex_PCU> m_turretBaseVerts = {};
+    mutable std::vector<Vertex_PCU> m_turretTopVerts = {};
     std::vector<Vertex_PCU> m_laserVerts = {};
     float m_orientationTopDegrees = 0.f;
     float m_gunCooldown = 0.f;
+    SoundID m_shootSound = MISSING_SOUND_ID; // Looked up at Startup, ShootGun runs on worker threads
 
     void UpdateChaseTarget( float deltaSeconds, float targetDegrees, bool hasLoS );
-    void UpdateTurretVerts();
+    void UpdateTurretVerts() const;
     void UpdateLaserVerts();
     const Vec2 GetForwardVectorTop() const;
     void ShootGun();
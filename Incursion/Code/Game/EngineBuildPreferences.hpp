@@ -10,3 +10,10 @@
 
 //#define ENGINE_DISABLE_AUDIO	// (If uncommented) Disables AudioSystem code and fmod linkage.
 
+// The headless target (Main_Headless.cpp) defines GAME_HEADLESS for both the engine and game sources
+#if defined( GAME_HEADLESS )
+#define ENGINE_DISABLE_AUDIO		// AudioSystem loads and plays nothing
+#define ENGINE_DISABLE_INPUT		// XboxControllers never connect
+#define ENGINE_DISABLE_RENDERING	// RenderContext keeps textures and fonts on the CPU and draws nothing
+#endif
+
@@ -1,13 +1,128 @@
 #include "Game/Entity.hpp"
 
+#include "Engine/Core/BufferUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Matrix44.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 
+#include "Game/EntityComponents.hpp"
+#include "Game/StateHash.hpp"
+
 
 Entity::Entity( EntityType type /*= ENTITY_TYPE_UNKNOWN*/, FactionID faction /*= FACTION_UNKNOWN */ ) :
-    m_entityType(type) {
+    m_entityType( type ),
+    m_componentStore( &EntityComponentStore::GetStore( type ) ),
+    m_componentRow( m_componentStore->AllocateRow( this ) ),
+    m_faction( m_componentStore->GetChunk( m_componentRow ).factions[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_position( m_componentStore->GetChunk( m_componentRow ).positions[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_velocity( m_componentStore->GetChunk( m_componentRow ).velocities[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_physicsRadius( m_componentStore->GetChunk( m_componentRow ).physicsRadii[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_health( m_componentStore->GetChunk( m_componentRow ).health[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_isKillable( m_componentStore->GetChunk( m_componentRow ).isKillable[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_isSolid( m_componentStore->GetChunk( m_componentRow ).isSolid[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_isMovable( m_componentStore->GetChunk( m_componentRow ).isMovable[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_isDead( m_componentStore->GetChunk( m_componentRow ).isDead[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_isGarbage( m_componentStore->GetChunk( m_componentRow ).isGarbage[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_restPosition( m_componentStore->GetChunk( m_componentRow ).restPositions[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_numStillTicks( m_componentStore->GetChunk( m_componentRow ).numStillTicks[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_sweepStart( m_componentStore->GetChunk( m_componentRow ).sweepStarts[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_numSweepCorners( m_componentStore->GetChunk( m_componentRow ).numSweepCorners[EntityComponentStore::GetIndexInChunk( m_componentRow )] ),
+    m_isSwept( m_componentStore->GetChunk( m_componentRow ).isSwept[EntityComponentStore::GetIndexInChunk( m_componentRow )] ) {
+    SetFaction( faction );
+}
+
+
+Entity::Entity( const Entity& copyFrom ) :
+    Entity( copyFrom.m_entityType, copyFrom.m_faction ) {
+    m_map = copyFrom.m_map;
+    m_handle = copyFrom.m_handle;
+    m_hitSound = copyFrom.m_hitSound;
+
+    m_position = copyFrom.m_position;
+    m_velocity = copyFrom.m_velocity;
+    m_angularVelocity = copyFrom.m_angularVelocity;
+    m_orientationDegrees = copyFrom.m_orientationDegrees;
+
+    m_previousPosition = copyFrom.m_previousPosition;
+    m_previousOrientationDegrees = copyFrom.m_previousOrientationDegrees;
+    m_hasPreviousTransform = copyFrom.m_hasPreviousTransform;
+
+    m_physicsRadius = copyFrom.m_physicsRadius;
+    m_cosmeticRadius = copyFrom.m_cosmeticRadius;
+
+    m_health = copyFrom.m_health;
+    m_isKillable = copyFrom.m_isKillable;
+    m_isSolid = copyFrom.m_isSolid;
+    m_isMovable = copyFrom.m_isMovable;
+    m_isDead = copyFrom.m_isDead;
+    m_isGarbage = copyFrom.m_isGarbage;
+    m_restPosition = copyFrom.m_restPosition;
+    m_numStillTicks = copyFrom.m_numStillTicks;
+    m_sweepStart = copyFrom.m_sweepStart;
+    m_numSweepCorners = 0; // Rebuilt by the next swept move
+    m_isSwept = copyFrom.m_isSwept;
+
+    m_areVertsDirty = copyFrom.m_areVertsDirty;
+    m_debugCosmeticVerts = copyFrom.m_debugCosmeticVerts;
+    m_debugPhysicsVerts = copyFrom.m_debugPhysicsVerts;
+}
+
+
+Entity::~Entity() {
+    m_componentStore->ReleaseRow( m_componentRow );
+}
+
+
+void Entity::ResetEntity( FactionID faction ) {
+    // Back to freshly constructed state so pooled entities can be reused, map and type are kept
+    m_hitSound = MISSING_SOUND_ID; // Before SetFaction, which picks the faction's hit sound
     SetFaction( faction );
+
+    m_position = Vec2::ZERO;
+    m_velocity = Vec2::ZERO;
+    m_angularVelocity = 0.f;
+    m_orientationDegrees = 0.f;
+    ClearPreviousTransform();
+
+    m_physicsRadius = 0.f;
+    m_cosmeticRadius = 0.f;
+
+    m_health = 1;
+    m_isKillable = true;
+    m_isSolid = true;
+    m_isMovable = true;
+    m_isDead = false;
+    m_isGarbage = false;
+    m_restPosition = Vec2::ZERO;
+    m_numStillTicks = 0;
+    m_sweepStart = Vec2::ZERO;
+    m_numSweepCorners = 0;
+    m_isSwept = false;
+
+    m_areVertsDirty = true;
+    m_debugCosmeticVerts.clear();
+    m_debugPhysicsVerts.clear();
+}
+
+
+void Entity::QueueRaycasts() {
+    // Most entities never raycast
+}
+
+
+EntityComponentStore* Entity::GetComponentStore() const {
+    return m_componentStore;
+}
+
+
+int Entity::GetComponentRow() const {
+    return m_componentRow;
+}
+
+
+const EntityHandle& Entity::GetHandle() const {
+    return m_handle;
 }
 
 
@@ -83,6 +198,105 @@ void Entity::SetFaction( FactionID faction ) {
 }
 
 
+void Entity::StorePreviousTransform() {
+    m_previousPosition = m_position;
+    m_previousOrientationDegrees = m_orientationDegrees;
+    m_hasPreviousTransform = true;
+}
+
+
+void Entity::ClearPreviousTransform() {
+    m_hasPreviousTransform = false;
+}
+
+
+const Matrix44 Entity::GetInterpolationTransform( float tickAlpha ) const {
+    if( !m_hasPreviousTransform ) {
+        return Matrix44();
+    }
+
+    // Rigidly moves verts built at the current transform back toward the previous one by (1 - alpha)
+    float rewindFraction = 1.f - tickAlpha;
+    float rotationDegrees = GetAngulaDisplacement( m_orientationDegrees, m_previousOrientationDegrees ) * rewindFraction;
+    Vec2 renderPosition = m_position + ((m_previousPosition - m_position) * rewindFraction);
+
+    Vec2 iBasis = Vec2::MakeFromPolarDegrees( rotationDegrees );
+    Vec2 jBasis = iBasis.GetRotated90Degrees();
+    Vec2 translation = renderPosition - (iBasis * m_position.x) - (jBasis * m_position.y);
+    return Matrix44( iBasis, jBasis, translation );
+}
+
+
+void Entity::AddToStateHash( StateHash& hash ) const {
+    // Render-only state (verts, previous transform, tint) is left out
+    hash.AddInt( m_entityType );
+    hash.AddInt( m_faction );
+    hash.AddHandle( m_handle );
+    hash.AddVec2( m_position );
+    hash.AddVec2( m_velocity );
+    hash.AddFloat( m_angularVelocity );
+    hash.AddFloat( m_orientationDegrees );
+    hash.AddInt( m_health );
+    hash.AddBool( m_isKillable );
+    hash.AddBool( m_isDead );
+    hash.AddBool( m_isGarbage );
+}
+
+
+void Entity::WriteSnapshot( BufferWriter& writer ) const {
+    writer.WriteUint8( (unsigned char)m_faction );
+    writer.WriteFloat( m_position.x );
+    writer.WriteFloat( m_position.y );
+    writer.WriteFloat( m_velocity.x );
+    writer.WriteFloat( m_velocity.y );
+    writer.WriteFloat( m_angularVelocity );
+    writer.WriteFloat( m_orientationDegrees );
+    writer.WriteInt32( m_health );
+    writer.WriteBool( m_isKillable );
+    writer.WriteBool( m_isSolid );
+    writer.WriteBool( m_isMovable );
+    writer.WriteBool( m_isDead );
+    writer.WriteBool( m_isGarbage );
+    writer.WriteFloat( m_restPosition.x );
+    writer.WriteFloat( m_restPosition.y );
+    writer.WriteInt32( m_numStillTicks );
+}
+
+
+void Entity::ReadSnapshot( BufferReader& reader ) {
+    FactionID faction = (FactionID)(signed char)reader.ReadUint8();
+    if( faction != m_faction ) {
+        SetFaction( faction ); // Looks up the hit sound
+    }
+
+    m_position.x = reader.ReadFloat();
+    m_position.y = reader.ReadFloat();
+    m_sweepStart = m_position; // Not saved, every swept move sets it before collision reads it
+    m_numSweepCorners = 0;
+    m_velocity.x = reader.ReadFloat();
+    m_velocity.y = reader.ReadFloat();
+    m_angularVelocity = reader.ReadFloat();
+    m_orientationDegrees = reader.ReadFloat();
+    m_health = reader.ReadInt32();
+    m_isKillable = reader.ReadBool();
+    m_isSolid = reader.ReadBool();
+    m_isMovable = reader.ReadBool();
+    m_isDead = reader.ReadBool();
+    m_isGarbage = reader.ReadBool();
+    m_restPosition.x = reader.ReadFloat();
+    m_restPosition.y = reader.ReadFloat();
+    m_numStillTicks = reader.ReadInt32();
+
+    m_areVertsDirty = true;
+}
+
+
+int Entity::GetSnapshotNumBytes() {
+    // Faction, position, velocity, angular velocity, orientation, health, five flags, rest position, still ticks
+    return 1 + 8 + 8 + 4 + 4 + 4 + 5 + 8 + 4;
+}
+
+
 void Entity::TakeDamage( int damageToTake ) {
     g_theAudio->PlaySound( m_hitSound );
     m_health -= damageToTake;
@@ -93,12 +307,39 @@ void Entity::TakeDamage( int damageToTake ) {
 }
 
 
+void Entity::StartSweep() {
+    m_sweepStart = m_position;
+    m_numSweepCorners = 0;
+}
+
+
+void Entity::AddSweepCorner( float tickFraction ) {
+    if( m_numSweepCorners >= ENTITY_MAX_SWEEP_CORNERS ) {
+        return;
+    }
+
+    EntityComponentChunk& chunk = m_componentStore->GetChunk( m_componentRow );
+    int indexInChunk = EntityComponentStore::GetIndexInChunk( m_componentRow );
+
+    chunk.sweepCorners[indexInChunk][m_numSweepCorners] = m_position;
+    chunk.sweepCornerFractions[indexInChunk][m_numSweepCorners] = tickFraction;
+    m_numSweepCorners++;
+}
+
+
+int Entity::GetSweepPoints( Vec2* out_points ) const {
+    float tickFractions[ENTITY_MAX_SWEEP_CORNERS + 2];
+    const EntityComponentChunk& chunk = m_componentStore->GetChunk( m_componentRow );
+    return ::GetSweepPoints( chunk, EntityComponentStore::GetIndexInChunk( m_componentRow ), out_points, tickFractions );
+}
+
+
 Vec2 Entity::GetForwardVector() const {
     return Vec2( CosDegrees( m_orientationDegrees ), SinDegrees( m_orientationDegrees ) );
 }
 
 
-void Entity::UpdateDebugVerts() {
+void Entity::UpdateDebugVerts() const {
     m_debugCosmeticVerts.clear();
     m_debugPhysicsVerts.clear();
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "Game/GameCommon.hpp"
+#include "Game/EntityHandle.hpp"
 
 #include "Engine/Audio/AudioSystem.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
@@ -15,7 +16,6 @@ enum EntityType {
     ENTITY_TYPE_ENEMYTURRET,
     ENTITY_TYPE_PLAYERTANK,
     ENTITY_TYPE_BULLET,
-    ENTITY_TYPE_EXPLOSION,
 
     NUM_ENTITY_TYPES
 };
@@ -32,7 +32,13 @@ enum FactionID {
     NUM_FACTIONS
 };
 
-class Tile;
+struct AABB2;
+struct Matrix44;
+class BufferReader;
+class BufferWriter;
+class EntityComponentStore;
+class Map;
+class StateHash;
 
 
 class Entity {
@@ -40,9 +46,12 @@ class Entity {
 
 	public:
     explicit Entity( EntityType type = ENTITY_TYPE_UNKNOWN, FactionID faction = FACTION_UNKNOWN );
+    Entity( const Entity& copyFrom ); // Copy gets its own row, so pools can move entities safely
+    virtual ~Entity(); // Map deletes entities through Entity pointers
 	virtual void Startup() = 0;
 	virtual void Shutdown() = 0;
 
+	virtual void QueueRaycasts();
 	virtual void Update( float deltaSeconds ) = 0;
 	virtual void Render() const = 0;
 
@@ -55,47 +64,86 @@ class Entity {
     bool IsSolid() const;
     bool IsMovable() const;
 
+    const EntityHandle& GetHandle() const;
     const Vec2 GetPosition() const;
     const FactionID GetFaction() const;
     const EntityType GetEntityType() const;
+    EntityComponentStore* GetComponentStore() const;
+    int GetComponentRow() const;
     void GetPhysicsDisc( Vec2& position, float& radius) const;
     void GetCosmeticDist( Vec2& position, float& radius) const;
 
     void SetFaction( FactionID faction );
+
+    // Render interpolation, verts are built at the current tick's transform
+    virtual void StorePreviousTransform();
+    void ClearPreviousTransform(); // Just spawned or teleported, render at the current transform until next tick
+    const Matrix44 GetInterpolationTransform( float tickAlpha ) const;
+
     virtual void OnCollisionEntity( Entity* collidingEntity ) = 0;
-    virtual void OnCollisionTile( Tile* collidingTile ) = 0;
+    virtual void OnCollisionTile( const AABB2& tileBounds ) = 0; // Only called for solid tiles
+
+    virtual void AddToStateHash( StateHash& hash ) const; // Subclasses append their own simulation state
+
+    // Same fields as the state hash, Map writes the type and handle and restores into a freshly started entity
+    virtual void WriteSnapshot( BufferWriter& writer ) const;
+    virtual void ReadSnapshot( BufferReader& reader ); // Only marks the verts dirty, Render rebuilds them
+    static int GetSnapshotNumBytes(); // Every entity of a type writes the same, subclasses add their own fields
 
 	protected:
     const EntityType m_entityType = ENTITY_TYPE_UNKNOWN;
-    FactionID m_faction = FACTION_UNKNOWN;
     Rgba m_factionTint = Rgba::WHITE;
 
     Map* m_map = nullptr;
+    EntityHandle m_handle; // Set by Map while the entity is registered
     SoundID m_hitSound = MISSING_SOUND_ID;
 
-	Vec2 m_position;
-	Vec2 m_velocity;
+    // Hot data lives in the archetype's component store (see EntityComponents.hpp), these are views of this entity's row
+    EntityComponentStore* const m_componentStore = nullptr;
+    const int m_componentRow = -1;
+
+    FactionID& m_faction;
+    Vec2& m_position;
+    Vec2& m_velocity;
 
     float m_angularVelocity = 0;
     float m_orientationDegrees = 0;
 
-    float m_physicsRadius = 0.f;
+    Vec2 m_previousPosition; // Transform at the start of the current tick
+    float m_previousOrientationDegrees = 0.f;
+    bool m_hasPreviousTransform = false;
+
+    float& m_physicsRadius;
 	float m_cosmeticRadius = 0.f;
 
-	int m_health = 1;
-    bool m_isKillable = true;
-    bool m_isSolid = true;
-    bool m_isMovable = true;
+    int& m_health;
+    bool& m_isKillable;
+    bool& m_isSolid;
+    bool& m_isMovable;
+
+    bool& m_isDead;
+    bool& m_isGarbage;
 
-    bool m_isDead = false;
-    bool m_isGarbage = false;
+    Vec2& m_restPosition; // Sleep state, only the collision pass uses it
+    int& m_numStillTicks;
+
+    Vec2& m_sweepStart; // Continuous collision, set by entities that move too far per tick for end position tests
+    int& m_numSweepCorners; // Corners themselves are only reached through the sweep functions
+    bool& m_isSwept;
 
     const Rgba m_debugCosmeticColor = Rgba( 1, 0, 1, 1 );
     const Rgba m_debugPhysicsColor = Rgba( 0, 1, 1, 1 );
 
-    std::vector<Vertex_PCU> m_debugCosmeticVerts;
-    std::vector<Vertex_PCU> m_debugPhysicsVerts;
+    // Verts are rebuilt by Render, so ticks that are never drawn (headless runs, snapshot restores) don't build them
+    mutable bool m_areVertsDirty = true;
+    mutable std::vector<Vertex_PCU> m_debugCosmeticVerts;
+    mutable std::vector<Vertex_PCU> m_debugPhysicsVerts;
 
     Vec2 GetForwardVector() const;
-    void UpdateDebugVerts();
+    void UpdateDebugVerts() const;
+    void ResetEntity( FactionID faction );
+
+    void StartSweep(); // This tick's swept move starts at the current position
+    void AddSweepCorner( float tickFraction ); // Changed heading at the current position, tickFraction into the tick
+    int GetSweepPoints( Vec2* out_points ) const; // Start, corners, then the current position
 };
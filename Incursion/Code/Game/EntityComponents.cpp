@@ -0,0 +1,137 @@
+#include "Game/EntityComponents.hpp"
+
+#include "algorithm"
+#include "functional"
+
+
+int GetSweepPoints( const EntityComponentChunk& chunk, int index, Vec2* out_points, float* out_tickFractions ) {
+    const Vec2& position = chunk.positions[index];
+
+    if( !chunk.isSwept[index] ) {
+        out_points[0] = position;
+        out_tickFractions[0] = 0.f;
+        out_points[1] = position;
+        out_tickFractions[1] = 1.f;
+        return 2;
+    }
+
+    int numPoints = 0;
+    out_points[numPoints] = chunk.sweepStarts[index];
+    out_tickFractions[numPoints] = 0.f;
+    numPoints++;
+
+    int numCorners = chunk.numSweepCorners[index];
+    for( int cornerIndex = 0; cornerIndex < numCorners; cornerIndex++ ) {
+        out_points[numPoints] = chunk.sweepCorners[index][cornerIndex];
+        out_tickFractions[numPoints] = chunk.sweepCornerFractions[index][cornerIndex];
+        numPoints++;
+    }
+
+    out_points[numPoints] = position;
+    out_tickFractions[numPoints] = 1.f;
+    numPoints++;
+
+    return numPoints;
+}
+
+
+const Vec2 GetSweptPosition( const EntityComponentChunk& chunk, int index, float tickFraction ) {
+    Vec2 points[ENTITY_MAX_SWEEP_CORNERS + 2];
+    float tickFractions[ENTITY_MAX_SWEEP_CORNERS + 2];
+    int numPoints = GetSweepPoints( chunk, index, points, tickFractions );
+
+    // Straight and at constant speed between corners
+    for( int pointIndex = 1; pointIndex < numPoints; pointIndex++ ) {
+        float legStart = tickFractions[pointIndex - 1];
+        float legEnd = tickFractions[pointIndex];
+
+        if( tickFraction <= legEnd || pointIndex == numPoints - 1 ) {
+            float legFraction = (legEnd > legStart) ? (tickFraction - legStart) / (legEnd - legStart) : 1.f;
+            return points[pointIndex - 1] + ((points[pointIndex] - points[pointIndex - 1]) * legFraction);
+        }
+    }
+
+    return points[numPoints - 1];
+}
+
+
+EntityComponentStore::~EntityComponentStore() {
+    for( int chunkIndex = 0; chunkIndex < (int)m_chunks.size(); chunkIndex++ ) {
+        delete m_chunks[chunkIndex];
+    }
+
+    m_chunks.clear();
+}
+
+
+EntityComponentStore& EntityComponentStore::GetStore( EntityType type ) {
+    static EntityComponentStore s_stores[NUM_ENTITY_TYPES];
+
+    GUARANTEE_OR_DIE( type >= 0 && type < NUM_ENTITY_TYPES, Stringf( "No component store for entity type (%d)", (int)type ) );
+    return s_stores[type];
+}
+
+
+int EntityComponentStore::AllocateRow( Entity* owner ) {
+    int row = -1;
+
+    if( !m_freeRows.empty() ) {
+        std::pop_heap( m_freeRows.begin(), m_freeRows.end(), std::greater<int>() );
+        row = m_freeRows.back();
+        m_freeRows.pop_back();
+    } else {
+        row = m_numRows;
+        m_numRows++;
+
+        if( row / ENTITY_COMPONENT_CHUNK_SIZE >= (int)m_chunks.size() ) {
+            m_chunks.push_back( new EntityComponentChunk() );
+        }
+    }
+
+    // Same defaults as Entity's in-class values used to be
+    EntityComponentChunk& chunk = GetChunk( row );
+    int index = GetIndexInChunk( row );
+
+    chunk.positions[index] = Vec2::ZERO;
+    chunk.velocities[index] = Vec2::ZERO;
+    chunk.physicsRadii[index] = 0.f;
+    chunk.health[index] = 1;
+    chunk.isKillable[index] = true;
+    chunk.isSolid[index] = true;
+    chunk.isMovable[index] = true;
+    chunk.isDead[index] = false;
+    chunk.isGarbage[index] = false;
+    chunk.factions[index] = FACTION_UNKNOWN;
+    chunk.restPositions[index] = Vec2::ZERO;
+    chunk.numStillTicks[index] = 0;
+    chunk.sweepStarts[index] = Vec2::ZERO;
+    chunk.numSweepCorners[index] = 0;
+    chunk.isSwept[index] = false;
+    chunk.owners[index] = owner;
+
+    return row;
+}
+
+
+void EntityComponentStore::ReleaseRow( int row ) {
+    EntityComponentChunk& chunk = GetChunk( row );
+    chunk.owners[GetIndexInChunk( row )] = nullptr;
+
+    m_freeRows.push_back( row );
+    std::push_heap( m_freeRows.begin(), m_freeRows.end(), std::greater<int>() );
+}
+
+
+int EntityComponentStore::GetNumRows() const {
+    return m_numRows;
+}
+
+
+int EntityComponentStore::GetNumRowsInUse() const {
+    return m_numRows - (int)m_freeRows.size();
+}
+
+
+size_t EntityComponentStore::GetMemoryBytes() const {
+    return m_chunks.size() * sizeof( EntityComponentChunk );
+}
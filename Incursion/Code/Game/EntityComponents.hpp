@@ -0,0 +1,91 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+
+#include "Game/GameCommon.hpp"
+#include "Game/Entity.hpp"
+
+#include "vector"
+
+
+// One chunk of an archetype's hot entity data, stored as structure-of-arrays
+// Passes that only need positions, radii and flags (collision, broadphase) stream these arrays instead of whole entities
+struct EntityComponentChunk {
+    public:
+    Vec2 positions[ENTITY_COMPONENT_CHUNK_SIZE];
+    Vec2 velocities[ENTITY_COMPONENT_CHUNK_SIZE];
+    float physicsRadii[ENTITY_COMPONENT_CHUNK_SIZE];
+    int health[ENTITY_COMPONENT_CHUNK_SIZE];
+    bool isKillable[ENTITY_COMPONENT_CHUNK_SIZE];
+    bool isSolid[ENTITY_COMPONENT_CHUNK_SIZE];
+    bool isMovable[ENTITY_COMPONENT_CHUNK_SIZE];
+    bool isDead[ENTITY_COMPONENT_CHUNK_SIZE];
+    bool isGarbage[ENTITY_COMPONENT_CHUNK_SIZE];
+    FactionID factions[ENTITY_COMPONENT_CHUNK_SIZE];
+    Vec2 restPositions[ENTITY_COMPONENT_CHUNK_SIZE];  // Position at the last collision pass
+    int numStillTicks[ENTITY_COMPONENT_CHUNK_SIZE];   // Asleep at MAP_SLEEP_STILL_TICKS
+    Vec2 sweepStarts[ENTITY_COMPONENT_CHUNK_SIZE];    // Start of this tick's move, swept entities only
+    Vec2 sweepCorners[ENTITY_COMPONENT_CHUNK_SIZE][ENTITY_MAX_SWEEP_CORNERS]; // Where the move changed heading (bounces)
+    float sweepCornerFractions[ENTITY_COMPONENT_CHUNK_SIZE][ENTITY_MAX_SWEEP_CORNERS]; // Fraction of the tick spent before each corner
+    int numSweepCorners[ENTITY_COMPONENT_CHUNK_SIZE];
+    bool isSwept[ENTITY_COMPONENT_CHUNK_SIZE];        // Collides along its whole move instead of at its end position
+    Entity* owners[ENTITY_COMPONENT_CHUNK_SIZE]; // nullptr for free rows
+};
+
+
+// A row's move this tick as straight legs, start, corners, then its current position (non-swept rows just stand there)
+// Returns the number of points, at most ENTITY_MAX_SWEEP_CORNERS + 2
+int GetSweepPoints( const EntityComponentChunk& chunk, int index, Vec2* out_points, float* out_tickFractions );
+const Vec2 GetSweptPosition( const EntityComponentChunk& chunk, int index, float tickFraction );
+
+
+// Hot data for every entity of one EntityType (archetype), one row per entity for its whole life
+// Chunks are never moved or freed while the game runs, so entities keep references into their row
+// Freed rows are reused lowest first, keeping an archetype's live rows packed at the front of its chunks
+class EntityComponentStore {
+    public:
+    EntityComponentStore() {};
+    ~EntityComponentStore();
+
+    static EntityComponentStore& GetStore( EntityType type );
+
+    int AllocateRow( Entity* owner ); // Row starts with the same defaults as a fresh Entity
+    void ReleaseRow( int row );
+
+    int GetNumRows() const; // Rows ever handed out, free ones included
+    int GetNumRowsInUse() const;
+    size_t GetMemoryBytes() const;
+
+    EntityComponentChunk& GetChunk( int row );
+    const EntityComponentChunk& GetChunk( int row ) const;
+    static int GetIndexInChunk( int row );
+
+    private:
+    std::vector<EntityComponentChunk*> m_chunks;
+    std::vector<int> m_freeRows; // Min-heap, so the lowest free row is reused first
+    int m_numRows = 0;
+};
+
+
+// Where an entity's row lives, kept next to the registry's dense entity list
+struct EntityComponentRef {
+    public:
+    EntityComponentStore* store = nullptr;
+    int row = -1;
+    EntityType entityType = ENTITY_TYPE_UNKNOWN; // Type of the store, fits in the padding
+};
+
+
+//-----------------------------------------------------------------------------------------------
+inline EntityComponentChunk& EntityComponentStore::GetChunk( int row ) {
+    return *m_chunks[row / ENTITY_COMPONENT_CHUNK_SIZE];
+}
+
+
+inline const EntityComponentChunk& EntityComponentStore::GetChunk( int row ) const {
+    return *m_chunks[row / ENTITY_COMPONENT_CHUNK_SIZE];
+}
+
+
+inline int EntityComponentStore::GetIndexInChunk( int row ) {
+    return row % ENTITY_COMPONENT_CHUNK_SIZE;
+}
@@ -0,0 +1,19 @@
+#include "Game/EntityHandle.hpp"
+
+
+const EntityHandle EntityHandle::INVALID = EntityHandle();
+
+
+bool EntityHandle::IsValid() const {
+    return (index >= 0);
+}
+
+
+bool EntityHandle::operator==( const EntityHandle& compare ) const {
+    return (index == compare.index && generation == compare.generation);
+}
+
+
+bool EntityHandle::operator!=( const EntityHandle& compare ) const {
+    return !(*this == compare);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+
+// Index into a Map's EntityRegistry plus the slot's generation when the handle was made
+// Reusing a slot bumps its generation, so old handles to that slot stop resolving
+struct EntityHandle {
+    public:
+    int index = -1;
+    unsigned int generation = 0;
+
+    static const EntityHandle INVALID;
+
+    bool IsValid() const;
+
+    bool operator==( const EntityHandle& compare ) const;
+    bool operator!=( const EntityHandle& compare ) const;
+};
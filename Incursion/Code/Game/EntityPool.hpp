@@ -0,0 +1,126 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+
+#include "vector"
+
+
+class Map;
+
+// Fixed-capacity storage for entities that spawn and die constantly
+// Objects are constructed once at Startup and recycled through their Reset path instead of new/delete
+// Acquire returns nullptr when every object is in use, callers fall back to the heap
+template <typename T>
+class EntityPool {
+    public:
+    EntityPool() {};
+    ~EntityPool() {};
+
+    void Startup( Map* map, int capacity );
+    void Shutdown();
+
+    T* Acquire();
+    bool Release( T* object ); // False when the object didn't come from this pool
+
+    int GetCapacity() const;
+    int GetNumInUse() const;
+    int GetHighWaterMark() const;
+    int GetNumExhausted() const;
+
+    private:
+    std::vector<T> m_objects;       // Reserved once at Startup and never grown, so pointers stay valid
+    std::vector<int> m_freeIndices;
+    int m_highWaterMark = 0;
+    int m_numExhausted = 0;         // Acquires that found the pool empty
+};
+
+
+template <typename T>
+void EntityPool<T>::Startup( Map* map, int capacity ) {
+    m_objects.clear();
+    m_objects.reserve( capacity );
+    m_freeIndices.clear();
+    m_freeIndices.reserve( capacity );
+
+    for( int objectIndex = 0; objectIndex < capacity; objectIndex++ ) {
+        m_objects.emplace_back( map );
+    }
+
+    // Hand out low indices first
+    for( int objectIndex = capacity - 1; objectIndex >= 0; objectIndex-- ) {
+        m_freeIndices.push_back( objectIndex );
+    }
+
+    m_highWaterMark = 0;
+    m_numExhausted = 0;
+}
+
+
+template <typename T>
+void EntityPool<T>::Shutdown() {
+    GUARANTEE_RECOVERABLE( GetNumInUse() == 0, Stringf( "EntityPool shutting down with %d objects still in use", GetNumInUse() ) );
+
+    m_objects.clear();
+    m_freeIndices.clear();
+}
+
+
+template <typename T>
+T* EntityPool<T>::Acquire() {
+    if( m_freeIndices.empty() ) {
+        m_numExhausted++;
+        return nullptr;
+    }
+
+    int objectIndex = m_freeIndices.back();
+    m_freeIndices.pop_back();
+
+    int numInUse = GetNumInUse();
+    if( numInUse > m_highWaterMark ) {
+        m_highWaterMark = numInUse;
+    }
+
+    return &m_objects[objectIndex];
+}
+
+
+template <typename T>
+bool EntityPool<T>::Release( T* object ) {
+    if( m_objects.empty() ) {
+        return false;
+    }
+
+    const T* firstObject = m_objects.data();
+    const T* lastObject = firstObject + m_objects.size();
+
+    if( object < firstObject || object >= lastObject ) {
+        return false;
+    }
+
+    int objectIndex = (int)(object - firstObject);
+    m_freeIndices.push_back( objectIndex );
+    return true;
+}
+
+
+template <typename T>
+int EntityPool<T>::GetCapacity() const {
+    return (int)m_objects.size();
+}
+
+
+template <typename T>
+int EntityPool<T>::GetNumInUse() const {
+    return (int)(m_objects.size() - m_freeIndices.size());
+}
+
+
+template <typename T>
+int EntityPool<T>::GetHighWaterMark() const {
+    return m_highWaterMark;
+}
+
+
+template <typename T>
+int EntityPool<T>::GetNumExhausted() const {
+    return m_numExhausted;
+}
@@ -0,0 +1,315 @@
+#include "Game/EntityRegistry.hpp"
+
+#include "Engine/Core/BufferUtils.hpp"
+
+
+// Doubles like push_back would, reserving the exact size every batch would reallocate every batch
+template< typename T >
+static void ReserveAtLeast( std::vector<T>& list, int numElements ) {
+    if( (int)list.capacity() < numElements ) {
+        int doubledCapacity = 2 * (int)list.capacity();
+        list.reserve( (numElements > doubledCapacity) ? numElements : doubledCapacity );
+    }
+}
+
+
+static EntityComponentRef MakeComponentRef( const Entity* entity ) {
+    EntityComponentRef componentRef;
+    componentRef.store = entity->GetComponentStore();
+    componentRef.row = entity->GetComponentRow();
+    componentRef.entityType = entity->GetEntityType();
+    return componentRef;
+}
+
+
+EntityHandle EntityRegistry::AddEntity( Entity* entity ) {
+    int slotIndex = m_firstFreeSlot;
+
+    if( slotIndex >= 0 ) {
+        m_firstFreeSlot = m_slots[slotIndex].nextFreeSlot;
+    } else {
+        slotIndex = (int)m_slots.size();
+        m_slots.push_back( EntitySlot() );
+    }
+
+    EntityType type = entity->GetEntityType();
+
+    EntitySlot& slot = m_slots[slotIndex];
+    slot.entity = entity;
+    slot.denseIndex = (int)m_entities.size();
+    slot.typeDenseIndex = (int)m_entitiesByType[type].size();
+    slot.nextFreeSlot = -1;
+
+    m_entities.push_back( entity );
+    m_entitySlots.push_back( slotIndex );
+    m_entityComponents.push_back( MakeComponentRef( entity ) );
+    m_entitiesByType[type].push_back( entity );
+    m_entitySlotsByType[type].push_back( slotIndex );
+
+    EntityHandle handle;
+    handle.index = slotIndex;
+    handle.generation = slot.generation;
+    return handle;
+}
+
+
+void EntityRegistry::RemoveEntity( const EntityHandle& handle ) {
+    Entity* entity = GetEntity( handle );
+    if( entity == nullptr ) {
+        return;
+    }
+
+    EntitySlot& slot = m_slots[handle.index];
+    EntityType type = entity->GetEntityType();
+
+    // Component refs follow the same swap as the dense list
+    m_entityComponents[slot.denseIndex] = m_entityComponents.back();
+    m_entityComponents.pop_back();
+
+    RemoveFromDenseList( slot.denseIndex, m_entities, m_entitySlots, false );
+    RemoveFromDenseList( slot.typeDenseIndex, m_entitiesByType[type], m_entitySlotsByType[type], true );
+
+    // New generation invalidates every outstanding handle to this slot
+    slot.entity = nullptr;
+    slot.generation++;
+    slot.denseIndex = -1;
+    slot.typeDenseIndex = -1;
+    slot.nextFreeSlot = m_firstFreeSlot;
+    m_firstFreeSlot = handle.index;
+}
+
+
+void EntityRegistry::Clear() {
+    m_slots.clear();
+    m_firstFreeSlot = -1;
+
+    m_entities.clear();
+    m_entitySlots.clear();
+    m_entityComponents.clear();
+
+    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
+        m_entitiesByType[typeIndex].clear();
+        m_entitySlotsByType[typeIndex].clear();
+    }
+}
+
+
+void EntityRegistry::Reserve( int numNewEntities, const int* numNewEntitiesByType ) {
+    ReserveAtLeast( m_slots, (int)m_entities.size() + numNewEntities );
+    ReserveAtLeast( m_entities, (int)m_entities.size() + numNewEntities );
+    ReserveAtLeast( m_entitySlots, (int)m_entitySlots.size() + numNewEntities );
+    ReserveAtLeast( m_entityComponents, (int)m_entityComponents.size() + numNewEntities );
+
+    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
+        int numNewOfType = numNewEntitiesByType[typeIndex];
+        ReserveAtLeast( m_entitiesByType[typeIndex], (int)m_entitiesByType[typeIndex].size() + numNewOfType );
+        ReserveAtLeast( m_entitySlotsByType[typeIndex], (int)m_entitySlotsByType[typeIndex].size() + numNewOfType );
+    }
+}
+
+
+Entity* EntityRegistry::GetEntity( const EntityHandle& handle ) const {
+    if( handle.index < 0 || handle.index >= (int)m_slots.size() ) {
+        return nullptr;
+    }
+
+    const EntitySlot& slot = m_slots[handle.index];
+    if( slot.generation != handle.generation ) {
+        return nullptr;
+    }
+
+    return slot.entity;
+}
+
+
+const EntityList& EntityRegistry::GetEntities() const {
+    return m_entities;
+}
+
+
+const std::vector<EntityComponentRef>& EntityRegistry::GetEntityComponents() const {
+    return m_entityComponents;
+}
+
+
+const EntityList& EntityRegistry::GetEntitiesOfType( EntityType type ) const {
+    return m_entitiesByType[type];
+}
+
+
+int EntityRegistry::GetNumEntities() const {
+    return (int)m_entities.size();
+}
+
+
+int EntityRegistry::GetNumSlots() const {
+    return (int)m_slots.size();
+}
+
+
+void EntityRegistry::WriteSnapshot( BufferWriter& writer ) const {
+    int numSlots = (int)m_slots.size();
+    writer.WriteInt32( numSlots );
+
+    for( int slotIndex = 0; slotIndex < numSlots; slotIndex++ ) {
+        const EntitySlot& slot = m_slots[slotIndex];
+        writer.WriteUint32( slot.generation );
+        writer.WriteInt32( slot.nextFreeSlot );
+    }
+
+    writer.WriteInt32( m_firstFreeSlot );
+
+    // Entities go in dense order so the map can write their data in the same order
+    // Slot lists are copied in bulk, snapshots only move between little-endian machines
+    writer.WriteInt32( (int)m_entitySlots.size() );
+    writer.WriteBytes( m_entitySlots.data(), m_entitySlots.size() * sizeof( int ) );
+
+    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
+        const std::vector<int>& typeSlots = m_entitySlotsByType[typeIndex];
+        writer.WriteInt32( (int)typeSlots.size() );
+        writer.WriteBytes( typeSlots.data(), typeSlots.size() * sizeof( int ) );
+    }
+}
+
+
+bool EntityRegistry::ReadSnapshot( BufferReader& reader ) {
+    Clear();
+
+    int numSlots = reader.ReadInt32();
+    if( !reader.CanRead( numSlots, sizeof( unsigned int ) + sizeof( int ) ) ) {
+        return false;
+    }
+
+    m_slots.resize( numSlots );
+
+    for( int slotIndex = 0; slotIndex < numSlots; slotIndex++ ) {
+        EntitySlot& slot = m_slots[slotIndex];
+        slot.generation = reader.ReadUint32();
+        slot.nextFreeSlot = reader.ReadInt32();
+
+        if( slot.nextFreeSlot < -1 || slot.nextFreeSlot >= numSlots ) {
+            return false;
+        }
+    }
+
+    m_firstFreeSlot = reader.ReadInt32();
+    if( m_firstFreeSlot < -1 || m_firstFreeSlot >= numSlots ) {
+        return false;
+    }
+
+    if( !ReadDenseSlots( reader, m_entities, m_entitySlots, false ) ) {
+        return false;
+    }
+
+    m_entityComponents.assign( m_entities.size(), EntityComponentRef() );
+
+    int numTypedEntities = 0;
+    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
+        if( !ReadDenseSlots( reader, m_entitiesByType[typeIndex], m_entitySlotsByType[typeIndex], true ) ) {
+            return false;
+        }
+
+        numTypedEntities += (int)m_entitySlotsByType[typeIndex].size();
+    }
+
+    // Every entity must be in exactly one type list
+    return (numTypedEntities == (int)m_entitySlots.size()) && !reader.HasOverrun();
+}
+
+
+bool EntityRegistry::CanRestoreEntity( int denseIndex, const EntityHandle& handle, EntityType type ) const {
+    // Entities are saved in dense order, so each one must be the slot listed at its position
+    if( denseIndex < 0 || denseIndex >= (int)m_entitySlots.size() || m_entitySlots[denseIndex] != handle.index ) {
+        return false;
+    }
+
+    if( type < 0 || type >= NUM_ENTITY_TYPES ) {
+        return false;
+    }
+
+    const EntitySlot& slot = m_slots[handle.index];
+    const std::vector<int>& typeSlots = m_entitySlotsByType[type];
+
+    if( slot.generation != handle.generation || slot.typeDenseIndex < 0 || slot.typeDenseIndex >= (int)typeSlots.size() ) {
+        return false;
+    }
+
+    return (typeSlots[slot.typeDenseIndex] == handle.index); // Otherwise the slot was saved under a different type
+}
+
+
+bool EntityRegistry::RestoreEntity( Entity* entity ) {
+    const EntityHandle& handle = entity->GetHandle();
+    if( handle.index < 0 || handle.index >= (int)m_slots.size() ) {
+        return false;
+    }
+
+    EntitySlot& slot = m_slots[handle.index];
+    if( slot.generation != handle.generation || slot.entity != nullptr || slot.denseIndex < 0 ) {
+        return false;
+    }
+
+    EntityType type = entity->GetEntityType();
+    std::vector<int>& typeSlots = m_entitySlotsByType[type];
+
+    if( slot.typeDenseIndex < 0 || slot.typeDenseIndex >= (int)typeSlots.size() || typeSlots[slot.typeDenseIndex] != handle.index ) {
+        return false; // Slot was saved under a different type
+    }
+
+    slot.entity = entity;
+    m_entities[slot.denseIndex] = entity;
+    m_entityComponents[slot.denseIndex] = MakeComponentRef( entity );
+    m_entitiesByType[type][slot.typeDenseIndex] = entity;
+    return true;
+}
+
+
+void EntityRegistry::RemoveFromDenseList( int denseIndex, EntityList& entities, std::vector<int>& entitySlots, bool isTypeList ) {
+    int lastIndex = (int)entities.size() - 1;
+
+    if( denseIndex != lastIndex ) {
+        // Swap the last entity into the gap and point its slot at the new spot
+        entities[denseIndex] = entities[lastIndex];
+        entitySlots[denseIndex] = entitySlots[lastIndex];
+
+        EntitySlot& movedSlot = m_slots[entitySlots[denseIndex]];
+        if( isTypeList ) {
+            movedSlot.typeDenseIndex = denseIndex;
+        } else {
+            movedSlot.denseIndex = denseIndex;
+        }
+    }
+
+    entities.pop_back();
+    entitySlots.pop_back();
+}
+
+
+bool EntityRegistry::ReadDenseSlots( BufferReader& reader, EntityList& entities, std::vector<int>& entitySlots, bool isTypeList ) {
+    int numEntities = reader.ReadInt32();
+    if( numEntities > (int)m_slots.size() || !reader.CanRead( numEntities, sizeof( int ) ) ) {
+        return false;
+    }
+
+    entitySlots.resize( numEntities );
+    reader.ReadBytes( entitySlots.data(), numEntities * sizeof( int ) );
+    entities.assign( numEntities, nullptr );
+
+    for( int denseIndex = 0; denseIndex < numEntities; denseIndex++ ) {
+        int slotIndex = entitySlots[denseIndex];
+        if( slotIndex < 0 || slotIndex >= (int)m_slots.size() ) {
+            return false;
+        }
+
+        EntitySlot& slot = m_slots[slotIndex];
+        int& slotDenseIndex = isTypeList ? slot.typeDenseIndex : slot.denseIndex;
+
+        if( slotDenseIndex >= 0 ) {
+            return false; // Same slot listed twice
+        }
+
+        slotDenseIndex = denseIndex;
+    }
+
+    return !reader.HasOverrun();
+}
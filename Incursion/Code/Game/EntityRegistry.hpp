@@ -0,0 +1,59 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/Entity.hpp"
+#include "Game/EntityComponents.hpp"
+#include "Game/EntityHandle.hpp"
+
+#include "vector"
+
+
+class BufferReader;
+class BufferWriter;
+
+// Slot map of every entity on a Map
+// Add, Remove and GetEntity are O(1), entities live in dense lists (all and per type) with no holes
+// Removing swaps the last entity into the gap, so iterate backwards when removing during a loop
+class EntityRegistry {
+    public:
+    EntityRegistry() {};
+    ~EntityRegistry() {};
+
+    EntityHandle AddEntity( Entity* entity );
+    void Reserve( int numNewEntities, const int* numNewEntitiesByType ); // Grows capacity ahead of a batch of adds
+    void RemoveEntity( const EntityHandle& handle );
+    void Clear();
+
+    Entity* GetEntity( const EntityHandle& handle ) const;
+    const EntityList& GetEntities() const;
+    const std::vector<EntityComponentRef>& GetEntityComponents() const; // Same order as GetEntities
+    const EntityList& GetEntitiesOfType( EntityType type ) const;
+    int GetNumEntities() const;
+    int GetNumSlots() const; // Every handle index is below this
+
+    // Snapshots keep slot generations, the free list and both dense orders, so saved handles resolve after a restore
+    void WriteSnapshot( BufferWriter& writer ) const;
+    bool ReadSnapshot( BufferReader& reader ); // Clears, then rebuilds the layout with empty entries
+    bool CanRestoreEntity( int denseIndex, const EntityHandle& handle, EntityType type ) const; // Whether a saved entity fits the layout read last
+    bool RestoreEntity( Entity* entity ); // Fills the entry for the entity's handle, false if it doesn't fit the layout
+
+    private:
+    struct EntitySlot {
+        Entity* entity = nullptr;
+        unsigned int generation = 0;
+        int denseIndex = -1;
+        int typeDenseIndex = -1;
+        int nextFreeSlot = -1;
+    };
+
+    std::vector<EntitySlot> m_slots;
+    int m_firstFreeSlot = -1;
+
+    EntityList m_entities;                          // Dense, every entity
+    std::vector<int> m_entitySlots;                 // Slot index for each entry of m_entities
+    std::vector<EntityComponentRef> m_entityComponents; // Component row for each entry of m_entities
+    EntityList m_entitiesByType[NUM_ENTITY_TYPES];  // Dense, one list per type
+    std::vector<int> m_entitySlotsByType[NUM_ENTITY_TYPES];
+
+    void RemoveFromDenseList( int denseIndex, EntityList& entities, std::vector<int>& entitySlots, bool isTypeList );
+    bool ReadDenseSlots( BufferReader& reader, EntityList& entities, std::vector<int>& entitySlots, bool isTypeList );
+};
@@ -0,0 +1,304 @@
+#include "Game/FlowField.hpp"
+
+#include "Game/Map.hpp"
+
+#include "algorithm"
+
+
+void FlowField::Startup( const IntVec2& dimensions ) {
+    m_dimensions = dimensions;
+    m_goalTileIndex = -1;
+    m_distances.assign( m_dimensions.x * m_dimensions.y, FLOW_FIELD_UNREACHABLE );
+    m_openTiles.reserve( m_distances.size() );
+}
+
+
+void FlowField::Shutdown() {
+    m_goalTileIndex = -1;
+    m_distances.clear();
+    m_seedTiles.clear();
+    m_openTiles.clear();
+    m_invalidTiles.clear();
+    m_invalidDistances.clear();
+}
+
+
+void FlowField::SetGoal( const Map& map, int goalTileIndex ) {
+    if( goalTileIndex == m_goalTileIndex ) {
+        return;
+    }
+
+    m_goalTileIndex = goalTileIndex;
+    std::fill( m_distances.begin(), m_distances.end(), FLOW_FIELD_UNREACHABLE );
+
+    m_distances[m_goalTileIndex] = 0;
+    m_seedTiles.clear();
+    m_seedTiles.push_back( m_goalTileIndex );
+    Propagate( map );
+
+    m_numRebuilds++;
+}
+
+
+void FlowField::ClearGoal() {
+    if( m_goalTileIndex < 0 ) {
+        return;
+    }
+
+    m_goalTileIndex = -1;
+    std::fill( m_distances.begin(), m_distances.end(), FLOW_FIELD_UNREACHABLE );
+}
+
+
+void FlowField::OnTileChanged( const Map& map, int tileIndex ) {
+    if( m_goalTileIndex < 0 ) {
+        return;
+    }
+
+    if( tileIndex == m_goalTileIndex ) {
+        m_goalTileIndex = -1;
+        SetGoal( map, tileIndex );
+        return;
+    }
+
+    m_numRepairs++;
+    m_seedTiles.clear();
+
+    if( !map.IsTileSolid( tileIndex ) ) {
+        // Opened, distances can only drop, so spread out from the new tile
+        int bestNeighborDistance = GetBestNeighborDistance( tileIndex );
+
+        if( bestNeighborDistance != FLOW_FIELD_UNREACHABLE && bestNeighborDistance + 1 < m_distances[tileIndex] ) {
+            m_distances[tileIndex] = bestNeighborDistance + 1;
+            m_seedTiles.push_back( tileIndex );
+            Propagate( map );
+        }
+
+        return;
+    }
+
+    if( m_distances[tileIndex] == FLOW_FIELD_UNREACHABLE ) {
+        return; // Nothing was walking through it
+    }
+
+    // Closed, every tile one step further than a lost tile may have walked through it, forget them all
+    m_invalidTiles.clear();
+    m_invalidDistances.clear();
+    m_invalidTiles.push_back( tileIndex );
+    m_invalidDistances.push_back( m_distances[tileIndex] );
+    m_distances[tileIndex] = FLOW_FIELD_UNREACHABLE;
+
+    for( int invalidIndex = 0; invalidIndex < (int)m_invalidTiles.size(); invalidIndex++ ) {
+        int invalidTile = m_invalidTiles[invalidIndex];
+        int dependentDistance = m_invalidDistances[invalidIndex] + 1;
+        int tileX = invalidTile % m_dimensions.x;
+        int tileY = invalidTile / m_dimensions.x;
+
+        const int neighborTiles[4] = {
+            (tileX > 0) ? invalidTile - 1 : -1,
+            (tileX < m_dimensions.x - 1) ? invalidTile + 1 : -1,
+            (tileY > 0) ? invalidTile - m_dimensions.x : -1,
+            (tileY < m_dimensions.y - 1) ? invalidTile + m_dimensions.x : -1
+        };
+
+        for( int neighborIndex = 0; neighborIndex < 4; neighborIndex++ ) {
+            int neighborTile = neighborTiles[neighborIndex];
+
+            if( neighborTile >= 0 && m_distances[neighborTile] == dependentDistance ) {
+                m_invalidTiles.push_back( neighborTile );
+                m_invalidDistances.push_back( dependentDistance );
+                m_distances[neighborTile] = FLOW_FIELD_UNREACHABLE;
+            }
+        }
+    }
+
+    // Refill the hole from the tiles around it that kept their distance
+    int numInvalid = (int)m_invalidTiles.size();
+    for( int invalidIndex = 1; invalidIndex < numInvalid; invalidIndex++ ) {
+        int invalidTile = m_invalidTiles[invalidIndex];
+        int bestNeighborDistance = GetBestNeighborDistance( invalidTile );
+
+        if( bestNeighborDistance != FLOW_FIELD_UNREACHABLE ) {
+            m_distances[invalidTile] = bestNeighborDistance + 1;
+            m_seedTiles.push_back( invalidTile );
+        }
+    }
+
+    Propagate( map );
+}
+
+
+void FlowField::OnTilesChanged( const Map& map ) {
+    if( m_goalTileIndex < 0 ) {
+        return;
+    }
+
+    int goalTileIndex = m_goalTileIndex;
+    m_goalTileIndex = -1;
+    SetGoal( map, goalTileIndex );
+}
+
+
+int FlowField::GetGoalTileIndex() const {
+    return m_goalTileIndex;
+}
+
+
+int FlowField::GetDistance( int tileIndex ) const {
+    return m_distances[tileIndex];
+}
+
+
+int FlowField::GetNumRebuilds() const {
+    return m_numRebuilds;
+}
+
+
+int FlowField::GetNumRepairs() const {
+    return m_numRepairs;
+}
+
+
+size_t FlowField::GetMemoryBytes() const {
+    size_t scratchCapacity = m_seedTiles.capacity() + m_openTiles.capacity() + m_invalidTiles.capacity() + m_invalidDistances.capacity();
+    return (m_distances.capacity() + scratchCapacity) * sizeof( int );
+}
+
+
+bool FlowField::GetFlowDirection( const Vec2& position, Vec2& out_direction, int& out_distance ) const {
+    if( m_goalTileIndex < 0 ) {
+        return false;
+    }
+
+    int tileX = (int)floorf( position.x );
+    int tileY = (int)floorf( position.y );
+
+    if( tileX < 0 || tileX >= m_dimensions.x || tileY < 0 || tileY >= m_dimensions.y ) {
+        return false;
+    }
+
+    int distance = m_distances[(tileY * m_dimensions.x) + tileX];
+    if( distance == FLOW_FIELD_UNREACHABLE || distance == 0 ) {
+        return false;
+    }
+
+    // Orthogonal first, so ties go to the straight step
+    static const int numOffsets = 8;
+    static const IntVec2 offsets[numOffsets] = {
+        IntVec2(  0,  1 ), // North
+        IntVec2(  0, -1 ), // South
+        IntVec2( -1,  0 ), // West
+        IntVec2(  1,  0 ), // East
+        IntVec2( -1,  1 ), // Northwest
+        IntVec2(  1,  1 ), // Northeast
+        IntVec2( -1, -1 ), // Southwest
+        IntVec2(  1, -1 )  // Southeast
+    };
+
+    int bestDistance = distance;
+    IntVec2 bestTile = IntVec2( -1, -1 );
+
+    for( int offsetIndex = 0; offsetIndex < numOffsets; offsetIndex++ ) {
+        int neighborX = tileX + offsets[offsetIndex].x;
+        int neighborY = tileY + offsets[offsetIndex].y;
+
+        if( neighborX < 0 || neighborX >= m_dimensions.x || neighborY < 0 || neighborY >= m_dimensions.y ) {
+            continue;
+        }
+
+        int neighborDistance = m_distances[(neighborY * m_dimensions.x) + neighborX];
+
+        // Diagonals only past two open corners, tanks can't squeeze between walls touching at a corner
+        if( offsetIndex >= 4 ) {
+            bool isCornerXOpen = m_distances[(tileY * m_dimensions.x) + neighborX] != FLOW_FIELD_UNREACHABLE;
+            bool isCornerYOpen = m_distances[(neighborY * m_dimensions.x) + tileX] != FLOW_FIELD_UNREACHABLE;
+
+            if( !isCornerXOpen || !isCornerYOpen ) {
+                continue;
+            }
+        }
+
+        if( neighborDistance < bestDistance ) {
+            bestDistance = neighborDistance;
+            bestTile = IntVec2( neighborX, neighborY );
+        }
+    }
+
+    if( bestTile.x < 0 ) {
+        return false;
+    }
+
+    Vec2 bestTileCenter = Vec2( (float)bestTile.x + 0.5f, (float)bestTile.y + 0.5f );
+    out_direction = (bestTileCenter - position).GetNormalized();
+    out_distance = distance;
+    return true;
+}
+
+
+void FlowField::Propagate( const Map& map ) {
+    // Every step costs one, so merging the seeds in distance order with the BFS queue keeps both sorted
+    //  and each tile's first distance is its final one
+    const std::vector<int>& distances = m_distances;
+    std::sort( m_seedTiles.begin(), m_seedTiles.end(), [&distances]( int tileA, int tileB ) {
+        return (distances[tileA] != distances[tileB]) ? (distances[tileA] < distances[tileB]) : (tileA < tileB);
+    } );
+
+    m_openTiles.clear();
+    int numSeeds = (int)m_seedTiles.size();
+    int seedIndex = 0;
+    int openIndex = 0;
+
+    while( seedIndex < numSeeds || openIndex < (int)m_openTiles.size() ) {
+        int tileIndex;
+
+        if( openIndex == (int)m_openTiles.size() || (seedIndex < numSeeds && m_distances[m_seedTiles[seedIndex]] <= m_distances[m_openTiles[openIndex]]) ) {
+            tileIndex = m_seedTiles[seedIndex++];
+        } else {
+            tileIndex = m_openTiles[openIndex++];
+        }
+
+        int nextDistance = m_distances[tileIndex] + 1;
+        int tileX = tileIndex % m_dimensions.x;
+        int tileY = tileIndex / m_dimensions.x;
+
+        const int neighborTiles[4] = {
+            (tileX > 0) ? tileIndex - 1 : -1,
+            (tileX < m_dimensions.x - 1) ? tileIndex + 1 : -1,
+            (tileY > 0) ? tileIndex - m_dimensions.x : -1,
+            (tileY < m_dimensions.y - 1) ? tileIndex + m_dimensions.x : -1
+        };
+
+        for( int neighborIndex = 0; neighborIndex < 4; neighborIndex++ ) {
+            int neighborTile = neighborTiles[neighborIndex];
+
+            if( neighborTile >= 0 && m_distances[neighborTile] > nextDistance && !map.IsTileSolid( neighborTile ) ) {
+                m_distances[neighborTile] = nextDistance;
+                m_openTiles.push_back( neighborTile );
+            }
+        }
+    }
+}
+
+
+int FlowField::GetBestNeighborDistance( int tileIndex ) const {
+    int tileX = tileIndex % m_dimensions.x;
+    int tileY = tileIndex / m_dimensions.x;
+    int bestDistance = FLOW_FIELD_UNREACHABLE;
+
+    const int neighborTiles[4] = {
+        (tileX > 0) ? tileIndex - 1 : -1,
+        (tileX < m_dimensions.x - 1) ? tileIndex + 1 : -1,
+        (tileY > 0) ? tileIndex - m_dimensions.x : -1,
+        (tileY < m_dimensions.y - 1) ? tileIndex + m_dimensions.x : -1
+    };
+
+    for( int neighborIndex = 0; neighborIndex < 4; neighborIndex++ ) {
+        int neighborTile = neighborTiles[neighborIndex];
+
+        if( neighborTile >= 0 && m_distances[neighborTile] < bestDistance ) {
+            bestDistance = m_distances[neighborTile];
+        }
+    }
+
+    return bestDistance;
+}
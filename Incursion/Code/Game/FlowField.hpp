@@ -0,0 +1,54 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+
+#include "Game/GameCommon.hpp"
+
+#include "vector"
+
+
+class Map;
+
+// Walking distance in tiles from every tile to one goal tile, shared by every agent heading there
+// Built by BFS over the open tiles, rebuilt when the goal moves to another tile and repaired locally when a tile changes
+// Distances depend only on the tiles and the goal, never on how the field got there, so rewinds and repairs agree
+class FlowField {
+    public:
+    FlowField() {};
+    ~FlowField() {};
+
+    void Startup( const IntVec2& dimensions );
+    void Shutdown();
+
+    void SetGoal( const Map& map, int goalTileIndex ); // Full rebuild, only when the goal is a different tile
+    void ClearGoal(); // Nothing to follow, every lookup fails
+    void OnTileChanged( const Map& map, int tileIndex ); // Call after the tile's solidity changes
+    void OnTilesChanged( const Map& map ); // Call after many tiles changed at once, one rebuild instead of a repair per tile
+
+    int GetGoalTileIndex() const;
+    int GetDistance( int tileIndex ) const; // FLOW_FIELD_UNREACHABLE if the goal can't be walked to
+    int GetNumRebuilds() const;
+    int GetNumRepairs() const;
+    size_t GetMemoryBytes() const; // Distances plus the scratch lists, all sized by the map
+
+    // Toward the center of the neighboring tile (diagonals too, without cutting corners) closest to the goal
+    // O(1), false on the goal tile or where the goal can't be reached
+    bool GetFlowDirection( const Vec2& position, Vec2& out_direction, int& out_distance ) const;
+
+    private:
+    IntVec2 m_dimensions = IntVec2( 0, 0 );
+    int m_goalTileIndex = -1;
+    std::vector<int> m_distances;
+
+    // Scratch, kept between updates so they don't allocate
+    std::vector<int> m_seedTiles;
+    std::vector<int> m_openTiles;
+    std::vector<int> m_invalidTiles;
+    std::vector<int> m_invalidDistances;
+
+    int m_numRebuilds = 0;
+    int m_numRepairs = 0;
+
+    void Propagate( const Map& map ); // BFS out from m_seedTiles, only ever lowers distances
+    int GetBestNeighborDistance( int tileIndex ) const;
+};
@@ -1,10 +1,12 @@
 #include "Game/Game.hpp"
 
 #include "Engine/Audio/AudioSystem.hpp"
+#include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Core/Time.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/RawNoise.hpp"
 #include "Engine/Math/RNG.hpp"
 #include "Engine/Renderer/BitmapFont.hpp"
 #include "Engine/Renderer/Camera.hpp"
@@ -16,8 +18,11 @@
 #include "Game/PlayerTank.hpp"
 #include "Game/TileDef.hpp"
 
+#include "limits.h"
 
-Game::Game( bool doPreLoading /*= true */ ) {
+
+Game::Game( bool doPreLoading /*= true */, int startingMapIndex /*= 0 */ ) :
+    m_startingMapIndex( startingMapIndex ) {
     if( !doPreLoading ) {
         m_loadingState = LOADING_COMPLETE;
         m_onAttractScreen = false;
@@ -44,6 +49,12 @@ void Game::Startup() {
 
 
 void Game::Shutdown() {
+    if( m_inputReplay.IsRecording() ) {
+        m_inputReplay.StopRecording( GetStateHash() );
+    }
+
+    StopInputReplay();
+
     int numMaps = (int)m_maps.size();
 
     for( int mapIndex = 0; mapIndex < numMaps; mapIndex++ ) {
@@ -61,6 +72,8 @@ void Game::Shutdown() {
 
 
 void Game::Update( float deltaSeconds ) {
+    UpdateInputReplay( deltaSeconds );
+
     if( m_isPaused ) {
         deltaSeconds = 0.f;
     }
@@ -93,6 +106,8 @@ void Game::Update( float deltaSeconds ) {
             ReturnToAttractScreen();
         }
     } else {
+        m_previousPlayerCamera = *m_playerCamera;
+        m_hasPreviousPlayerCamera = true;
         UpdateGame( deltaSeconds );
 
         if( m_onAttractScreen ) {
@@ -101,6 +116,7 @@ void Game::Update( float deltaSeconds ) {
         }
 
         UpdateCameraPosition( deltaSeconds );
+        UpdateDebugStats();
 
         if( m_isPaused ) {
             const Camera& activeCamera = GetActiveCamera();
@@ -135,7 +151,7 @@ void Game::Update( float deltaSeconds ) {
 }
 
 
-void Game::Render() const {
+void Game::Render( float tickAlpha /*= 1.f*/ ) const {
 
     Camera activeCamera = GetActiveCamera();
     g_theRenderer->BeginCamera( activeCamera );
@@ -147,7 +163,20 @@ void Game::Render() const {
     } else if( m_onEndScreen ) {
         RenderEndScreen();
     } else {
-        RenderGame();
+        Camera renderCamera = GetRenderCamera( tickAlpha );
+        g_theRenderer->BeginCamera( renderCamera );
+        RenderGame( tickAlpha );
+        g_theRenderer->EndCamera( renderCamera );
+
+        // Overlays are built against the current camera
+        g_theRenderer->BeginCamera( activeCamera );
+
+        if( m_debugDrawing ) {
+            const BitmapFont* font = g_theRenderer->CreateOrGetBitmapFontFromFile( FONT_NAME_SQUIRREL );
+
+            g_theRenderer->BindTexture( font->GetTexture() );
+            g_theRenderer->DrawVertexArray( (int)m_debugStatsVerts.size(), m_debugStatsVerts.data() );
+        }
 
         if( m_isPaused ) {
             g_theRenderer->BindTexture( nullptr );
@@ -175,6 +204,13 @@ void Game::SetCameraShakeAmount( float newCameraShakeAmount ) {
 
 
 bool Game::HandleKeyPressed( unsigned char keyCode ) {
+    if( m_inputReplay.IsReplaying() && !m_isDispatchingReplayKeys ) {
+        // Replay is driving the game, live keys would make it diverge
+        return 0;
+    }
+
+    m_inputReplay.RecordKeyPressed( keyCode );
+
 	switch( keyCode ) {
         case(0x1B): { // Escape Key
             if( m_onAttractScreen ) {
@@ -206,6 +242,24 @@ bool Game::HandleKeyPressed( unsigned char keyCode ) {
                 m_useDebugCamera = false;
             }
             return 0;
+        } case(0x74): { // F5 - Run Benchmarks
+            if( !m_onAttractScreen && !m_onEndScreen ) {
+                RunBenchmarks();
+            }
+            return 0;
+        } case(0x75): { // F6 - Quick Save Map Snapshot
+            if( !m_onAttractScreen && !m_onEndScreen ) {
+                m_activeMap->SaveSnapshot( m_quickSnapshot );
+                m_quickSnapshotMap = m_activeMap;
+            }
+            return 0;
+        } case(0x76): { // F7 - Rewind to Quick Save
+            if( !m_onAttractScreen && !m_onEndScreen && m_quickSnapshotMap == m_activeMap ) {
+                if( m_activeMap->RestoreSnapshot( m_quickSnapshot ) ) {
+                    m_hasPreviousPlayerCamera = false; // Jump, don't blend back from where the players were
+                }
+            }
+            return 0;
         } case(0x79): { // F10 - Go to Previous Level
             // not implemented yet
             return 0;
@@ -342,6 +396,51 @@ GameMode Game::GetGameMode() const {
 }
 
 
+const Map* Game::GetActiveMap() const {
+    return m_activeMap;
+}
+
+
+bool Game::IsDeterministic() const {
+    return m_isDeterministic;
+}
+
+
+unsigned int Game::GetStateHash() const {
+    return m_activeMap->GetRollingStateHash();
+}
+
+
+const InputReplay& Game::GetInputReplay() const {
+    return m_inputReplay;
+}
+
+
+bool Game::StopInputReplay() {
+    if( !m_inputReplay.IsReplaying() ) {
+        return false;
+    }
+
+    int currentTick = m_inputReplay.GetCurrentTick();
+    int numTicks = m_inputReplay.GetNumTicks();
+    bool didMatch = false;
+
+    if( currentTick < numTicks ) {
+        DebuggerPrintf( "InputReplay: Stopped %s at tick %d of %d, state hash not checked\n", m_inputReplay.GetFilePath().c_str(), currentTick, numTicks );
+    } else {
+        unsigned int stateHash = GetStateHash();
+        unsigned int recordedHash = m_inputReplay.GetFinalStateHash();
+        didMatch = (stateHash == recordedHash);
+
+        DebuggerPrintf( "InputReplay: Replayed %d ticks from %s, state hash %08x %s recorded %08x\n", numTicks, m_inputReplay.GetFilePath().c_str(), stateHash, didMatch ? "matches" : "DIVERGED from", recordedHash );
+    }
+
+    m_inputReplay.StopReplay();
+    g_theInput->SetControllerPlayback( false );
+    return didMatch;
+}
+
+
 void Game::StartNextMap() {
     if( m_activeMap == m_maps.back() ) {
         if( !m_hasBeatenTheGame ) {
@@ -363,6 +462,7 @@ void Game::StartNextMap() {
 
             m_activeMap = nextMap;
             m_activeMap->Startup();
+            m_hasPreviousPlayerCamera = false;
             return;
         }
     }
@@ -403,6 +503,9 @@ void Game::StartupGame() {
     m_extrasSprites = new SpriteSheet( m_extrasTexture, IntVec2( 4, 4 ) );
 
     m_hasBeatenTheGame = false;
+    m_hasPreviousPlayerCamera = false;
+    m_quickSnapshot.clear();
+    m_quickSnapshotMap = nullptr;
 
     // Map Definitions
     std::map<TileType, float> tileFractions = {
@@ -438,7 +541,42 @@ void Game::StartupGame() {
     m_maps.push_back( map0 );
     m_maps.push_back( map1 );
     m_maps.push_back( map2 );
-    m_activeMap = m_maps[0];
+
+    // Each map gets its own RNG so a map's layout and AI never depend on what ran before it
+    m_isDeterministic = g_theGameConfigBlackboard.GetValue( "deterministic", false );
+    std::string replayPath = g_theGameConfigBlackboard.GetValue( "replayInput", "" );
+    std::string recordPath = g_theGameConfigBlackboard.GetValue( "recordInput", "" );
+
+    if( !replayPath.empty() && m_inputReplay.StartReplay( replayPath ) ) {
+        // Replays start from the recorded seed and map and take over the controllers
+        m_isDeterministic = true;
+        m_gameSeed = m_inputReplay.GetSeed();
+        m_startingMapIndex = m_inputReplay.GetStartingMapIndex();
+        g_theInput->SetControllerPlayback( true );
+
+        for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+            g_theInput->ApplyControllerState( controllerIndex, m_inputReplay.GetInitialControllerState( controllerIndex ) );
+        }
+    } else if( m_isDeterministic ) {
+        m_gameSeed = (unsigned int)g_theGameConfigBlackboard.GetValue( "seed", GAME_DEFAULT_SEED );
+    } else {
+        m_gameSeed = (unsigned int)g_RNG->GetRandomIntLessThan( INT_MAX );
+    }
+
+    if( !m_inputReplay.IsReplaying() && !recordPath.empty() ) {
+        // Hashing on so the replay can check it ends in the same state
+        m_isDeterministic = true;
+        m_inputReplay.StartRecording( recordPath, m_gameSeed, m_startingMapIndex, *g_theInput );
+    }
+
+    for( int mapIndex = 0; mapIndex < (int)m_maps.size(); mapIndex++ ) {
+        m_maps[mapIndex]->SetSeed( Get1dNoiseUint( mapIndex, m_gameSeed ) );
+        m_maps[mapIndex]->SetStateHashingEnabled( m_isDeterministic );
+    }
+
+    int numMaps = (int)m_maps.size();
+    GUARANTEE_RECOVERABLE( m_startingMapIndex >= 0 && m_startingMapIndex < numMaps, Stringf( "Starting map index %d out of range", m_startingMapIndex ) );
+    m_activeMap = m_maps[ClampInt( m_startingMapIndex, 0, numMaps - 1 )];
 
     if( m_attractAudioID != MISSING_SOUND_ID ) {
         g_theAudio->StopSound( m_attractAudioID );
@@ -609,6 +747,39 @@ void Game::UpdateGame( float deltaSeconds ) {
 }
 
 
+void Game::UpdateInputReplay( float deltaSeconds ) {
+    if( m_inputReplay.IsRecording() ) {
+        m_inputReplay.RecordTick( deltaSeconds, *g_theInput );
+        return;
+    } else if( !m_inputReplay.IsReplaying() ) {
+        return;
+    } else if( m_inputReplay.IsReplayFinished() ) {
+        StopInputReplay();
+        return;
+    }
+
+    if( m_inputReplay.GetCurrentTick() == 0 ) {
+        GUARANTEE_RECOVERABLE( deltaSeconds == m_inputReplay.GetTickSeconds(), Stringf( "Input replay recorded at %.4fs per tick, running at %.4fs will diverge", m_inputReplay.GetTickSeconds(), deltaSeconds ) );
+    }
+
+    XboxControllerState controllerStates[MAX_CONTROLLERS];
+    m_inputReplay.ReadTick( controllerStates, m_replayKeysPressed );
+
+    for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+        g_theInput->ApplyControllerState( controllerIndex, controllerStates[controllerIndex] );
+    }
+
+    // Keys were pressed between the previous tick and this one
+    m_isDispatchingReplayKeys = true;
+
+    for( int keyIndex = 0; keyIndex < (int)m_replayKeysPressed.size(); keyIndex++ ) {
+        HandleKeyPressed( m_replayKeysPressed[keyIndex] );
+    }
+
+    m_isDispatchingReplayKeys = false;
+}
+
+
 void Game::UpdateFromController( float deltaSeconds ) {
     UNUSED( deltaSeconds );
 
@@ -817,6 +988,107 @@ void Game::UpdateCameraShake( float deltaSeconds ) {
 }
 
 
+void Game::UpdateDebugStats() {
+    m_debugStatsVerts.clear();
+
+    if( !m_debugDrawing ) {
+        return;
+    }
+
+    const BitmapFont* font = g_theRenderer->CreateOrGetBitmapFontFromFile( FONT_NAME_SQUIRREL );
+
+    const Camera& activeCamera = GetActiveCamera();
+    Vec2 textPosition = activeCamera.GetOrthoBottomLeft() + Vec2( 0.1f, 0.1f );
+    float cellHeight = 0.2f;
+    float cellAspect = 0.6f;
+
+    int candidatePairs;
+    int bruteForcePairs;
+    m_activeMap->GetCollisionPairStats( candidatePairs, bruteForcePairs );
+
+    std::string text = Stringf( "Collision Pairs: %d (Brute Force: %d, Skipped By Layers: %d)", candidatePairs, bruteForcePairs, m_activeMap->GetNumSkippedPairs() );
+    font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+    textPosition.y += cellHeight;
+
+    int numAwake;
+    int numAsleep;
+    int numSleepingPairs;
+    m_activeMap->GetSleepStats( numAwake, numAsleep, numSleepingPairs );
+
+    text = Stringf( "Awake: %d, Asleep: %d (Sleeping Pairs: %d)", numAwake, numAsleep, numSleepingPairs );
+    font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+    textPosition.y += cellHeight;
+
+    text = Stringf( "Batched Raycasts: %d", m_activeMap->GetNumBatchedRaycasts() );
+    font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+    textPosition.y += cellHeight;
+
+    int numInUse;
+    int highWaterMark;
+    int capacity;
+    int numExhausted;
+    m_activeMap->GetPoolStats( ENTITY_TYPE_BULLET, numInUse, highWaterMark, capacity, numExhausted );
+
+    text = Stringf( "Bullet Pool: %d/%d (Peak: %d, Exhausted: %d)", numInUse, capacity, highWaterMark, numExhausted );
+    font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+    textPosition.y += cellHeight;
+
+    int numParticles;
+    m_activeMap->GetExplosionParticleStats( numParticles, highWaterMark );
+
+    text = Stringf( "Explosion Particles: %d (Peak: %d)", numParticles, highWaterMark );
+    font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+    textPosition.y += cellHeight;
+
+    int numProjectiles;
+    m_activeMap->GetProjectileStats( numProjectiles, highWaterMark );
+
+    text = Stringf( "Projectiles: %d (Peak: %d)", numProjectiles, highWaterMark );
+    font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+    textPosition.y += cellHeight;
+
+    const PathRequestStats& pathStats = m_activeMap->GetPathRequestStats();
+
+    text = Stringf( "Path Requests: %d queued (Peak: %d), Latency: %.1f ticks (Max: %d), Cache Hits: %.0f%%", pathStats.numPending, pathStats.peakPending, pathStats.GetAverageLatencyTicks(), pathStats.maxLatencyTicks, pathStats.GetCacheHitRate() * 100.f );
+    font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+    textPosition.y += cellHeight;
+
+    if( m_isDeterministic ) {
+        text = Stringf( "State Hash: %08x (Seed: %u, Tick: %d)", GetStateHash(), m_gameSeed, m_activeMap->GetNumTicks() );
+        font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::WHITE, cellAspect );
+        textPosition.y += cellHeight;
+    }
+
+    int numBenchmarks = (int)m_benchmarkResults.size();
+    for( int benchmarkIndex = 0; benchmarkIndex < numBenchmarks; benchmarkIndex++ ) {
+        text = m_benchmarkResults[benchmarkIndex].GetReport();
+        font->AddVertsForText2D( m_debugStatsVerts, textPosition, cellHeight, text, Rgba::YELLOW, cellAspect );
+        textPosition.y += cellHeight;
+    }
+}
+
+
+void Game::RunBenchmarks() {
+    m_benchmarkResults.clear();
+    m_benchmarkResults.push_back( RunRaycastBenchmark( *m_activeMap ) );
+    m_benchmarkResults.push_back( RunMapBuildBenchmark() );
+    m_benchmarkResults.push_back( RunParticleBenchmark() );
+    m_benchmarkResults.push_back( RunSnapshotBenchmark() );
+    m_benchmarkResults.push_back( RunParallelUpdateBenchmark() );
+    m_benchmarkResults.push_back( RunComponentBenchmark() );
+    m_benchmarkResults.push_back( RunDispatchBenchmark() );
+    m_benchmarkResults.push_back( RunProjectileBenchmark() );
+    m_benchmarkResults.push_back( RunFlowFieldBenchmark() );
+    m_benchmarkResults.push_back( RunPathfindingBenchmark( PATHFINDING_LAYOUT_ROOMS ) );
+    m_benchmarkResults.push_back( RunPathfindingBenchmark( PATHFINDING_LAYOUT_RANDOM_STONE ) );
+
+    int numBenchmarks = (int)m_benchmarkResults.size();
+    for( int benchmarkIndex = 0; benchmarkIndex < numBenchmarks; benchmarkIndex++ ) {
+        DebuggerPrintf( "Benchmark: %s\n", m_benchmarkResults[benchmarkIndex].GetReport().c_str() );
+    }
+}
+
+
 void Game::RenderLoadingScreen() const {
     g_theRenderer->ClearScreen( Rgba::CYAN );
 
@@ -837,8 +1109,26 @@ void Game::RenderAttractScreen() const {
 }
 
 
-void Game::RenderGame() const {
-    m_activeMap->Render();
+void Game::RenderGame( float tickAlpha ) const {
+    Camera renderCamera = GetRenderCamera( tickAlpha );
+    AABB2 viewBounds( renderCamera.GetOrthoBottomLeft(), renderCamera.GetOrthoTopRight() );
+    m_activeMap->Render( viewBounds, tickAlpha );
+}
+
+
+const Camera Game::GetRenderCamera( float tickAlpha ) const {
+    if( m_useDebugCamera || !m_hasPreviousPlayerCamera ) {
+        return GetActiveCamera();
+    }
+
+    Vec2 previousMins = m_previousPlayerCamera.GetOrthoBottomLeft();
+    Vec2 previousMaxs = m_previousPlayerCamera.GetOrthoTopRight();
+    Vec2 currentMins = m_playerCamera->GetOrthoBottomLeft();
+    Vec2 currentMaxs = m_playerCamera->GetOrthoTopRight();
+
+    Camera renderCamera;
+    renderCamera.SetOrthoView( previousMins + ((currentMins - previousMins) * tickAlpha), previousMaxs + ((currentMaxs - previousMaxs) * tickAlpha) );
+    return renderCamera;
 }
 
 
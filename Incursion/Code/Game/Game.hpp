@@ -1,7 +1,10 @@
 #pragma once
 #include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Renderer/Camera.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/Benchmark.hpp"
 #include "Game/Entity.hpp"
+#include "Game/InputReplay.hpp"
 #include "Game/Map.hpp"
 
 
@@ -27,14 +30,14 @@ class SpriteSheet;
 
 class Game {
 	public:
-	explicit Game( bool doPreLoading = true );
+	explicit Game( bool doPreLoading = true, int startingMapIndex = 0 );
 	~Game();
 
 	void Startup();
 	void Shutdown();
 
 	void Update( float deltaSeconds );
-	void Render() const;
+	void Render( float tickAlpha = 1.f ) const; // tickAlpha is how far between the previous and current tick to draw
     bool IsDebugDrawingOn() const;
     void SetCameraShakeAmount( float newCameraShakeAmount );
 
@@ -54,8 +57,14 @@ class Game {
     const Texture* GetExtrasTexture() const;
     const SpriteDef& GetExtrasSprite( int spriteIndex ) const;
     GameMode GetGameMode() const;
+    const Map* GetActiveMap() const;
+    bool IsDeterministic() const;
+    unsigned int GetStateHash() const; // Active map's rolling hash, only updated in deterministic mode
+    const InputReplay& GetInputReplay() const;
+    bool StopInputReplay(); // True if the replay ran to the end and reproduced the recorded state hash
 
     void StartNextMap();
+    void RunBenchmarks();
 
 	private:
     LoadingState m_loadingState = LOADING_INIT;
@@ -77,16 +86,29 @@ class Game {
     bool m_useDebugCamera = false;
     Camera* m_playerCamera = nullptr;
     Camera* m_debugCamera = nullptr;
+    Camera m_previousPlayerCamera; // Player camera at the start of the current tick
+    bool m_hasPreviousPlayerCamera = false;
 
     bool m_debugPlayerTankCollision = false;
     bool m_isPaused = false;
 
     std::vector<Map*> m_maps = {};
     Map* m_activeMap = nullptr;
+    int m_startingMapIndex = 0;
+    bool m_isDeterministic = false;
+    unsigned int m_gameSeed = 0;
+
+    InputReplay m_inputReplay;
+    KeyCodeList m_replayKeysPressed;
+    bool m_isDispatchingReplayKeys = false;
+    ByteBuffer m_quickSnapshot; // F6 saves the active map, F7 rewinds it
+    const Map* m_quickSnapshotMap = nullptr;
     PlayerTank* m_extraLives[PLAYERTANK_EXTRA_LIVES * MAX_CONTROLLERS] = {};
     std::vector<Vertex_PCU> m_attractVerts;
     std::vector<Vertex_PCU> m_pauseVerts;
     std::vector<Vertex_PCU> m_pauseTextVerts;
+    std::vector<Vertex_PCU> m_debugStatsVerts;
+    std::vector<BenchmarkResult> m_benchmarkResults;
 
     Texture* m_extrasTexture = nullptr;
     SpriteSheet* m_extrasSprites = nullptr;
@@ -101,6 +123,7 @@ class Game {
     void UpdateLoadingScreen( float deltaSeconds );
     void UpdateAttractScreen( float deltaSeconds );
     void UpdateGame( float deltaSeconds );
+    void UpdateInputReplay( float deltaSeconds );
 
     void UpdateFromController( float deltaSeconds );
 
@@ -109,9 +132,11 @@ class Game {
     void UpdatePlayerCamera( float deltaSeconds );
     void GetPlayerCameraCenteredOnPlayers( Vec2& outCameraCenter, std::vector<Vec2>& outPlayerPositions );
     void UpdateCameraShake( float deltaSeconds );
+    void UpdateDebugStats();
 
     void RenderLoadingScreen() const;
     void RenderAttractScreen() const;
-    void RenderGame() const;
+    void RenderGame( float tickAlpha ) const;
+    const Camera GetRenderCamera( float tickAlpha ) const;
     void RenderEndScreen() const;
 };
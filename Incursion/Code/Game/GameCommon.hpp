@@ -25,15 +25,23 @@ extern InputSystem* g_theInput;
 class AudioSystem;
 extern AudioSystem* g_theAudio;
 
+class JobSystem;
+extern JobSystem* g_theJobSystem;
+
 class Entity;
 typedef std::vector<Entity*> EntityList;
 
 constexpr int APP_MIN_FPS = 10;
 constexpr float APP_MAX_DELTA_SECONDS = 1.f / (float)APP_MIN_FPS;
+constexpr int APP_DEFAULT_TICK_RATE = 60;   // Overridden by tickRate in ProjectConfig.xml
+constexpr int APP_MAX_TICKS_PER_FRAME = 8;  // Past this the rest of the frame's time is dropped
+constexpr int APP_DEFAULT_REPLAY_TICKS_PER_FRAME = 16; // Input replays ignore real time, overridden by replayTicksPerFrame
+constexpr int APP_DEFAULT_WORKER_THREADS = -1; // One per extra hardware thread, overridden by workerThreads
 
 constexpr float GAME_ATTRACT_AUDIO_DELAY = 3.f;
 constexpr float GAME_END_SCREEN_TIME_SECONDS = 3.f;
 constexpr int GAME_NUM_MAPS = 3;
+constexpr int GAME_DEFAULT_SEED = 1234; // Used when deterministic="true" and no seed is given
 
 constexpr char  AUDIO_ANTICIPATION[] =     "Data/Audio/Anticipation.mp3";
 constexpr char  AUDIO_ATTRACT_LOOP[] =     "Data/Audio/AttractMusic.mp3";
@@ -74,8 +82,10 @@ constexpr int   MAP_HEIGHT = 30;
 constexpr float MAP_STONE_TILES_FRACTION = 0.2f;
 constexpr int   MAP_STARTING_SAFE_ZONE_SIZE_X = 5;
 constexpr int   MAP_STARTING_SAFE_ZONE_SIZE_Y = 5;
-constexpr int   MAP_RAYCAST_NUM_SAMPLES = 100;
 constexpr float MAP_RAYCAST_MAX_DISTANCE = 10.f;
+constexpr int   MAP_UPDATE_ENTITIES_PER_JOB = 256;
+constexpr int   MAP_MESH_CHUNK_SIZE = 16; // Tiles per side of each lazily built terrain mesh chunk
+constexpr int   MAP_SLEEP_STILL_TICKS = 30; // Entities that haven't moved for this many ticks skip collision until touched
 
 constexpr float CLIENT_ASPECT = (16.f / 9.f);
 constexpr float CAMERA_PLAYER_HEIGHT = 7.f;
@@ -119,12 +129,15 @@ constexpr float ENEMYTANK_RATE_OF_FIRE_SECONDS = 1.7f;
 constexpr float ENEMYTANK_WHISKER_RANGE = 1.f;
 constexpr float ENEMYTANK_WHISKER_ANGLE = 25.f;
 constexpr int   ENEMYTANK_MAX_HEALTH = 2;
+constexpr int   ENEMYTANK_FLOW_FIELD_RANGE = 16; // Walking distance in tiles, further targets are left to investigate or wander
 
 constexpr float BULLET_PHYSICS_RADIUS = 0.1f;
 constexpr float BULLET_COSMETIC_RADIUS = 0.25f;
 constexpr float BULLET_COSMETIC_BOX_OFFSET = .1f;
 constexpr float BULLET_MAX_SPEED = 5.f;
 constexpr int   BULLET_LIFETIME_BOUNCES = 3;
+constexpr int   BULLET_MAX_SWEEPS_PER_TICK = 4; // Straight moves per tick, each tile bounce starts a new one
+constexpr int   BULLET_POOL_SIZE = 256;
 
 constexpr int   BOULDER_SPRITE_INDEX = 3;
 constexpr float BOULDER_PHYSICS_RADIUS = 0.45f;
@@ -134,3 +147,46 @@ constexpr float BOULDER_COSMETIC_BOX_OFFSET = 0.5f;
 constexpr float EXPLOSION_DURATION = 1.0f;
 constexpr float EXPLOSION_SCALE_SMALL = 0.25f;
 constexpr float EXPLOSION_SCALE_LARGE = 1.f;
+constexpr int   PARTICLES_INITIAL_CAPACITY = 1024;
+constexpr int   PROJECTILES_INITIAL_CAPACITY = 1024;
+constexpr float PROJECTILES_MAX_STEP_TILES = 0.5f; // Longest move per kernel step on either axis, under a tile so no wall is stepped over
+constexpr int   FLOW_FIELD_UNREACHABLE = 0x7fffffff;
+constexpr int   PATH_RESULT_MAX_WAYPOINTS = 8; // Kept per delivered path, enough to steer by
+constexpr int   PATH_REQUEST_SEARCHES_PER_TICK = 16; // New (start, goal) pairs searched per tick, cached and duplicate requests are free
+constexpr int   PATH_REQUEST_CACHE_SIZE = 256;
+
+constexpr int   ENTITY_COMPONENT_CHUNK_SIZE = 1024; // Rows per structure-of-arrays chunk
+constexpr int   ENTITY_MAX_SWEEP_CORNERS = BULLET_MAX_SWEEPS_PER_TICK; // Heading changes a swept move keeps per tick
+
+constexpr unsigned int BENCHMARK_RNG_SEED = 1234;
+constexpr int   BENCHMARK_NUM_ITERATIONS = 50;
+constexpr int   BENCHMARK_RAYCAST_NUM_RAYS = 10000;
+constexpr int   BENCHMARK_MAP_BUILD_SIZE = 4096;
+constexpr int   BENCHMARK_MAP_BUILD_NUM_ITERATIONS = 3;
+constexpr int   BENCHMARK_PARTICLES_NUM_PARTICLES = 50000;
+constexpr int   BENCHMARK_PARTICLES_NUM_FRAMES = 60;
+constexpr int   BENCHMARK_SNAPSHOT_NUM_ENTITIES = 1000;
+constexpr int   BENCHMARK_SNAPSHOT_MAP_SIZE = 64;
+constexpr int   BENCHMARK_UPDATE_NUM_ENTITIES = 5000;
+constexpr int   BENCHMARK_UPDATE_MAP_SIZE = 128;
+constexpr int   BENCHMARK_UPDATE_NUM_TICKS = 60;
+constexpr int   BENCHMARK_COMPONENTS_NUM_ENTITIES = 10000;
+constexpr int   BENCHMARK_COMPONENTS_NUM_TICKS = 60;
+constexpr int   BENCHMARK_DISPATCH_NUM_ENTITIES = 10000;
+constexpr int   BENCHMARK_DISPATCH_NUM_TICKS = 60;
+constexpr int   BENCHMARK_PROJECTILES_NUM_PROJECTILES = 100000;
+constexpr int   BENCHMARK_PROJECTILES_NUM_BOULDERS = 1000;
+constexpr int   BENCHMARK_PROJECTILES_NUM_TICKS = 60;
+constexpr int   BENCHMARK_FLOWFIELD_NUM_AGENTS = 100; // Per-agent searches are the baseline, so kept small
+constexpr int   BENCHMARK_FLOWFIELD_MAP_SIZE = 128;
+constexpr int   BENCHMARK_FLOWFIELD_NUM_TICKS = 60;
+constexpr int   BENCHMARK_PATHFINDING_MAP_SIZE = 256;
+constexpr int   BENCHMARK_PATHFINDING_NUM_QUERIES = 1000;
+constexpr int   BENCHMARK_PATHFINDING_NUM_PATCHES = 20;
+constexpr int   BENCHMARK_PATHFINDING_ROOM_SIZE = 16; // Rooms layout, walls every this many tiles
+constexpr int   BENCHMARK_PATHFINDING_DOOR_WIDTH = 2;
+constexpr double BENCHMARK_PATHFINDING_TARGET_MICROSECONDS = 10.0; // Per query across the whole benchmark map
+
+constexpr int   HEADLESS_DEFAULT_NUM_TICKS = 3600;
+constexpr int   HEADLESS_PLAYER_TURN_TICKS = 90; // Scripted players pick a new heading this often
+constexpr float HEADLESS_PLAYER_AIM_DEGREES_PER_TICK = 3.f; // Scripted players sweep their gun around at this rate
@@ -0,0 +1,573 @@
+#include "Game/GridPathfinder.hpp"
+
+#include "Engine/Math/MathUtils.hpp"
+
+#include "Game/Map.hpp"
+
+#include "algorithm"
+#include "float.h"
+
+
+static constexpr int PATH_NUM_DIRECTIONS = 8;
+static constexpr int PATH_NO_DIRECTION = PATH_NUM_DIRECTIONS; // Start tile, every direction is searched
+static constexpr float PATH_DIAGONAL_COST = 1.41421356f;
+
+// Clockwise from north, even directions are straight, odd are diagonal
+static const IntVec2 s_pathDirectionOffsets[PATH_NUM_DIRECTIONS] = {
+    IntVec2(  0,  1 ), // North
+    IntVec2(  1,  1 ), // Northeast
+    IntVec2(  1,  0 ), // East
+    IntVec2(  1, -1 ), // Southeast
+    IntVec2(  0, -1 ), // South
+    IntVec2( -1, -1 ), // Southwest
+    IntVec2( -1,  0 ), // West
+    IntVec2( -1,  1 )  // Northwest
+};
+
+static constexpr int PATH_DIRECTION_NORTH = 0;
+static constexpr int PATH_DIRECTION_EAST = 2;
+static constexpr int PATH_DIRECTION_SOUTH = 4;
+static constexpr int PATH_DIRECTION_WEST = 6;
+
+
+struct PathNode {
+    public:
+    unsigned int searchIndex = 0; // Stale unless it matches the arena's current search
+    float givenCost = 0.f;
+    int parentTileIndex = -1;
+    unsigned char direction = PATH_NO_DIRECTION; // Arrived moving this way
+    bool isClosed = false;
+};
+
+struct PathOpenEntry {
+    public:
+    float totalCost = 0.f;
+    int tileIndex = -1;
+};
+
+// Per-thread search memory, only grows when a bigger map is searched
+// Nodes are stamped with the search that touched them instead of being cleared between searches
+struct PathSearchArena {
+    public:
+    std::vector<PathNode> nodes;
+    std::vector<PathOpenEntry> openEntries; // Binary heap, best on top
+    unsigned int searchIndex = 0;
+};
+
+static thread_local PathSearchArena s_pathArena;
+
+
+static PathSearchArena& BeginPathSearch( int numTiles ) {
+    PathSearchArena& arena = s_pathArena;
+
+    if( (int)arena.nodes.size() < numTiles ) {
+        arena.nodes.resize( numTiles );
+        arena.openEntries.reserve( numTiles );
+    }
+
+    arena.searchIndex++;
+
+    if( arena.searchIndex == 0 ) { // Wrapped, every old stamp could look current
+        int numNodes = (int)arena.nodes.size();
+        for( int nodeIndex = 0; nodeIndex < numNodes; nodeIndex++ ) {
+            arena.nodes[nodeIndex].searchIndex = 0;
+        }
+
+        arena.searchIndex = 1;
+    }
+
+    arena.openEntries.clear();
+    return arena;
+}
+
+
+static bool IsWorseOpenEntry( const PathOpenEntry& entryA, const PathOpenEntry& entryB ) {
+    // Ties broken by tile so every search expands in the same order
+    if( entryA.totalCost != entryB.totalCost ) {
+        return entryA.totalCost > entryB.totalCost;
+    }
+
+    return entryA.tileIndex > entryB.tileIndex;
+}
+
+
+static float GetOctileDistance( int fromX, int fromY, int toX, int toY ) {
+    int distanceX = abs( toX - fromX );
+    int distanceY = abs( toY - fromY );
+    int numDiagonalSteps = (distanceX < distanceY) ? distanceX : distanceY;
+    int numStraightSteps = ((distanceX > distanceY) ? distanceX : distanceY) - numDiagonalSteps;
+    return (float)numStraightSteps + (PATH_DIAGONAL_COST * (float)numDiagonalSteps);
+}
+
+
+static void OpenPathNode( PathSearchArena& arena, int tileIndex, int tileX, int tileY, int parentTileIndex, int direction, float givenCost, const IntVec2& goalCoords ) {
+    PathNode& node = arena.nodes[tileIndex];
+
+    if( node.searchIndex != arena.searchIndex ) {
+        node.searchIndex = arena.searchIndex;
+        node.givenCost = FLT_MAX;
+        node.isClosed = false;
+    }
+
+    if( node.isClosed || givenCost >= node.givenCost ) {
+        return;
+    }
+
+    node.givenCost = givenCost;
+    node.parentTileIndex = parentTileIndex;
+    node.direction = (unsigned char)direction;
+
+    // Better paths push again, the worse entry is skipped when it comes off the heap
+    PathOpenEntry entry;
+    entry.tileIndex = tileIndex;
+    entry.totalCost = givenCost + GetOctileDistance( tileX, tileY, goalCoords.x, goalCoords.y );
+    arena.openEntries.push_back( entry );
+    std::push_heap( arena.openEntries.begin(), arena.openEntries.end(), IsWorseOpenEntry );
+}
+
+
+static int PopPathNode( PathSearchArena& arena ) {
+    std::pop_heap( arena.openEntries.begin(), arena.openEntries.end(), IsWorseOpenEntry );
+    int tileIndex = arena.openEntries.back().tileIndex;
+    arena.openEntries.pop_back();
+    return tileIndex;
+}
+
+
+static int BuildPath( const PathSearchArena& arena, int goalTileIndex, int mapWidth, IntVec2* out_waypoints, int maxWaypoints, float* out_pathLength ) {
+    int numWaypoints = 0;
+    for( int tileIndex = goalTileIndex; tileIndex >= 0; tileIndex = arena.nodes[tileIndex].parentTileIndex ) {
+        numWaypoints++;
+    }
+
+    // Walking back from the goal, so only write the ones that fit from the start
+    int waypointIndex = numWaypoints - 1;
+    for( int tileIndex = goalTileIndex; tileIndex >= 0; tileIndex = arena.nodes[tileIndex].parentTileIndex ) {
+        if( waypointIndex < maxWaypoints ) {
+            out_waypoints[waypointIndex] = IntVec2( tileIndex % mapWidth, tileIndex / mapWidth );
+        }
+
+        waypointIndex--;
+    }
+
+    if( out_pathLength != nullptr ) {
+        *out_pathLength = arena.nodes[goalTileIndex].givenCost;
+    }
+
+    return numWaypoints;
+}
+
+
+void GridPathfinder::Startup( const Map& map ) {
+    m_dimensions = map.GetDimensions();
+    m_jumpDistances.assign( m_dimensions.x * m_dimensions.y * PATH_NUM_DIRECTIONS, 0 );
+    UpdateJumpDistances( map );
+    UpdateRegions( map );
+}
+
+
+void GridPathfinder::Shutdown() {
+    m_jumpDistances.clear();
+    m_regions.clear();
+    m_regionScratch.clear();
+    m_areRegionsDirty = false;
+}
+
+
+void GridPathfinder::OnTileChanged( const Map& map, int tileIndex ) {
+    if( m_jumpDistances.empty() ) {
+        return; // Startup changes tiles before the tables exist
+    }
+
+    int tileX = tileIndex % m_dimensions.x;
+    int tileY = tileIndex / m_dimensions.x;
+
+    // Jump points change up to a tile away, and each straight table chains along its whole row or column
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_NORTH, tileX - 1, tileX + 1 );
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_EAST, tileY - 1, tileY + 1 );
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_SOUTH, tileX - 1, tileX + 1 );
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_WEST, tileY - 1, tileY + 1 );
+
+    // Diagonal entries read those straight entries, so only the runs crossing those rows and columns change
+    for( int direction = 1; direction < PATH_NUM_DIRECTIONS; direction += 2 ) {
+        PatchDiagonalJumpDistances( map, direction, tileX, tileY );
+    }
+
+    m_areRegionsDirty = true; // One wall can split a region anywhere along it
+}
+
+
+void GridPathfinder::OnTilesChanged( const Map& map ) {
+    if( m_jumpDistances.empty() ) {
+        return;
+    }
+
+    UpdateJumpDistances( map );
+    m_areRegionsDirty = true;
+}
+
+
+void GridPathfinder::UpdateRegionsIfDirty( const Map& map ) {
+    if( m_areRegionsDirty ) {
+        UpdateRegions( map );
+        m_areRegionsDirty = false;
+    }
+}
+
+
+int GridPathfinder::FindPath( const Map& map, int startTileIndex, int goalTileIndex, IntVec2* out_waypoints, int maxWaypoints, float* out_pathLength /*= nullptr*/ ) const {
+    int numTiles = m_dimensions.x * m_dimensions.y;
+
+    if( m_jumpDistances.empty() || startTileIndex < 0 || startTileIndex >= numTiles || goalTileIndex < 0 || goalTileIndex >= numTiles ) {
+        return 0;
+    } else if( map.IsTileSolid( startTileIndex ) || map.IsTileSolid( goalTileIndex ) ) {
+        return 0;
+    } else if( !m_areRegionsDirty && m_regions[startTileIndex] != m_regions[goalTileIndex] ) {
+        return 0; // Walled off, a search would flood the whole region to find out
+    }
+
+    int mapWidth = m_dimensions.x;
+    IntVec2 goalCoords = IntVec2( goalTileIndex % mapWidth, goalTileIndex / mapWidth );
+    PathSearchArena& arena = BeginPathSearch( numTiles );
+    OpenPathNode( arena, startTileIndex, startTileIndex % mapWidth, startTileIndex / mapWidth, -1, PATH_NO_DIRECTION, 0.f, goalCoords );
+
+    while( !arena.openEntries.empty() ) {
+        int tileIndex = PopPathNode( arena );
+        PathNode& node = arena.nodes[tileIndex];
+
+        if( node.isClosed ) {
+            continue;
+        } else if( tileIndex == goalTileIndex ) {
+            return BuildPath( arena, goalTileIndex, mapWidth, out_waypoints, maxWaypoints, out_pathLength );
+        }
+
+        node.isClosed = true;
+
+        int tileX = tileIndex % mapWidth;
+        int tileY = tileIndex / mapWidth;
+        int goalDisplacementX = goalCoords.x - tileX;
+        int goalDisplacementY = goalCoords.y - tileY;
+        const short* jumpDistances = &m_jumpDistances[tileIndex * PATH_NUM_DIRECTIONS];
+
+        // Keep going the same way plus the turns a wall ending beside the last step forces, everything else is reached as cheaply from the parent
+        int directions[PATH_NUM_DIRECTIONS] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+        int numDirections = PATH_NUM_DIRECTIONS;
+
+        if( node.direction != PATH_NO_DIRECTION && (node.direction & 1) != 0 ) {
+            directions[0] = (node.direction + 7) & 7; // Diagonals never force turns, corners can't be cut
+            directions[1] = node.direction;
+            directions[2] = (node.direction + 1) & 7;
+            numDirections = 3;
+        } else if( node.direction != PATH_NO_DIRECTION ) {
+            const IntVec2& arrivalOffset = s_pathDirectionOffsets[node.direction];
+            directions[0] = node.direction;
+            numDirections = 1;
+
+            for( int side = -1; side <= 1; side += 2 ) {
+                int sideDirection = (node.direction + (2 * side)) & 7;
+                const IntVec2& sideOffset = s_pathDirectionOffsets[sideDirection];
+                bool isSideOpen = !map.IsTileSolid( tileX + sideOffset.x, tileY + sideOffset.y );
+                bool wasSideSolid = map.IsTileSolid( tileX - arrivalOffset.x + sideOffset.x, tileY - arrivalOffset.y + sideOffset.y );
+
+                if( isSideOpen && wasSideSolid ) {
+                    directions[numDirections++] = (node.direction + side) & 7;
+                    directions[numDirections++] = sideDirection;
+                }
+            }
+        }
+
+        for( int directionIndex = 0; directionIndex < numDirections; directionIndex++ ) {
+            int direction = directions[directionIndex];
+            const IntVec2& offset = s_pathDirectionOffsets[direction];
+            int jumpDistance = jumpDistances[direction];
+            int openDistance = abs( jumpDistance );
+
+            // Steps toward the goal along each axis, positive when the goal is ahead
+            int goalStepsX = goalDisplacementX * offset.x;
+            int goalStepsY = goalDisplacementY * offset.y;
+            int numSteps = 0;
+
+            if( (direction & 1) == 0 ) {
+                bool isGoalInLine = (offset.x != 0) ? (goalDisplacementY == 0 && goalStepsX > 0) : (goalDisplacementX == 0 && goalStepsY > 0);
+                int goalSteps = goalStepsX + goalStepsY;
+
+                if( isGoalInLine && goalSteps <= openDistance ) { // Goal before the wall or jump point
+                    numSteps = goalSteps;
+                } else if( jumpDistance > 0 ) {
+                    numSteps = jumpDistance;
+                }
+            } else {
+                // Stop on the goal's row or column if the run gets there, a straight jump from that tile reaches it
+                bool isGoalAhead = (goalStepsX > 0) && (goalStepsY > 0);
+
+                if( isGoalAhead && (goalStepsX <= openDistance || goalStepsY <= openDistance) ) {
+                    numSteps = (goalStepsX < goalStepsY) ? goalStepsX : goalStepsY;
+                } else if( jumpDistance > 0 ) {
+                    numSteps = jumpDistance;
+                }
+            }
+
+            if( numSteps > 0 ) {
+                int nextX = tileX + (numSteps * offset.x);
+                int nextY = tileY + (numSteps * offset.y);
+                float stepCost = ((direction & 1) == 0) ? 1.f : PATH_DIAGONAL_COST;
+                OpenPathNode( arena, (nextY * mapWidth) + nextX, nextX, nextY, tileIndex, direction, node.givenCost + (stepCost * (float)numSteps), goalCoords );
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+int GridPathfinder::FindPathAStar( const Map& map, int startTileIndex, int goalTileIndex, IntVec2* out_waypoints, int maxWaypoints, float* out_pathLength /*= nullptr*/ ) const {
+    int numTiles = m_dimensions.x * m_dimensions.y;
+
+    if( startTileIndex < 0 || startTileIndex >= numTiles || goalTileIndex < 0 || goalTileIndex >= numTiles ) {
+        return 0;
+    } else if( map.IsTileSolid( startTileIndex ) || map.IsTileSolid( goalTileIndex ) ) {
+        return 0;
+    }
+
+    int mapWidth = m_dimensions.x;
+    IntVec2 goalCoords = IntVec2( goalTileIndex % mapWidth, goalTileIndex / mapWidth );
+    PathSearchArena& arena = BeginPathSearch( numTiles );
+    OpenPathNode( arena, startTileIndex, startTileIndex % mapWidth, startTileIndex / mapWidth, -1, PATH_NO_DIRECTION, 0.f, goalCoords );
+
+    while( !arena.openEntries.empty() ) {
+        int tileIndex = PopPathNode( arena );
+        PathNode& node = arena.nodes[tileIndex];
+
+        if( node.isClosed ) {
+            continue;
+        } else if( tileIndex == goalTileIndex ) {
+            return BuildPath( arena, goalTileIndex, mapWidth, out_waypoints, maxWaypoints, out_pathLength );
+        }
+
+        node.isClosed = true;
+
+        int tileX = tileIndex % mapWidth;
+        int tileY = tileIndex / mapWidth;
+
+        for( int direction = 0; direction < PATH_NUM_DIRECTIONS; direction++ ) {
+            const IntVec2& offset = s_pathDirectionOffsets[direction];
+            bool isStraight = (direction & 1) == 0;
+
+            if( map.IsTileSolid( tileX + offset.x, tileY + offset.y ) ) {
+                continue;
+            } else if( !isStraight && (map.IsTileSolid( tileX + offset.x, tileY ) || map.IsTileSolid( tileX, tileY + offset.y )) ) {
+                continue;
+            }
+
+            int nextX = tileX + offset.x;
+            int nextY = tileY + offset.y;
+            float stepCost = isStraight ? 1.f : PATH_DIAGONAL_COST;
+            OpenPathNode( arena, (nextY * mapWidth) + nextX, nextX, nextY, tileIndex, direction, node.givenCost + stepCost, goalCoords );
+        }
+    }
+
+    return 0;
+}
+
+
+size_t GridPathfinder::GetJumpTableBytes() const {
+    return m_jumpDistances.capacity() * sizeof( short );
+}
+
+
+size_t GridPathfinder::GetMemoryBytes() const {
+    size_t regionBytes = (m_regions.capacity() + m_regionScratch.capacity()) * sizeof( int );
+    return GetJumpTableBytes() + regionBytes;
+}
+
+
+void GridPathfinder::UpdateJumpDistances( const Map& map ) {
+    // Diagonal runs stop at straight jump points, so the straight tables go first
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_NORTH, 0, m_dimensions.x - 1 );
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_EAST, 0, m_dimensions.y - 1 );
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_SOUTH, 0, m_dimensions.x - 1 );
+    UpdateStraightJumpDistances( map, PATH_DIRECTION_WEST, 0, m_dimensions.y - 1 );
+
+    for( int direction = 1; direction < PATH_NUM_DIRECTIONS; direction += 2 ) {
+        UpdateDiagonalJumpDistances( map, direction );
+    }
+}
+
+
+void GridPathfinder::UpdateStraightJumpDistances( const Map& map, int direction, int firstLine, int lastLine ) {
+    const IntVec2& offset = s_pathDirectionOffsets[direction];
+    bool isHorizontal = offset.x != 0;
+    int lineLength = isHorizontal ? m_dimensions.x : m_dimensions.y;
+    int numLines = isHorizontal ? m_dimensions.y : m_dimensions.x;
+    int step = isHorizontal ? offset.x : offset.y;
+
+    firstLine = (firstLine < 0) ? 0 : firstLine;
+    lastLine = (lastLine >= numLines) ? numLines - 1 : lastLine;
+
+    for( int lineIndex = firstLine; lineIndex <= lastLine; lineIndex++ ) {
+        // Start at the far end, so the next tile along is always done first
+        for( int stepIndex = 0; stepIndex < lineLength; stepIndex++ ) {
+            int linePosition = (step > 0) ? (lineLength - 1 - stepIndex) : stepIndex;
+            int tileX = isHorizontal ? linePosition : lineIndex;
+            int tileY = isHorizontal ? lineIndex : linePosition;
+            int nextX = tileX + offset.x;
+            int nextY = tileY + offset.y;
+            short& jumpDistance = m_jumpDistances[(((tileY * m_dimensions.x) + tileX) * PATH_NUM_DIRECTIONS) + direction];
+
+            if( map.IsTileSolid( tileX, tileY ) || map.IsTileSolid( nextX, nextY ) ) {
+                jumpDistance = 0;
+            } else if( IsJumpPoint( map, nextX, nextY, direction ) ) {
+                jumpDistance = 1;
+            } else {
+                short nextJumpDistance = m_jumpDistances[(((nextY * m_dimensions.x) + nextX) * PATH_NUM_DIRECTIONS) + direction];
+                jumpDistance = (nextJumpDistance > 0) ? nextJumpDistance + 1 : nextJumpDistance - 1;
+            }
+        }
+    }
+}
+
+
+void GridPathfinder::UpdateDiagonalJumpDistances( const Map& map, int direction ) {
+    const IntVec2& offset = s_pathDirectionOffsets[direction];
+
+    // Same far-end-first order as the straight tables, on both axes
+    for( int rowIndex = 0; rowIndex < m_dimensions.y; rowIndex++ ) {
+        int tileY = (offset.y > 0) ? (m_dimensions.y - 1 - rowIndex) : rowIndex;
+
+        for( int columnIndex = 0; columnIndex < m_dimensions.x; columnIndex++ ) {
+            int tileX = (offset.x > 0) ? (m_dimensions.x - 1 - columnIndex) : columnIndex;
+            m_jumpDistances[(((tileY * m_dimensions.x) + tileX) * PATH_NUM_DIRECTIONS) + direction] = GetDiagonalJumpDistance( map, tileX, tileY, direction );
+        }
+    }
+}
+
+
+void GridPathfinder::PatchDiagonalJumpDistances( const Map& map, int direction, int changedTileX, int changedTileY ) {
+    // An entry reads the tiles of its own step and the straight entries of the tile it steps to,
+    //  and those only changed in the three rows and columns around the changed tile
+    // So the runs to patch start one step before those rows and columns
+    const IntVec2& offset = s_pathDirectionOffsets[direction];
+    int firstSeedRow = changedTileY - 1 - offset.y;
+    int lastSeedRow = changedTileY + 1 - offset.y;
+    int firstSeedColumn = ClampInt( changedTileX - 1 - offset.x, 0, m_dimensions.x - 1 );
+    int lastSeedColumn = ClampInt( changedTileX + 1 - offset.x, 0, m_dimensions.x - 1 );
+
+    // Far end first like the full rebuild, so the tile a run steps to is already patched
+    for( int rowIndex = 0; rowIndex < m_dimensions.y; rowIndex++ ) {
+        int tileY = (offset.y > 0) ? (m_dimensions.y - 1 - rowIndex) : rowIndex;
+        bool isSeedRow = (tileY >= firstSeedRow) && (tileY <= lastSeedRow);
+        int firstColumn = isSeedRow ? 0 : firstSeedColumn;
+        int lastColumn = isSeedRow ? m_dimensions.x - 1 : lastSeedColumn;
+
+        for( int tileX = firstColumn; tileX <= lastColumn; tileX++ ) {
+            PatchDiagonalRun( map, direction, tileX, tileY );
+        }
+    }
+}
+
+
+void GridPathfinder::PatchDiagonalRun( const Map& map, int direction, int tileX, int tileY ) {
+    // Each entry chains from the one ahead of it, so walk back until an entry comes out the same, everything behind that still holds
+    // Behind a wall every entry is the wall distance again, so runs mostly stop within a step of one
+    const IntVec2& offset = s_pathDirectionOffsets[direction];
+
+    while( tileX >= 0 && tileX < m_dimensions.x && tileY >= 0 && tileY < m_dimensions.y ) {
+        short& jumpDistance = m_jumpDistances[(((tileY * m_dimensions.x) + tileX) * PATH_NUM_DIRECTIONS) + direction];
+        short newJumpDistance = GetDiagonalJumpDistance( map, tileX, tileY, direction );
+
+        if( newJumpDistance == jumpDistance ) {
+            return;
+        }
+
+        jumpDistance = newJumpDistance;
+        tileX -= offset.x;
+        tileY -= offset.y;
+    }
+}
+
+
+short GridPathfinder::GetDiagonalJumpDistance( const Map& map, int tileX, int tileY, int direction ) const {
+    const IntVec2& offset = s_pathDirectionOffsets[direction];
+    int nextX = tileX + offset.x;
+    int nextY = tileY + offset.y;
+
+    if( map.IsTileSolid( tileX, tileY ) || map.IsTileSolid( nextX, nextY ) ) {
+        return 0;
+    } else if( map.IsTileSolid( nextX, tileY ) || map.IsTileSolid( tileX, nextY ) ) {
+        return 0; // Would cut a corner
+    }
+
+    // A diagonal step lands on a jump point when a straight jump from there finds one
+    int horizontalDirection = (offset.x > 0) ? PATH_DIRECTION_EAST : PATH_DIRECTION_WEST;
+    int verticalDirection = (offset.y > 0) ? PATH_DIRECTION_NORTH : PATH_DIRECTION_SOUTH;
+    const short* nextJumpDistances = &m_jumpDistances[((nextY * m_dimensions.x) + nextX) * PATH_NUM_DIRECTIONS];
+
+    if( nextJumpDistances[horizontalDirection] > 0 || nextJumpDistances[verticalDirection] > 0 ) {
+        return 1;
+    }
+
+    short nextJumpDistance = nextJumpDistances[direction];
+    return (nextJumpDistance > 0) ? (short)(nextJumpDistance + 1) : (short)(nextJumpDistance - 1);
+}
+
+
+bool GridPathfinder::IsJumpPoint( const Map& map, int tileX, int tileY, int direction ) const {
+    // Arriving straight, a tile is a jump point when a wall beside the previous tile ends here, opening a turn
+    const IntVec2& offset = s_pathDirectionOffsets[direction];
+    int previousX = tileX - offset.x;
+    int previousY = tileY - offset.y;
+
+    for( int side = -1; side <= 1; side += 2 ) {
+        int sideX = offset.y * side;
+        int sideY = offset.x * side;
+
+        if( !map.IsTileSolid( tileX + sideX, tileY + sideY ) && map.IsTileSolid( previousX + sideX, previousY + sideY ) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void GridPathfinder::UpdateRegions( const Map& map ) {
+    // Diagonal steps need both straight neighbors open, so four-way flood fills find the same regions
+    int numTiles = m_dimensions.x * m_dimensions.y;
+    m_regions.assign( numTiles, -1 );
+    m_regionScratch.reserve( numTiles );
+    int numRegions = 0;
+
+    for( int seedTileIndex = 0; seedTileIndex < numTiles; seedTileIndex++ ) {
+        if( m_regions[seedTileIndex] >= 0 || map.IsTileSolid( seedTileIndex ) ) {
+            continue;
+        }
+
+        m_regionScratch.clear();
+        m_regionScratch.push_back( seedTileIndex );
+        m_regions[seedTileIndex] = numRegions;
+
+        for( int openIndex = 0; openIndex < (int)m_regionScratch.size(); openIndex++ ) {
+            int tileIndex = m_regionScratch[openIndex];
+            int tileX = tileIndex % m_dimensions.x;
+            int tileY = tileIndex / m_dimensions.x;
+
+            for( int direction = 0; direction < PATH_NUM_DIRECTIONS; direction += 2 ) {
+                const IntVec2& offset = s_pathDirectionOffsets[direction];
+                int nextX = tileX + offset.x;
+                int nextY = tileY + offset.y;
+
+                if( map.IsTileSolid( nextX, nextY ) ) {
+                    continue;
+                }
+
+                int nextTileIndex = (nextY * m_dimensions.x) + nextX;
+                if( m_regions[nextTileIndex] < 0 ) {
+                    m_regions[nextTileIndex] = numRegions;
+                    m_regionScratch.push_back( nextTileIndex );
+                }
+            }
+        }
+
+        numRegions++;
+    }
+}
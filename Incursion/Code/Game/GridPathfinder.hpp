@@ -0,0 +1,52 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+
+#include "Game/GameCommon.hpp"
+
+#include "vector"
+
+
+class Map;
+
+// Shortest 8-way paths over a Map's tiles (diagonals never cut a solid corner), found by Jump Point Search+
+// Jump tables hold, per tile and direction, the steps to the next jump point (positive) or to the wall (zero or negative),
+//  built at Startup and patched when a tile changes, so a search only visits jump points
+// Open tiles are also labelled by connected region, so goals that can't be reached fail without searching
+// Tile changes only mark the labels stale, UpdateRegionsIfDirty relabels once before the next searches
+// Searches keep their working memory in a per-thread arena, so they're const, safe from any thread and don't allocate once it's grown
+class GridPathfinder {
+    public:
+    GridPathfinder() {};
+    ~GridPathfinder() {};
+
+    void Startup( const Map& map );
+    void Shutdown();
+
+    void OnTileChanged( const Map& map, int tileIndex ); // Call after the tile's solidity changes, patches only the runs it reaches
+    void OnTilesChanged( const Map& map ); // Call after many tiles changed at once (snapshot restore), rebuilds the tables once
+    void UpdateRegionsIfDirty( const Map& map ); // Call before searches, never during them, FindPath skips the region check while labels are stale
+
+    // Returns the number of waypoints from start to goal (both included), 0 if the goal can't be walked to
+    // Only the first maxWaypoints are written, consecutive waypoints are joined by a straight or diagonal line of open tiles
+    int FindPath( const Map& map, int startTileIndex, int goalTileIndex, IntVec2* out_waypoints, int maxWaypoints, float* out_pathLength = nullptr ) const;
+    int FindPathAStar( const Map& map, int startTileIndex, int goalTileIndex, IntVec2* out_waypoints, int maxWaypoints, float* out_pathLength = nullptr ) const; // Plain A* over every tile, same path lengths, for checking FindPath
+
+    size_t GetJumpTableBytes() const;
+    size_t GetMemoryBytes() const; // Jump tables plus region labels and their scratch
+
+    private:
+    IntVec2 m_dimensions = IntVec2( 0, 0 );
+    std::vector<short> m_jumpDistances; // Eight per tile, clockwise from north
+    std::vector<int> m_regions; // -1 for solid tiles
+    std::vector<int> m_regionScratch;
+    bool m_areRegionsDirty = false; // Tiles changed since m_regions was labelled
+
+    void UpdateJumpDistances( const Map& map );
+    void UpdateStraightJumpDistances( const Map& map, int direction, int firstLine, int lastLine ); // Rows for east / west, columns for north / south
+    void UpdateDiagonalJumpDistances( const Map& map, int direction );
+    void PatchDiagonalJumpDistances( const Map& map, int direction, int changedTileX, int changedTileY );
+    void PatchDiagonalRun( const Map& map, int direction, int tileX, int tileY );
+    short GetDiagonalJumpDistance( const Map& map, int tileX, int tileY, int direction ) const; // Needs the straight tables and the next tile's entry done
+    bool IsJumpPoint( const Map& map, int tileX, int tileY, int direction ) const;
+    void UpdateRegions( const Map& map );
+};
@@ -0,0 +1,306 @@
+#include "Game/InputReplay.hpp"
+
+#include "Engine/Math/MathUtils.hpp"
+
+
+static constexpr unsigned int INPUT_REPLAY_MAGIC = 0x4c505249; // "IRPL"
+static constexpr unsigned short INPUT_REPLAY_VERSION = 1;
+static constexpr unsigned char INPUT_REPLAY_KEYS_PRESSED_FLAG = 1 << MAX_CONTROLLERS;
+
+
+static void WriteControllerState( BufferWriter& writer, const XboxControllerState& state ) {
+    writer.WriteBool( state.isConnected );
+    writer.WriteUint16( state.buttonFlags );
+    writer.WriteUint8( state.leftTrigger );
+    writer.WriteUint8( state.rightTrigger );
+    writer.WriteInt16( state.leftStickX );
+    writer.WriteInt16( state.leftStickY );
+    writer.WriteInt16( state.rightStickX );
+    writer.WriteInt16( state.rightStickY );
+}
+
+
+static const XboxControllerState ReadControllerState( BufferReader& reader ) {
+    XboxControllerState state;
+    state.isConnected = reader.ReadBool();
+    state.buttonFlags = reader.ReadUint16();
+    state.leftTrigger = reader.ReadUint8();
+    state.rightTrigger = reader.ReadUint8();
+    state.leftStickX = reader.ReadInt16();
+    state.leftStickY = reader.ReadInt16();
+    state.rightStickX = reader.ReadInt16();
+    state.rightStickY = reader.ReadInt16();
+    return state;
+}
+
+
+void InputReplay::StartRecording( const std::string& filePath, unsigned int seed, int startingMapIndex, const InputSystem& input ) {
+    StopReplay();
+
+    m_isRecording = true;
+    m_filePath = filePath;
+    m_seed = seed;
+    m_startingMapIndex = startingMapIndex;
+    m_tickSeconds = 0.f;
+    m_numTicks = 0;
+    m_currentTick = 0;
+    m_finalStateHash = 0;
+
+    m_buffer.clear();
+    m_pendingKeysPressed.clear();
+
+    for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+        m_initialControllerStates[controllerIndex] = input.GetController( controllerIndex ).GetState();
+        m_controllerStates[controllerIndex] = m_initialControllerStates[controllerIndex];
+    }
+}
+
+
+void InputReplay::StopRecording( unsigned int finalStateHash ) {
+    if( !m_isRecording ) {
+        return;
+    }
+
+    m_isRecording = false;
+    m_finalStateHash = finalStateHash;
+
+    ByteBuffer fileBuffer;
+    fileBuffer.reserve( m_buffer.size() + 128 );
+
+    BufferWriter writer( fileBuffer );
+    WriteHeader( writer );
+    writer.WriteBytes( m_buffer.data(), m_buffer.size() );
+
+    bool wasSaved = SaveBufferToFile( m_filePath, fileBuffer );
+    GUARANTEE_RECOVERABLE( wasSaved, Stringf( "Failed to save input replay (%s)", m_filePath.c_str() ) );
+
+    if( wasSaved ) {
+        DebuggerPrintf( "InputReplay: Saved %d ticks to %s (%d bytes)\n", m_numTicks, m_filePath.c_str(), (int)fileBuffer.size() );
+    }
+
+    m_buffer.clear();
+    m_pendingKeysPressed.clear();
+}
+
+
+bool InputReplay::StartReplay( const std::string& filePath ) {
+    StopRecording( 0 );
+    StopReplay();
+
+    if( !LoadFileToBuffer( filePath, m_buffer ) ) {
+        ERROR_RECOVERABLE( Stringf( "Failed to load input replay (%s)", filePath.c_str() ) );
+        return false;
+    }
+
+    BufferReader reader( m_buffer );
+    unsigned int magic = reader.ReadUint32();
+    unsigned short version = reader.ReadUint16();
+
+    if( magic != INPUT_REPLAY_MAGIC || version != INPUT_REPLAY_VERSION ) {
+        ERROR_RECOVERABLE( Stringf( "Input replay (%s) has an unknown format or version %d", filePath.c_str(), version ) );
+        m_buffer.clear();
+        return false;
+    }
+
+    m_seed = reader.ReadUint32();
+    m_startingMapIndex = reader.ReadUint8();
+    m_tickSeconds = reader.ReadFloat();
+    m_numTicks = reader.ReadInt32();
+    m_finalStateHash = reader.ReadUint32();
+
+    for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+        m_initialControllerStates[controllerIndex] = ReadControllerState( reader );
+        m_controllerStates[controllerIndex] = m_initialControllerStates[controllerIndex];
+    }
+
+    if( reader.HasOverrun() ) {
+        ERROR_RECOVERABLE( Stringf( "Input replay (%s) is truncated", filePath.c_str() ) );
+        m_buffer.clear();
+        return false;
+    }
+
+    // A recording stopped before its first tick never learned the tick length, and nothing can replay without one
+    if( !(m_tickSeconds > 0.f) ) {
+        ERROR_RECOVERABLE( Stringf( "Input replay (%s) has no tick length", filePath.c_str() ) );
+        m_buffer.clear();
+        return false;
+    }
+
+    m_isReplaying = true;
+    m_filePath = filePath;
+    m_currentTick = 0;
+    m_readOffset = reader.GetReadOffset();
+    return true;
+}
+
+
+void InputReplay::StopReplay() {
+    if( !m_isReplaying ) {
+        return;
+    }
+
+    m_isReplaying = false;
+    m_buffer.clear();
+    m_readOffset = 0;
+}
+
+
+bool InputReplay::IsRecording() const {
+    return m_isRecording;
+}
+
+
+bool InputReplay::IsReplaying() const {
+    return m_isReplaying;
+}
+
+
+bool InputReplay::IsReplayFinished() const {
+    return (m_isReplaying && m_currentTick >= m_numTicks);
+}
+
+
+void InputReplay::RecordKeyPressed( unsigned char keyCode ) {
+    if( m_isRecording ) {
+        m_pendingKeysPressed.push_back( keyCode );
+    }
+}
+
+
+void InputReplay::RecordTick( float deltaSeconds, const InputSystem& input ) {
+    if( !m_isRecording ) {
+        return;
+    }
+
+    if( m_numTicks == 0 ) {
+        m_tickSeconds = deltaSeconds;
+    }
+
+    GUARANTEE_RECOVERABLE( deltaSeconds == m_tickSeconds, "Input recording expects a fixed tick" );
+
+    unsigned char flags = 0;
+    const XboxControllerState* newStates[MAX_CONTROLLERS] = {};
+
+    for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+        newStates[controllerIndex] = &input.GetController( controllerIndex ).GetState();
+
+        if( *newStates[controllerIndex] != m_controllerStates[controllerIndex] ) {
+            flags |= (unsigned char)(1 << controllerIndex);
+        }
+    }
+
+    int numKeysPressed = ClampInt( (int)m_pendingKeysPressed.size(), 0, 255 ); // More than that in one tick is dropped
+    if( numKeysPressed > 0 ) {
+        flags |= INPUT_REPLAY_KEYS_PRESSED_FLAG;
+    }
+
+    BufferWriter writer( m_buffer );
+    writer.WriteUint8( flags );
+
+    for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+        if( (flags & (1 << controllerIndex)) != 0 ) {
+            m_controllerStates[controllerIndex] = *newStates[controllerIndex];
+            WriteControllerState( writer, m_controllerStates[controllerIndex] );
+        }
+    }
+
+    if( numKeysPressed > 0 ) {
+        writer.WriteUint8( (unsigned char)numKeysPressed );
+        writer.WriteBytes( m_pendingKeysPressed.data(), numKeysPressed );
+    }
+
+    m_pendingKeysPressed.clear();
+    m_numTicks++;
+}
+
+
+bool InputReplay::ReadTick( XboxControllerState* out_controllerStates, KeyCodeList& out_keysPressed ) {
+    out_keysPressed.clear();
+
+    if( !m_isReplaying || m_currentTick >= m_numTicks ) {
+        return false;
+    }
+
+    BufferReader reader( m_buffer, m_readOffset );
+    unsigned char flags = reader.ReadUint8();
+
+    for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+        if( (flags & (1 << controllerIndex)) != 0 ) {
+            m_controllerStates[controllerIndex] = ReadControllerState( reader );
+        }
+
+        out_controllerStates[controllerIndex] = m_controllerStates[controllerIndex];
+    }
+
+    if( (flags & INPUT_REPLAY_KEYS_PRESSED_FLAG) != 0 ) {
+        int numKeysPressed = reader.ReadUint8();
+        out_keysPressed.resize( numKeysPressed );
+        reader.ReadBytes( out_keysPressed.data(), numKeysPressed );
+    }
+
+    if( reader.HasOverrun() ) {
+        ERROR_RECOVERABLE( Stringf( "Input replay (%s) ended early at tick %d of %d", m_filePath.c_str(), m_currentTick, m_numTicks ) );
+        m_numTicks = m_currentTick;
+        out_keysPressed.clear();
+        return false;
+    }
+
+    m_readOffset = reader.GetReadOffset();
+    m_currentTick++;
+    return true;
+}
+
+
+const std::string& InputReplay::GetFilePath() const {
+    return m_filePath;
+}
+
+
+unsigned int InputReplay::GetSeed() const {
+    return m_seed;
+}
+
+
+int InputReplay::GetStartingMapIndex() const {
+    return m_startingMapIndex;
+}
+
+
+float InputReplay::GetTickSeconds() const {
+    return m_tickSeconds;
+}
+
+
+int InputReplay::GetNumTicks() const {
+    return m_numTicks;
+}
+
+
+int InputReplay::GetCurrentTick() const {
+    return m_currentTick;
+}
+
+
+unsigned int InputReplay::GetFinalStateHash() const {
+    return m_finalStateHash;
+}
+
+
+const XboxControllerState& InputReplay::GetInitialControllerState( int controllerID ) const {
+    return m_initialControllerStates[controllerID];
+}
+
+
+void InputReplay::WriteHeader( BufferWriter& writer ) const {
+    writer.WriteUint32( INPUT_REPLAY_MAGIC );
+    writer.WriteUint16( INPUT_REPLAY_VERSION );
+    writer.WriteUint32( m_seed );
+    writer.WriteUint8( (unsigned char)m_startingMapIndex );
+    writer.WriteFloat( m_tickSeconds );
+    writer.WriteInt32( m_numTicks );
+    writer.WriteUint32( m_finalStateHash );
+
+    for( int controllerIndex = 0; controllerIndex < MAX_CONTROLLERS; controllerIndex++ ) {
+        WriteControllerState( writer, m_initialControllerStates[controllerIndex] );
+    }
+}
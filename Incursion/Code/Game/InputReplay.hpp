@@ -0,0 +1,70 @@
+#pragma once
+#include "Engine/Core/BufferUtils.hpp"
+#include "Engine/Input/InputSystem.hpp"
+
+#include "Game/GameCommon.hpp"
+
+#include "string"
+#include "vector"
+
+
+typedef std::vector<unsigned char> KeyCodeList;
+
+
+// Everything the simulation consumes from the player, one entry per tick, plus the seed and map to start from
+// File layout (little-endian):
+//  Header: magic, version, seed, starting map, tick seconds, num ticks, final state hash,
+//      then every XboxControllerState from the poll before the first tick so the first tick gets the same button edges
+//  Per tick: flags byte (bit per controller whose state changed, bit 4 if keys were pressed),
+//      then each changed XboxControllerState, then a key count and the key codes
+// Idle ticks cost one byte, a held stick costs a controller state per tick
+class InputReplay {
+    public:
+    InputReplay() {};
+    ~InputReplay() {};
+
+    void StartRecording( const std::string& filePath, unsigned int seed, int startingMapIndex, const InputSystem& input );
+    void StopRecording( unsigned int finalStateHash ); // Writes the file
+    bool StartReplay( const std::string& filePath ); // Loads the whole file up front
+    void StopReplay();
+
+    bool IsRecording() const;
+    bool IsReplaying() const;
+    bool IsReplayFinished() const;
+
+    // Recording, key presses are buffered and stored with the next tick
+    void RecordKeyPressed( unsigned char keyCode );
+    void RecordTick( float deltaSeconds, const InputSystem& input );
+
+    // Replaying, returns false once every recorded tick has been read
+    bool ReadTick( XboxControllerState* out_controllerStates, KeyCodeList& out_keysPressed );
+
+    const std::string& GetFilePath() const;
+    unsigned int GetSeed() const;
+    int GetStartingMapIndex() const;
+    float GetTickSeconds() const;
+    int GetNumTicks() const;
+    int GetCurrentTick() const;
+    unsigned int GetFinalStateHash() const;
+    const XboxControllerState& GetInitialControllerState( int controllerID ) const;
+
+    private:
+    bool m_isRecording = false;
+    bool m_isReplaying = false;
+    std::string m_filePath = "";
+
+    unsigned int m_seed = 0;
+    int m_startingMapIndex = 0;
+    float m_tickSeconds = 0.f;
+    int m_numTicks = 0;
+    int m_currentTick = 0;
+    unsigned int m_finalStateHash = 0;
+
+    ByteBuffer m_buffer;
+    size_t m_readOffset = 0;
+    XboxControllerState m_initialControllerStates[MAX_CONTROLLERS];
+    XboxControllerState m_controllerStates[MAX_CONTROLLERS]; // Last recorded or replayed, ticks only store changes
+    KeyCodeList m_pendingKeysPressed;
+
+    void WriteHeader( BufferWriter& writer ) const;
+};
@@ -0,0 +1,313 @@
+//-----------------------------------------------------------------------------------------------
+// Main_Headless.cpp
+//
+// Entry point for the headless simulation runner. Built with GAME_HEADLESS defined, so the engine's
+//	RenderContext, InputSystem and AudioSystem are null backends (see EngineBuildPreferences.hpp)
+//	and no window, GL context or fmod is needed.
+//
+// Runs a fixed number of ticks at a fixed delta, then prints ticks per second and per-phase timings.
+//	Always runs in deterministic mode, so the same arguments give the same state hash on every run.
+//	hashEvery=N prints the rolling state hash every N ticks, diff two logs to find the first tick they diverge.
+//	record=file saves the session's input, replay=file plays one back (from the windowed game or here) as fast as possible.
+//		A replay picks its own seed, map and tick rate, runs all its ticks unless ticks= is given,
+//		and exits with 1 if it doesn't end in the recorded state.
+//	benchmarks=1 runs the F5 benchmarks after the simulation.
+//	threads=N sets the number of worker threads for the entity update (default one per extra hardware thread),
+//		the state hash is the same for any N.
+//	players=N connects N scripted controllers (up to MAX_CONTROLLERS), so enemies have someone to chase and shoot.
+//		Without players the AI only wanders, baselines should use players=2. Not allowed with replay, the replay drives the controllers.
+//	Run from the Run folder so Data/ is found, all arguments are optional:
+//		IncursionHeadless ticks=3600 hz=60 seed=1234 map=0 players=2 hashEvery=0 record=Replay.irpl replay=Replay.irpl benchmarks=0 threads=3
+//
+#include "Engine/Audio/AudioSystem.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Input/InputSystem.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/RawNoise.hpp"
+#include "Engine/Math/RNG.hpp"
+#include "Engine/Renderer/RenderContext.hpp"
+
+#include "Game/Game.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/Map.hpp"
+
+
+NamedStrings g_theGameConfigBlackboard; // No ProjectConfig in headless, filled from the command line
+
+enum HeadlessPhase {
+    HEADLESS_PHASE_BEGIN_FRAME,
+    HEADLESS_PHASE_UPDATE,
+    HEADLESS_PHASE_RENDER,
+    HEADLESS_PHASE_END_FRAME,
+
+    NUM_HEADLESS_PHASES
+};
+
+const char* HEADLESS_PHASE_NAMES[NUM_HEADLESS_PHASES] = {
+    "BeginFrame",
+    "Update",
+    "Render",
+    "EndFrame"
+};
+
+
+//-----------------------------------------------------------------------------------------------
+NamedStrings ParseCommandLine( int argc, char** argv ) {
+    NamedStrings args;
+
+    for( int argIndex = 1; argIndex < argc; argIndex++ ) {
+        Strings splitKeyValue = SplitStringOnDelimeter( argv[argIndex], '=' );
+        GUARANTEE_OR_DIE( splitKeyValue.size() == 2, Stringf( "Invalid argument (%s), expected key=value", argv[argIndex] ) );
+
+        args.SetValue( splitKeyValue[0], splitKeyValue[1] );
+    }
+
+    return args;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Startup( int seed, int mapIndex, const std::string& recordPath, const std::string& replayPath, int numWorkerThreads ) {
+    g_RNG = new RNG( (unsigned int)seed );
+
+    g_theJobSystem = new JobSystem();
+    g_theJobSystem->Startup( numWorkerThreads );
+
+    g_theGameConfigBlackboard.SetValue( "deterministic", "true" );
+    g_theGameConfigBlackboard.SetValue( "seed", Stringf( "%d", seed ) );
+    g_theGameConfigBlackboard.SetValue( "recordInput", recordPath );
+    g_theGameConfigBlackboard.SetValue( "replayInput", replayPath );
+
+    g_theRenderer = new RenderContext();
+    g_theRenderer->Startup();
+
+    g_theInput = new InputSystem();
+    g_theInput->Startup();
+
+    g_theAudio = new AudioSystem();
+    g_theAudio->Startup();
+
+    g_theGame = new Game( false, mapIndex );
+    g_theGame->Startup();
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Shutdown() {
+    g_theGame->Shutdown();
+    delete g_theGame;
+    g_theGame = nullptr;
+
+    g_theAudio->Shutdown();
+    delete g_theAudio;
+    g_theAudio = nullptr;
+
+    g_theInput->Shutdown();
+    delete g_theInput;
+    g_theInput = nullptr;
+
+    g_theRenderer->Shutdown();
+    delete g_theRenderer;
+    g_theRenderer = nullptr;
+
+    g_theJobSystem->Shutdown();
+    delete g_theJobSystem;
+    g_theJobSystem = nullptr;
+
+    delete g_RNG;
+    g_RNG = nullptr;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Stand-in for a connected controller, a function of the seed, player and tick only so runs stay deterministic
+// Drives toward a new heading every HEADLESS_PLAYER_TURN_TICKS, sweeps the gun around, holds fire and taps Y to respawn
+//
+XboxControllerState GetScriptedControllerState( unsigned int seed, int playerIndex, int tickIndex ) {
+    XboxControllerState state;
+    state.isConnected = true;
+
+    unsigned int headingNoise = Get1dNoiseUint( tickIndex / HEADLESS_PLAYER_TURN_TICKS, seed + (unsigned int)playerIndex );
+    float moveDegrees = (float)(headingNoise % 360);
+    float aimDegrees = (HEADLESS_PLAYER_AIM_DEGREES_PER_TICK * (float)tickIndex) + (90.f * (float)playerIndex);
+
+    state.leftStickX = (short)(32767.f * CosDegrees( moveDegrees ));
+    state.leftStickY = (short)(32767.f * SinDegrees( moveDegrees ));
+    state.rightStickX = (short)(32767.f * CosDegrees( aimDegrees ));
+    state.rightStickY = (short)(32767.f * SinDegrees( aimDegrees ));
+    state.rightTrigger = 255;
+
+    // Y is only read while dead, alternating ticks makes it a fresh press every other tick
+    if( (tickIndex % 2) == 0 ) {
+        state.buttonFlags = (unsigned short)(1 << XBOX_BUTTON_ID_Y);
+    }
+
+    return state;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Same order as App::RunFrame, timing each stage
+//
+void RunTick( float deltaSeconds, double* phaseSeconds ) {
+    double phaseStart = GetCurrentTimeSeconds();
+
+    g_theInput->BeginFrame();
+    g_theRenderer->BeginFrame();
+    g_theAudio->BeginFrame();
+
+    double phaseEnd = GetCurrentTimeSeconds();
+    phaseSeconds[HEADLESS_PHASE_BEGIN_FRAME] += phaseEnd - phaseStart;
+    phaseStart = phaseEnd;
+
+    g_theGame->Update( deltaSeconds );
+
+    phaseEnd = GetCurrentTimeSeconds();
+    phaseSeconds[HEADLESS_PHASE_UPDATE] += phaseEnd - phaseStart;
+    phaseStart = phaseEnd;
+
+    g_theRenderer->ClearScreen( Rgba( 0.f, 0.f, 0.f, 1.f ) );
+    g_theGame->Render();
+
+    phaseEnd = GetCurrentTimeSeconds();
+    phaseSeconds[HEADLESS_PHASE_RENDER] += phaseEnd - phaseStart;
+    phaseStart = phaseEnd;
+
+    g_theInput->EndFrame();
+    g_theRenderer->EndFrame();
+    g_theAudio->EndFrame();
+
+    phaseEnd = GetCurrentTimeSeconds();
+    phaseSeconds[HEADLESS_PHASE_END_FRAME] += phaseEnd - phaseStart;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void PrintPhase( const char* name, double seconds, double totalSeconds, int numTicks ) {
+    double milliseconds = seconds * 1000.0;
+    double microsecondsPerTick = (seconds * 1000000.0) / (double)numTicks;
+    double percent = (totalSeconds > 0.0) ? (100.0 * seconds / totalSeconds) : 0.0;
+
+    DebuggerPrintf( "  %-14s %10.2fms %10.2fus/tick %6.1f%%\n", name, milliseconds, microsecondsPerTick, percent );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+int main( int argc, char** argv ) {
+    NamedStrings args = ParseCommandLine( argc, argv );
+    int numTicks = args.GetValue( "ticks", HEADLESS_DEFAULT_NUM_TICKS );
+    int tickRate = args.GetValue( "hz", APP_DEFAULT_TICK_RATE );
+    int seed = args.GetValue( "seed", GAME_DEFAULT_SEED );
+    int mapIndex = args.GetValue( "map", 0 );
+    int hashEvery = args.GetValue( "hashEvery", 0 );
+    std::string recordPath = args.GetValue( "record", "" );
+    std::string replayPath = args.GetValue( "replay", "" );
+    bool runBenchmarks = args.GetValue( "benchmarks", false );
+    int numWorkerThreads = args.GetValue( "threads", APP_DEFAULT_WORKER_THREADS );
+    bool areBulletsProjectiles = args.GetValue( "projectiles", false );
+    int numPlayers = args.GetValue( "players", 0 );
+
+    GUARANTEE_OR_DIE( numTicks > 0 && tickRate > 0, Stringf( "ticks (%d) and hz (%d) must be positive", numTicks, tickRate ) );
+    GUARANTEE_OR_DIE( numPlayers >= 0 && numPlayers <= MAX_CONTROLLERS, Stringf( "players (%d) must be 0 to %d", numPlayers, MAX_CONTROLLERS ) );
+    GUARANTEE_OR_DIE( numPlayers == 0 || replayPath.empty(), "players can't be used with replay, the replay drives the controllers" );
+    float deltaSeconds = 1.f / (float)tickRate;
+
+    g_theGameConfigBlackboard.SetValue( "bulletProjectiles", areBulletsProjectiles ? "true" : "false" );
+    double startupStart = GetCurrentTimeSeconds();
+    Startup( seed, mapIndex, recordPath, replayPath, numWorkerThreads );
+    double startupSeconds = GetCurrentTimeSeconds() - startupStart;
+
+    const InputReplay& replay = g_theGame->GetInputReplay();
+    bool isReplaying = replay.IsReplaying();
+
+    if( isReplaying ) {
+        numTicks = args.GetValue( "ticks", replay.GetNumTicks() );
+        deltaSeconds = replay.GetTickSeconds();
+        tickRate = (int)((1.f / deltaSeconds) + 0.5f);
+        seed = (int)replay.GetSeed();
+        mapIndex = replay.GetStartingMapIndex();
+        GUARANTEE_OR_DIE( numTicks > 0, Stringf( "Input replay (%s) has no ticks", replayPath.c_str() ) );
+    } else {
+        GUARANTEE_OR_DIE( replayPath.empty(), Stringf( "Failed to start input replay (%s)", replayPath.c_str() ) );
+    }
+
+    // Scripted players replace polling the same way a replay does, a recording saves what they did
+    if( numPlayers > 0 ) {
+        g_theInput->SetControllerPlayback( true );
+    }
+
+    double phaseSeconds[NUM_HEADLESS_PHASES] = {};
+    double numSkippedPairs = 0.0;
+    double numAwake = 0.0;
+    double numAsleep = 0.0;
+    double numSleepingPairs = 0.0;
+    double runStart = GetCurrentTimeSeconds();
+
+    for( int tickIndex = 0; tickIndex < numTicks; tickIndex++ ) {
+        for( int playerIndex = 0; playerIndex < numPlayers; playerIndex++ ) {
+            g_theInput->ApplyControllerState( playerIndex, GetScriptedControllerState( (unsigned int)seed, playerIndex, tickIndex ) );
+        }
+
+        RunTick( deltaSeconds, phaseSeconds );
+        const Map* activeMap = g_theGame->GetActiveMap();
+        numSkippedPairs += (double)activeMap->GetNumSkippedPairs();
+
+        int tickAwake;
+        int tickAsleep;
+        int tickSleepingPairs;
+        activeMap->GetSleepStats( tickAwake, tickAsleep, tickSleepingPairs );
+        numAwake += (double)tickAwake;
+        numAsleep += (double)tickAsleep;
+        numSleepingPairs += (double)tickSleepingPairs;
+
+        if( hashEvery > 0 && ((tickIndex + 1) % hashEvery) == 0 ) {
+            DebuggerPrintf( "Tick %d: %08x\n", tickIndex + 1, g_theGame->GetStateHash() );
+        }
+    }
+
+    double runSeconds = GetCurrentTimeSeconds() - runStart;
+    double ticksPerSecond = (double)numTicks / runSeconds;
+    double simulatedSeconds = (double)numTicks * (double)deltaSeconds;
+
+    const Map* map = g_theGame->GetActiveMap();
+    IntVec2 dimensions = map->GetDimensions();
+
+    DebuggerPrintf( "Headless: map %d (%dx%d), seed %d, %d ticks at %dHz (%.1fs simulated)\n", mapIndex, dimensions.x, dimensions.y, seed, numTicks, tickRate, simulatedSeconds );
+    int numProjectiles;
+    int projectileHighWaterMark;
+    map->GetProjectileStats( numProjectiles, projectileHighWaterMark );
+
+    DebuggerPrintf( "Startup: %.2fms, entities at end: %d, worker threads: %d, scripted players: %d\n", startupSeconds * 1000.0, map->GetNumEntities(), g_theJobSystem->GetNumWorkerThreads(), numPlayers );
+    DebuggerPrintf( "Projectiles at end: %d (peak %d)\n", numProjectiles, projectileHighWaterMark );
+
+    const PathRequestStats& pathStats = map->GetPathRequestStats();
+    DebuggerPrintf( "Path requests: %d submitted, %d deduplicated, %d searches, %.0f%% cache hits, %d queued at end (peak %d), latency %.2f ticks (max %d)\n",
+        pathStats.numSubmitted, pathStats.numDeduplicated, pathStats.numSearches, pathStats.GetCacheHitRate() * 100.f, pathStats.numPending, pathStats.peakPending, pathStats.GetAverageLatencyTicks(), pathStats.maxLatencyTicks );
+    DebuggerPrintf( "State hash: %08x after %d map ticks\n", g_theGame->GetStateHash(), map->GetNumTicks() );
+    DebuggerPrintf( "Ticks/sec: %.1f (%.3fms/tick, %.1fx realtime)\n", ticksPerSecond, (runSeconds * 1000.0) / (double)numTicks, simulatedSeconds / runSeconds );
+    DebuggerPrintf( "Collision pairs skipped by layers: %.1f/tick, by sleep: %.1f/tick\n", numSkippedPairs / (double)numTicks, numSleepingPairs / (double)numTicks );
+    DebuggerPrintf( "Entities awake: %.1f/tick, asleep: %.1f/tick\n", numAwake / (double)numTicks, numAsleep / (double)numTicks );
+
+    for( int phaseIndex = 0; phaseIndex < NUM_HEADLESS_PHASES; phaseIndex++ ) {
+        PrintPhase( HEADLESS_PHASE_NAMES[phaseIndex], phaseSeconds[phaseIndex], runSeconds, numTicks );
+
+        if( phaseIndex == HEADLESS_PHASE_UPDATE ) {
+            for( int mapPhaseIndex = 0; mapPhaseIndex < NUM_MAP_PHASES; mapPhaseIndex++ ) {
+                MapUpdatePhase mapPhase = (MapUpdatePhase)mapPhaseIndex;
+                std::string name = Stringf( "  %s", Map::GetPhaseName( mapPhase ) );
+                PrintPhase( name.c_str(), map->GetPhaseSeconds( mapPhase ), runSeconds, numTicks );
+            }
+        }
+    }
+
+    if( runBenchmarks ) {
+        g_theGame->RunBenchmarks();
+    }
+
+    bool didReplayMatch = isReplaying ? g_theGame->StopInputReplay() : true;
+
+    Shutdown();
+    return didReplayMatch ? 0 : 1;
+}
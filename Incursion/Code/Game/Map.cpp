@@ -1,9 +1,12 @@
 #include "Game/Map.hpp"
 
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/Time.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Math/IntVec2.hpp"
 #include "Engine/Math/MathUtils.hpp"
-#include "Engine/Math/RNG.hpp"
+#include "Engine/Math/Matrix44.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 #include "Engine/Renderer/SpriteAnimDef.hpp"
 #include "Engine/Renderer/SpriteSheet.hpp"
@@ -13,9 +16,112 @@
 #include "Game/Bullet.hpp"
 #include "Game/EnemyTank.hpp"
 #include "Game/EnemyTurret.hpp"
-#include "Game/Explosion.hpp"
 #include "Game/PlayerTank.hpp"
 #include "Game/RaycastResult.hpp"
+#include "Game/StateHash.hpp"
+
+#include "algorithm"
+#include "emmintrin.h"
+#include "float.h"
+
+
+static constexpr unsigned int MAP_SNAPSHOT_MAGIC = 0x504e534d; // "MSNP"
+static constexpr unsigned short MAP_SNAPSHOT_VERSION = 5; // 2: entity sleep state, 3: projectiles, 4: path requests, 5: handles in the entity header
+static constexpr size_t MAP_SNAPSHOT_HEADER_NUM_BYTES = 4 + 2 + 8 + 1; // Magic, version, dimensions, arena mode
+
+static thread_local MapCommandBuffer* s_jobCommandBuffer = nullptr; // Set while a thread runs an entity update job
+
+
+// Transfers first, then spawns grouped by type, stable so each type keeps the order it was requested in
+static bool IsStructuralCommandBefore( const MapCommand& commandA, const MapCommand& commandB ) {
+    int orderA = (commandA.type == MAP_COMMAND_TRANSFER_PLAYERS) ? -1 : (int)commandA.entityType;
+    int orderB = (commandB.type == MAP_COMMAND_TRANSFER_PLAYERS) ? -1 : (int)commandB.entityType;
+    return orderA < orderB;
+}
+
+
+static int GetEntitySnapshotNumBytes( EntityType type ) {
+    switch(type) {
+        case(ENTITY_TYPE_BOULDER): {
+            return Boulder::GetSnapshotNumBytes();
+        } case(ENTITY_TYPE_BULLET): {
+            return Bullet::GetSnapshotNumBytes();
+        } case(ENTITY_TYPE_ENEMYTANK): {
+            return EnemyTank::GetSnapshotNumBytes();
+        } case(ENTITY_TYPE_ENEMYTURRET): {
+            return EnemyTurret::GetSnapshotNumBytes();
+        } case(ENTITY_TYPE_PLAYERTANK): {
+            return PlayerTank::GetSnapshotNumBytes();
+        } default: {
+            return 0;
+        }
+    }
+}
+
+
+static __m128 SelectFloat4( const __m128& mask, const __m128& ifTrue, const __m128& ifFalse ) {
+    return _mm_or_ps( _mm_and_ps( mask, ifTrue ), _mm_andnot_ps( mask, ifFalse ) );
+}
+
+
+static __m128i SelectInt4( const __m128i& mask, const __m128i& ifTrue, const __m128i& ifFalse ) {
+    return _mm_or_si128( _mm_and_si128( mask, ifTrue ), _mm_andnot_si128( mask, ifFalse ) );
+}
+
+
+// Insertion sort, there are only ever a few fractions per pair
+static void SortTickFractions( float* tickFractions, int numFractions ) {
+    for( int fractionIndex = 1; fractionIndex < numFractions; fractionIndex++ ) {
+        float fraction = tickFractions[fractionIndex];
+        int insertIndex = fractionIndex;
+
+        for( ; insertIndex > 0 && tickFractions[insertIndex - 1] > fraction; insertIndex-- ) {
+            tickFractions[insertIndex] = tickFractions[insertIndex - 1];
+        }
+
+        tickFractions[insertIndex] = fraction;
+    }
+}
+
+
+// Swept entities are tested along their whole move this tick (relative to the other's), so fast ones can't pass through
+// Bounces split the move into legs, between any two corners of either entity both move in straight lines
+static bool DoSweptDiscsTouch( const EntityComponentChunk& chunk1, int index1, const EntityComponentChunk& chunk2, int index2 ) {
+    float radius1 = chunk1.physicsRadii[index1];
+    float radius2 = chunk2.physicsRadii[index2];
+
+    if( DoDiscsOverlap( chunk1.positions[index1], radius1, chunk2.positions[index2], radius2 ) ) {
+        return true;
+    }
+
+    Vec2 points[ENTITY_MAX_SWEEP_CORNERS + 2];
+    float tickFractions[(2 * ENTITY_MAX_SWEEP_CORNERS) + 4];
+    int numFractions = GetSweepPoints( chunk1, index1, points, &tickFractions[0] );
+    numFractions += GetSweepPoints( chunk2, index2, points, &tickFractions[numFractions] );
+    SortTickFractions( tickFractions, numFractions );
+
+    for( int fractionIndex = 1; fractionIndex < numFractions; fractionIndex++ ) {
+        float legStart = tickFractions[fractionIndex - 1];
+        float legEnd = tickFractions[fractionIndex];
+
+        if( legEnd <= legStart ) {
+            continue;
+        }
+
+        Vec2 start1 = GetSweptPosition( chunk1, index1, legStart );
+        Vec2 start2 = GetSweptPosition( chunk2, index2, legStart );
+        Vec2 relativeDisplacement = (GetSweptPosition( chunk1, index1, legEnd ) - start1) - (GetSweptPosition( chunk2, index2, legEnd ) - start2);
+
+        float impactFraction;
+        Vec2 impactNormal;
+
+        if( SweepDiscVsDisc( start1, relativeDisplacement, radius1, start2, radius2, impactFraction, impactNormal ) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
 
 
 Map::Map( const IntVec2& dimensions, TileType groundType, TileType wallType, std::map<TileType, float> randomTileFractionsByType, std::map<EntityType, int> numEntitiesByType, bool arenaMode ) :
@@ -24,31 +130,42 @@ Map::Map( const IntVec2& dimensions, TileType groundType, TileType wallType, std
     m_wallType( wallType ),
     m_tileFractions( randomTileFractionsByType ),
     m_numEntities( numEntitiesByType ),
-    m_arenaMode( arenaMode ) {
-
-    m_entitiesByType[ENTITY_TYPE_PLAYERTANK].clear();
-    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
-        m_entitiesByType[ENTITY_TYPE_PLAYERTANK].push_back( nullptr );
-    }
+    m_arenaMode( arenaMode ),
+    m_rng( 0 ) {
 }
 
 
 void Map::Startup() {
-    UpdateFromController( 0.f );
+    SetSeed( m_seed );
+    m_rollingStateHash = StateHash().GetHash();
+    m_numTicks = 0;
 
-    StartupMakeAllGroundTiles(); // Initialize ground
-    StartupAddWallBorder(); // Add border
+    m_bulletPool.Startup( this, BULLET_POOL_SIZE );
+    m_explosionParticles.Startup();
+    m_projectiles.Startup();
+    m_spatialHash.Startup( m_mapDimensions );
 
-    // Add all random tiles as requested
-    std::map<TileType, float>::iterator tileIter;
-    for( tileIter = m_tileFractions.begin(); tileIter != m_tileFractions.end(); tileIter++ ) {
-        TileType type = tileIter->first;
-        float fraction = tileIter->second;
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        m_playerFlowFields[playerIndex].Startup( m_mapDimensions );
+        m_flowFieldTargets[playerIndex] = EntityHandle::INVALID;
+    }
 
-        StartupAddRandomTiles( type, fraction );
+    if( g_theGameConfigBlackboard.GetValue( "bulletProjectiles", false ) ) {
+        m_areBulletsProjectiles = true;
     }
 
-    StartupAddSafeBunkers(); // Add safe bunker at starting (and eventually ending) point
+    m_collisionLayers.SetDefaults();
+    m_collisionLayers.SetFromString( g_theGameConfigBlackboard.GetValue( "collisionLayers", "" ) );
+
+    IntVec2 numMeshChunks = GetNumMeshChunks();
+    m_meshChunks.resize( numMeshChunks.x * numMeshChunks.y );
+
+    StartupTiles();
+    m_pathfinder.Startup( *this );
+    m_pathRequests.Startup();
+
+    // Players join (or arrive from the previous map) in the first Update
+    m_isDeferringStructuralChanges = true;
 
     // Add all entities as requested
     std::map<EntityType, int>::iterator entityIter;
@@ -58,85 +175,132 @@ void Map::Startup() {
 
         StartupAddEntities( type, numEntities );
     }
+
+    ApplyStructuralChanges();
+    m_isDeferringStructuralChanges = false;
 }
 
 
-void Map::Shutdown() {
-    int numEntities = (int)m_entities.size();
-    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
-        Entity* entity = m_entities[entityIndex];
-        if( entity != nullptr ) {
-            DestroyEntity( *entity );
-        }
+void Map::StartupTiles() {
+    StartupMakeAllGroundTiles(); // Initialize ground
+    StartupAddWallBorder(); // Add border
+
+    // Add all random tiles as requested
+    std::map<TileType, float>::iterator tileIter;
+    for( tileIter = m_tileFractions.begin(); tileIter != m_tileFractions.end(); tileIter++ ) {
+        TileType type = tileIter->first;
+        float fraction = tileIter->second;
+
+        StartupAddRandomTiles( type, fraction );
     }
 
-    int numExplosions = (int)m_explosions.size();
-    for( int explosionIndex = 0; explosionIndex < numExplosions; explosionIndex++ ) {
-        Entity* explosion = m_explosions[explosionIndex];
-        if( explosion != nullptr ) {
-            DestroyEntity( *explosion );
-        }
+    StartupAddSafeBunkers(); // Add safe bunker at starting (and eventually ending) point
+}
+
+
+void Map::Shutdown() {
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    while( !entities.empty() ) {
+        DestroyEntity( *entities.back() );
     }
 
-    m_entities.clear();
-    m_explosions.clear();
+    m_entityRegistry.Clear();
+    m_structuralCommands.clear();
+    m_arePlayersLeaving = false;
+    m_bulletPool.Shutdown();
+    m_explosionParticles.Shutdown();
+    m_projectiles.Shutdown();
     m_tiles.clear();
+    m_tileSolidBits.clear();
+    m_tileMovementModifiers.clear();
+    m_meshChunks.clear();
+    m_builtMeshChunks.clear();
+    m_rayQueries.clear();
+    m_rayResults.clear();
+    m_spatialHash.Shutdown();
+    m_pathfinder.Shutdown();
+    m_pathRequests.Shutdown();
 
-    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
-        m_entitiesByType[typeIndex].clear();
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        m_playerFlowFields[playerIndex].Shutdown();
+        m_flowFieldTargets[playerIndex] = EntityHandle::INVALID;
     }
 }
 
 
 void Map::Update( float deltaSeconds ) {
+    // Entity lists stay fixed until the sync point at the end of the tick
+    m_isDeferringStructuralChanges = true;
+    StorePreviousTransforms();
+    double phaseStart = GetCurrentTimeSeconds();
+
     UpdateFromController( deltaSeconds );
+    phaseStart = EndPhase( MAP_PHASE_CONTROLLER, phaseStart );
 
-    for( int entityIndex = 0; entityIndex < (int)m_entities.size(); entityIndex++ ) {
-        Entity* entity = m_entities[entityIndex];
-        if( entity != nullptr ) {
-            entity->Update( deltaSeconds );
-        }
-    }
+    UpdateFlowFields();
+    phaseStart = EndPhase( MAP_PHASE_FLOW_FIELDS, phaseStart );
 
-    for( int explosionIndex = 0; explosionIndex < (int)m_explosions.size(); explosionIndex++ ) {
-        Entity* explosion = m_explosions[explosionIndex];
-        if( explosion != nullptr ) {
-            explosion->Update( deltaSeconds );
-        }
+    UpdateRaycasts();
+    phaseStart = EndPhase( MAP_PHASE_RAYCASTS, phaseStart );
+
+    UpdateEntities( deltaSeconds );
+    phaseStart = EndPhase( MAP_PHASE_ENTITIES, phaseStart );
+
+    // Regions are only relabelled after tile changes, and only on ticks that have searches to run
+    if( m_pathRequests.GetStats().numPending > 0 ) {
+        m_pathfinder.UpdateRegionsIfDirty( *this );
     }
 
+    m_pathRequests.Update( *this, m_numTicks );
+    phaseStart = EndPhase( MAP_PHASE_PATHS, phaseStart );
+
+    m_explosionParticles.Update( deltaSeconds );
+    phaseStart = EndPhase( MAP_PHASE_PARTICLES, phaseStart );
+
     UpdateCollision();
+    phaseStart = EndPhase( MAP_PHASE_COLLISION, phaseStart );
 
-    CollectGarbage();
-}
+    // After collision so entity hits use this tick's broadphase
+    m_projectiles.Update( deltaSeconds, *this );
+    phaseStart = EndPhase( MAP_PHASE_PROJECTILES, phaseStart );
 
+    ApplyStructuralChanges();
+    m_isDeferringStructuralChanges = false;
+    EndPhase( MAP_PHASE_STRUCTURAL, phaseStart );
 
-void Map::Render() const {
-    SpriteSheet terrainSprites = TileDef::GetSpriteSheet();
-    const Texture* terrainTexture = terrainSprites.GetTexture();
-    g_theRenderer->BindTexture( terrainTexture );
+    if( m_isStateHashingEnabled ) {
+        StateHash rollingHash( m_rollingStateHash );
+        rollingHash.AddUint( ComputeStateHash() );
+        m_rollingStateHash = rollingHash.GetHash();
+    }
 
-    std::vector<Vertex_PCU> mapVerts;
-    mapVerts = BuildMapVerts();
-    g_theRenderer->DrawVertexArray( mapVerts );
+    m_numTicks++;
+}
+
+
+void Map::Render( const AABB2& viewBounds, float tickAlpha /*= 1.f*/ ) const {
+    RenderMeshChunks( viewBounds );
 
-    int numEntities = (int)m_entities.size();
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    int numEntities = (int)entities.size();
 
     for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
-        Entity* entity = m_entities[entityIndex];
-        if( entity != nullptr ) {
-            entity->Render();
-        }
+        const Entity* entity = entities[entityIndex];
+        g_theRenderer->SetModelMatrix( entity->GetInterpolationTransform( tickAlpha ) );
+        entity->Render();
     }
 
-    int numExplosions = (int)m_explosions.size();
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        PlayerTank* player = GetPlayer( playerIndex );
 
-    for( int explosionIndex = 0; explosionIndex < numExplosions; explosionIndex++ ) {
-        Entity* explosion = m_explosions[explosionIndex];
-        if( explosion != nullptr ) {
-            explosion->Render();
+        if( player != nullptr ) {
+            player->RenderExtraLives( tickAlpha );
         }
     }
+
+    g_theRenderer->SetModelMatrix( Matrix44() );
+    m_projectiles.Render();
+    m_explosionParticles.Render();
 }
 
 
@@ -152,6 +316,11 @@ const IntVec2& Map::GetDimensions() const {
 }
 
 
+const std::vector<unsigned int>& Map::GetTileSolidBits() const {
+    return m_tileSolidBits;
+}
+
+
 const IntVec2 Map::GetTileCoordsFromWorldCoords( const Vec2& worldCoords ) const {
     int tempX = ClampInt( (int)worldCoords.x, 0, m_mapDimensions.x - 1);
     int tempY = ClampInt( (int)worldCoords.y, 0, m_mapDimensions.y - 1);
@@ -177,6 +346,21 @@ int Map::GetTileIndexFromWorldCoords( const Vec2& worldCoords ) const {
 }
 
 
+const IntVec2 Map::GetTileCoordsFromTileIndex( int tileIndex ) const {
+    int tileX = tileIndex % m_mapDimensions.x;
+    int tileY = tileIndex / m_mapDimensions.x;
+    return IntVec2( tileX, tileY );
+}
+
+
+const AABB2 Map::GetTileBounds( int tileIndex ) const {
+    IntVec2 tileCoords = GetTileCoordsFromTileIndex( tileIndex );
+    Vec2 mins = Vec2( (float)tileCoords.x, (float)tileCoords.y );
+    Vec2 maxs = mins + Vec2( 1.f, 1.f );
+    return AABB2( mins, maxs );
+}
+
+
 const Tile& Map::GetTileFromTileCoords( const IntVec2& tileCoords ) const {
     int tileIndex = GetTileIndexFromTileCoords( tileCoords );
     return m_tiles[tileIndex];
@@ -196,7 +380,32 @@ const Tile& Map::GetTileFromWorldCoords( const Vec2& worldCoords ) const {
 
 
 PlayerTank* Map::GetPlayer( int playerIndex ) const {
-    return (PlayerTank*)m_entitiesByType[ENTITY_TYPE_PLAYERTANK][playerIndex];
+    return m_players[playerIndex];
+}
+
+
+int Map::GetNumEntities() const {
+    return m_entityRegistry.GetNumEntities();
+}
+
+
+const EntityRegistry& Map::GetEntityRegistry() const {
+    return m_entityRegistry;
+}
+
+
+Entity* Map::GetEntity( const EntityHandle& handle ) const {
+    return m_entityRegistry.GetEntity( handle );
+}
+
+
+const EntityTickState* Map::GetTickState( const EntityHandle& handle ) const {
+    if( handle.index < 0 || handle.index >= (int)m_tickStates.size() ) {
+        return nullptr;
+    }
+
+    const EntityTickState& state = m_tickStates[handle.index];
+    return (state.handle == handle) ? &state : nullptr;
 }
 
 
@@ -233,85 +442,259 @@ bool Map::IsArenaMode() const {
 }
 
 
-Entity* Map::SpawnNewEntity( EntityType type, const Vec2& position, float orientationDegrees, Entity* source ) {
-    Entity* entity = nullptr;
+void Map::SpawnNewEntity( EntityType type, const Vec2& position, float orientationDegrees, Entity* source ) {
+    if( type == ENTITY_TYPE_PLAYERTANK ) {
+        return; // Players join from UpdateFromController
+    }
 
-    switch(type) {
-        case(ENTITY_TYPE_BOULDER): {
-            entity = (Entity*)(new Boulder( this ));
-            break;
-        } case(ENTITY_TYPE_BULLET): {
-            entity = (Entity*)(new Bullet( this, source ));
-            break;
-        } case(ENTITY_TYPE_ENEMYTANK): {
-            entity = (Entity*)(new EnemyTank( this ));
-            break;
-        } case(ENTITY_TYPE_ENEMYTURRET): {
-            entity = (Entity*)(new EnemyTurret( this ));
-            break;
-        } default: {
-            return nullptr;
-        }
+    MapCommand command;
+    command.type = MAP_COMMAND_SPAWN_ENTITY;
+    command.entityType = type;
+    command.position = position;
+    command.orientationDegrees = orientationDegrees;
+
+    if( source != nullptr ) {
+        command.sourceFaction = source->GetFaction();
+        command.sourceHandle = source->GetHandle();
     }
 
-    entity->m_position = position;
-    entity->m_orientationDegrees = orientationDegrees;
+    QueueStructuralCommand( command );
+}
 
-    AddEntityToMap( *entity );
-    entity->Startup();
 
-    return entity;
+void Map::SpawnNewExplosion( const Vec2& position, float scale, float duration /*= EXPLOSION_DURATION */ ) {
+    if( s_jobCommandBuffer != nullptr ) {
+        MapCommand command;
+        command.type = MAP_COMMAND_SPAWN_EXPLOSION;
+        command.position = position;
+        command.scale = scale;
+        command.duration = duration;
+
+        s_jobCommandBuffer->push_back( command );
+        return;
+    }
+
+    m_explosionParticles.SpawnParticle( position, scale, duration );
 }
 
 
-Explosion* Map::SpawnNewExplosion( const Vec2& position, float scale, float duration /*= EXPLOSION_DURATION */ ) {
-    Explosion* explosion = new Explosion( this, position, scale, duration );
-    //explosion->m_orientationDegrees = g_RNG->GetRandomFloatInRange( 0.f, 360.f );
+void Map::PlaySound( SoundID sound ) {
+    if( s_jobCommandBuffer != nullptr ) {
+        MapCommand command;
+        command.type = MAP_COMMAND_PLAY_SOUND;
+        command.sound = sound;
 
-    AddEntityToMap( *(Entity*)explosion );
-    explosion->Startup();
+        s_jobCommandBuffer->push_back( command );
+        return;
+    }
 
-    return explosion;
+    g_theAudio->PlaySound( sound );
 }
 
 
 const RaycastResult Map::Raycast( const Vec2& startPosition, const Vec2& normalizedDirection, float maxDistance /*= MAP_RAYCAST_MAX_DISTANCE*/ ) const {
-    float stepDistance = maxDistance / (float)MAP_RAYCAST_NUM_SAMPLES;
-    Vec2 stepStride = stepDistance * normalizedDirection;
-    Vec2 samplePosition = startPosition;
-    
-    for( float distance = 0.f; distance < maxDistance; distance += stepDistance ) {
-        const Tile tile = GetTileFromWorldCoords( samplePosition );
-
-        if( tile.IsSolid() ) {
+    // Amanatides-Woo grid traversal, visits exactly the tiles the ray crosses
+    int tileX = (int)floorf( startPosition.x );
+    int tileY = (int)floorf( startPosition.y );
+
+    if( IsTileSolid( tileX, tileY ) ) { // Started inside a wall
+        RaycastResult result = RaycastResult();
+        result.impactDistance = 0.f;
+        result.impactFraction = 0.f;
+        result.impactPosition = startPosition;
+        result.impactNormal = Vec2( -normalizedDirection.x, -normalizedDirection.y );
+        result.impactTile = GetImpactTile( tileX, tileY );
+        result.didImpact = true;
+
+        return result;
+    }
+
+    int stepX = (normalizedDirection.x < 0.f) ? -1 : 1;
+    int stepY = (normalizedDirection.y < 0.f) ? -1 : 1;
+
+    // Distance along the ray to cross one full tile on each axis
+    float deltaDistX = (normalizedDirection.x != 0.f) ? fabsf( 1.f / normalizedDirection.x ) : FLT_MAX;
+    float deltaDistY = (normalizedDirection.y != 0.f) ? fabsf( 1.f / normalizedDirection.y ) : FLT_MAX;
+
+    // Distance along the ray to the first tile edge on each axis
+    float edgeOffsetX = (stepX > 0) ? ((float)(tileX + 1) - startPosition.x) : (startPosition.x - (float)tileX);
+    float edgeOffsetY = (stepY > 0) ? ((float)(tileY + 1) - startPosition.y) : (startPosition.y - (float)tileY);
+    float nextDistX = (normalizedDirection.x != 0.f) ? edgeOffsetX * deltaDistX : FLT_MAX;
+    float nextDistY = (normalizedDirection.y != 0.f) ? edgeOffsetY * deltaDistY : FLT_MAX;
+
+    while( true ) {
+        float distance;
+        Vec2 normal;
+
+        if( nextDistX < nextDistY ) {
+            distance = nextDistX;
+            tileX += stepX;
+            nextDistX += deltaDistX;
+            normal = Vec2( (float)-stepX, 0.f );
+        } else {
+            distance = nextDistY;
+            tileY += stepY;
+            nextDistY += deltaDistY;
+            normal = Vec2( 0.f, (float)-stepY );
+        }
+
+        if( distance > maxDistance ) {
+            return RaycastResult();
+        }
+
+        if( IsTileSolid( tileX, tileY ) ) {
             RaycastResult result = RaycastResult();
             result.impactDistance = distance;
-            result.impactFraction = result.impactDistance / maxDistance;
-            result.impactPosition = samplePosition;
-            result.impactTile = &tile;
+            result.impactFraction = distance / maxDistance;
+            result.impactPosition = startPosition + (distance * normalizedDirection);
+            result.impactNormal = normal;
+            result.impactTile = GetImpactTile( tileX, tileY );
+            result.didImpact = true;
 
             return result;
         }
+    }
+}
 
-        samplePosition += stepStride;
+
+const Tile* Map::GetImpactTile( int tileX, int tileY ) const {
+    if( tileX < 0 || tileX >= m_mapDimensions.x || tileY < 0 || tileY >= m_mapDimensions.y ) {
+        return nullptr;
     }
 
-    return RaycastResult();
+    return &GetTileFromTileCoords( tileX, tileY );
 }
 
 
-bool Map::HasLineOfSight( const Entity* source, const Entity* destination ) const {
-    Vec2 start = source->GetPosition();
-    Vec2 direction = destination->GetPosition() - start;
-    float maxDistance = direction.NormalizeGetPreviousLength();
+bool Map::SweepDiscVsTiles( const Vec2& start, const Vec2& displacement, float radius, float& out_impactFraction, AABB2& out_tileBounds ) const {
+    // Every solid tile under the bounds of the whole move, nearest impact wins
+    Vec2 end = start + displacement;
+    int minTileX = (int)floorf( ((start.x < end.x) ? start.x : end.x) - radius );
+    int minTileY = (int)floorf( ((start.y < end.y) ? start.y : end.y) - radius );
+    int maxTileX = (int)floorf( ((start.x > end.x) ? start.x : end.x) + radius );
+    int maxTileY = (int)floorf( ((start.y > end.y) ? start.y : end.y) + radius );
+
+    bool didHit = false;
+    out_impactFraction = 1.f;
+
+    for( int tileY = minTileY; tileY <= maxTileY; tileY++ ) {
+        for( int tileX = minTileX; tileX <= maxTileX; tileX++ ) {
+            if( !IsTileSolid( tileX, tileY ) ) {
+                continue;
+            }
+
+            AABB2 tileBounds = AABB2( Vec2( (float)tileX, (float)tileY ), Vec2( (float)(tileX + 1), (float)(tileY + 1) ) );
+            float impactFraction;
+            Vec2 impactNormal;
+
+            if( SweepDiscVsAABB2( start, displacement, radius, tileBounds, impactFraction, impactNormal ) && (!didHit || impactFraction < out_impactFraction) ) {
+                didHit = true;
+                out_impactFraction = impactFraction;
+                out_tileBounds = tileBounds;
+            }
+        }
+    }
+
+    return didHit;
+}
+
+
+bool Map::IsTileSolid( int tileIndex ) const {
+    unsigned int solidWord = m_tileSolidBits[tileIndex >> 5];
+    return ((solidWord >> (tileIndex & 31)) & 1) != 0;
+}
+
+
+bool Map::IsTileSolid( int tileX, int tileY ) const {
+    // Everything past the edge of the map counts as wall
+    if( tileX < 0 || tileX >= m_mapDimensions.x || tileY < 0 || tileY >= m_mapDimensions.y ) {
+        return true;
+    }
+
+    int tileIndex = (tileY * m_mapDimensions.x) + tileX;
+    return IsTileSolid( tileIndex );
+}
+
+
+bool Map::IsTileSolidAtWorldCoords( const Vec2& worldCoords ) const {
+    int tileIndex = GetTileIndexFromWorldCoords( worldCoords );
+    return IsTileSolid( tileIndex );
+}
+
+
+float Map::GetMovementModifierAtWorldCoords( const Vec2& worldCoords ) const {
+    int tileIndex = GetTileIndexFromWorldCoords( worldCoords );
+    return m_tileMovementModifiers[tileIndex];
+}
+
+
+TileType Map::GetTileTypeAtWorldCoords( const Vec2& worldCoords ) const {
+    int tileIndex = GetTileIndexFromWorldCoords( worldCoords );
+    return m_tiles[tileIndex].GetTileType();
+}
+
+
+void Map::SetTileType( int tileIndex, TileType type ) {
+    m_tiles[tileIndex].SetTileType( type );
+    UpdateTileProperties( tileIndex );
+
+    UpdateTileVerts( tileIndex );
+
+    m_pathfinder.OnTileChanged( *this, tileIndex );
+    m_pathRequests.OnTileChanged();
+
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        m_playerFlowFields[playerIndex].OnTileChanged( *this, tileIndex );
+    }
+}
+
+
+size_t Map::GetTileMemoryBytes() const {
+    size_t tileBytes = m_tiles.capacity() * sizeof( Tile );
+    size_t solidBytes = m_tileSolidBits.capacity() * sizeof( unsigned int );
+    size_t movementBytes = m_tileMovementModifiers.capacity() * sizeof( float );
+
+    size_t meshBytes = m_meshChunks.capacity() * sizeof( std::vector<Vertex_PCU> );
+    for( int builtIndex = 0; builtIndex < (int)m_builtMeshChunks.size(); builtIndex++ ) {
+        meshBytes += m_meshChunks[m_builtMeshChunks[builtIndex]].capacity() * sizeof( Vertex_PCU );
+    }
+
+    size_t flowFieldBytes = 0;
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        flowFieldBytes += m_playerFlowFields[playerIndex].GetMemoryBytes();
+    }
+
+    size_t pathfinderBytes = m_pathfinder.GetMemoryBytes();
+    size_t spatialHashBytes = m_spatialHash.GetMemoryBytes();
+    return tileBytes + solidBytes + movementBytes + meshBytes + flowFieldBytes + pathfinderBytes + spatialHashBytes;
+}
+
 
-    RaycastResult result = Raycast( start, direction, maxDistance );
+void Map::RaycastBatch( int numRays, const RayQuery* queries, RaycastResult* out_results ) const {
+    int numFullGroups = numRays / 4;
+
+    for( int groupIndex = 0; groupIndex < numFullGroups; groupIndex++ ) {
+        int firstRay = groupIndex * 4;
+        RaycastFourLanes( &queries[firstRay], &out_results[firstRay] );
+    }
+
+    // Leftovers that don't fill all four lanes
+    for( int rayIndex = numFullGroups * 4; rayIndex < numRays; rayIndex++ ) {
+        const RayQuery& query = queries[rayIndex];
+        out_results[rayIndex] = Raycast( query.startPosition, query.normalizedDirection, query.maxDistance );
+    }
+}
+
+
+bool Map::HasLineOfSight( const Entity* source, const Entity* destination ) const {
+    RayQuery query = MakeLineOfSightQuery( source, destination );
+    RaycastResult result = Raycast( query.startPosition, query.normalizedDirection, query.maxDistance );
 
     return !result.DidImpact();
 }
 
 
-Entity* Map::AcquireNewTarget() const {
+Entity* Map::AcquireNewTarget() {
     std::vector<PlayerTank*> potentialTargets;
 
     for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
@@ -326,12 +709,232 @@ Entity* Map::AcquireNewTarget() const {
         return nullptr;
     }
 
-    int targetIndex = g_RNG->GetRandomIntLessThan( numTargets );
+    int targetIndex = m_rng.GetRandomIntLessThan( numTargets );
     return (Entity*)potentialTargets[targetIndex];
 }
 
 
+Entity* Map::GetOrAcquireTarget( EntityHandle& targetHandle ) {
+    // Stale handles resolve to nullptr, so a destroyed target is replaced like a dead one
+    Entity* target = GetEntity( targetHandle );
+
+    if( target == nullptr || !target->IsAlive() ) {
+        target = AcquireNewTarget();
+        targetHandle = (target != nullptr) ? target->GetHandle() : EntityHandle::INVALID;
+    }
+
+    return target;
+}
+
+
+bool Map::GetFlowDirectionToward( const EntityHandle& targetHandle, const Vec2& position, Vec2& out_direction, int& out_distance ) const {
+    if( !targetHandle.IsValid() ) {
+        return false;
+    }
+
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        if( m_flowFieldTargets[playerIndex] == targetHandle ) {
+            return m_playerFlowFields[playerIndex].GetFlowDirection( position, out_direction, out_distance );
+        }
+    }
+
+    return false;
+}
+
+
+void Map::GetFlowFieldStats( int& out_numRebuilds, int& out_numRepairs ) const {
+    out_numRebuilds = 0;
+    out_numRepairs = 0;
+
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        out_numRebuilds += m_playerFlowFields[playerIndex].GetNumRebuilds();
+        out_numRepairs += m_playerFlowFields[playerIndex].GetNumRepairs();
+    }
+}
+
+
+int Map::FindPath( const IntVec2& startTileCoords, const IntVec2& goalTileCoords, IntVec2* out_waypoints, int maxWaypoints ) const {
+    if( IsTileSolid( startTileCoords.x, startTileCoords.y ) || IsTileSolid( goalTileCoords.x, goalTileCoords.y ) ) {
+        return 0; // Also off the map
+    }
+
+    int startTileIndex = GetTileIndexFromTileCoords( startTileCoords );
+    int goalTileIndex = GetTileIndexFromTileCoords( goalTileCoords );
+    return m_pathfinder.FindPath( *this, startTileIndex, goalTileIndex, out_waypoints, maxWaypoints );
+}
+
+
+void Map::RequestPath( const EntityHandle& requester, const IntVec2& startTileCoords, const IntVec2& goalTileCoords ) {
+    MapCommand command;
+    command.type = MAP_COMMAND_REQUEST_PATH;
+    command.sourceHandle = requester;
+    command.startTileIndex = GetTileIndexFromTileCoords( startTileCoords );
+    command.goalTileIndex = GetTileIndexFromTileCoords( goalTileCoords );
+
+    if( s_jobCommandBuffer != nullptr ) {
+        s_jobCommandBuffer->push_back( command );
+    } else {
+        m_pathRequests.SubmitRequest( command.sourceHandle, command.startTileIndex, command.goalTileIndex, m_numTicks );
+    }
+}
+
+
+const PathResult* Map::GetPathResult( const EntityHandle& requester ) const {
+    return m_pathRequests.GetResult( requester );
+}
+
+
+const PathRequestStats& Map::GetPathRequestStats() const {
+    return m_pathRequests.GetStats();
+}
+
+
+int Map::SubmitRaycast( const Vec2& startPosition, const Vec2& normalizedDirection, float maxDistance /*= MAP_RAYCAST_MAX_DISTANCE*/ ) {
+    RayQuery query;
+    query.startPosition = startPosition;
+    query.normalizedDirection = normalizedDirection;
+    query.maxDistance = maxDistance;
+
+    m_rayQueries.push_back( query );
+    return (int)m_rayQueries.size() - 1;
+}
+
+
+int Map::SubmitLineOfSight( const Entity* source, const Entity* destination ) {
+    m_rayQueries.push_back( MakeLineOfSightQuery( source, destination ) );
+    return (int)m_rayQueries.size() - 1;
+}
+
+
+const RaycastResult& Map::GetSubmittedRaycastResult( int rayIndex ) const {
+    // Entities spawned after this tick's batch have nothing submitted yet, report no impact
+    static const RaycastResult s_noImpact = RaycastResult();
+
+    if( rayIndex < 0 || rayIndex >= (int)m_rayResults.size() ) {
+        return s_noImpact;
+    }
+
+    return m_rayResults[rayIndex];
+}
+
+
+int Map::GetNumBatchedRaycasts() const {
+    return (int)m_rayResults.size();
+}
+
+
+void Map::QueryEntitiesInRadius( const Vec2& center, float radius, EntityList& out_entities ) const {
+    m_spatialHash.QueryEntitiesInRadius( center, radius, out_entities );
+}
+
+
+void Map::QueryEntitiesInAABB2( const AABB2& bounds, EntityList& out_entities ) const {
+    m_spatialHash.QueryEntitiesInAABB2( bounds, out_entities );
+}
+
+
+Entity* Map::GetFirstEntityHitByBullet( const Vec2& position, float radius, FactionID faction ) const {
+    return m_spatialHash.GetFirstEntityTouchingDisc( position, radius, m_collisionLayers, ENTITY_TYPE_BULLET, faction );
+}
+
+
+void Map::GetCollisionPairStats( int& out_candidatePairs, int& out_bruteForcePairs ) const {
+    out_candidatePairs = m_numCandidatePairs;
+    out_bruteForcePairs = m_numBruteForcePairs;
+}
+
+
+int Map::GetNumSkippedPairs() const {
+    return m_numSkippedPairs;
+}
+
+
+void Map::GetSleepStats( int& out_numAwake, int& out_numAsleep, int& out_numSleepingPairs ) const {
+    out_numAwake = m_numAwakeEntities;
+    out_numAsleep = m_numAsleepEntities;
+    out_numSleepingPairs = m_numSleepingPairs;
+}
+
+
+void Map::GetPoolStats( EntityType type, int& out_numInUse, int& out_highWaterMark, int& out_capacity, int& out_numExhausted ) const {
+    out_numInUse = 0;
+    out_highWaterMark = 0;
+    out_capacity = 0;
+    out_numExhausted = 0;
+
+    if( type == ENTITY_TYPE_BULLET ) {
+        out_numInUse = m_bulletPool.GetNumInUse();
+        out_highWaterMark = m_bulletPool.GetHighWaterMark();
+        out_capacity = m_bulletPool.GetCapacity();
+        out_numExhausted = m_bulletPool.GetNumExhausted();
+    }
+}
+
+
+void Map::GetExplosionParticleStats( int& out_numParticles, int& out_highWaterMark ) const {
+    out_numParticles = m_explosionParticles.GetNumParticles();
+    out_highWaterMark = m_explosionParticles.GetHighWaterMark();
+}
+
+
+void Map::GetProjectileStats( int& out_numProjectiles, int& out_highWaterMark ) const {
+    out_numProjectiles = m_projectiles.GetNumProjectiles();
+    out_highWaterMark = m_projectiles.GetHighWaterMark();
+}
+
+
+double Map::GetPhaseSeconds( MapUpdatePhase phase ) const {
+    return m_phaseSeconds[phase];
+}
+
+
+void Map::ResetPhaseTimings() {
+    for( int phaseIndex = 0; phaseIndex < NUM_MAP_PHASES; phaseIndex++ ) {
+        m_phaseSeconds[phaseIndex] = 0.0;
+    }
+}
+
+
+const char* Map::GetPhaseName( MapUpdatePhase phase ) {
+    switch( phase ) {
+        case(MAP_PHASE_CONTROLLER): {
+            return "Controller";
+        } case(MAP_PHASE_FLOW_FIELDS): {
+            return "Flow Fields";
+        } case(MAP_PHASE_RAYCASTS): {
+            return "Raycasts";
+        } case(MAP_PHASE_ENTITIES): {
+            return "Entities";
+        } case(MAP_PHASE_PATHS): {
+            return "Paths";
+        } case(MAP_PHASE_PARTICLES): {
+            return "Particles";
+        } case(MAP_PHASE_COLLISION): {
+            return "Collision";
+        } case(MAP_PHASE_PROJECTILES): {
+            return "Projectiles";
+        } case(MAP_PHASE_STRUCTURAL): {
+            return "Structural";
+        } default: {
+            return "Unknown";
+        }
+    }
+}
+
+
 void Map::SendPlayersToNewMap( Map* newMap ) {
+    MapCommand command;
+    command.type = MAP_COMMAND_TRANSFER_PLAYERS;
+    command.destinationMap = newMap;
+
+    m_arePlayersLeaving = true;
+    QueueStructuralCommand( command );
+}
+
+
+void Map::TransferPlayersNow( Map* newMap ) {
+    m_arePlayersLeaving = false;
+
     for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
         PlayerTank* player = GetPlayer( playerIndex );
         if( player != nullptr ) {
@@ -352,62 +955,287 @@ void Map::SendPlayersToNewMap( Map* newMap ) {
 }
 
 
-void Map::AddEntityToMap( Entity& entity ) {
-    // Everyone added to full entity list
-    AddEntityToList( entity, m_entities );
+void Map::SetSeed( unsigned int seed ) {
+    m_seed = seed;
+    m_rng.SetSeed( seed );
+    m_rng.SetPosition( 0 );
+}
 
-    EntityType type = entity.GetEntityType();
 
-    // Explosions in their own list, everyone else in the list by type
-    if( type == ENTITY_TYPE_EXPLOSION ) {
-        AddEntityToList( entity, m_explosions );
-    } else {
-        AddEntityToList( entity, m_entitiesByType[type] );
+void Map::SetStateHashingEnabled( bool isEnabled ) {
+    m_isStateHashingEnabled = isEnabled;
+}
+
+
+void Map::SetBulletProjectilesEnabled( bool isEnabled ) {
+    m_areBulletsProjectiles = isEnabled;
+}
+
+
+unsigned int Map::GetSeed() const {
+    return m_seed;
+}
+
+
+unsigned int Map::ComputeStateHash() const {
+    StateHash hash;
+    hash.AddInt( m_numTicks );
+    hash.AddUint( m_rng.GetPosition() );
+    hash.AddBytes( m_tiles.data(), m_tiles.size() * sizeof( Tile ) );
+
+    // Registry order only depends on the order of spawns and removals, never on addresses
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    int numEntities = (int)entities.size();
+    hash.AddInt( numEntities );
+
+    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
+        entities[entityIndex]->AddToStateHash( hash );
     }
+
+    if( m_areBulletsProjectiles ) {
+        m_projectiles.AddToStateHash( hash );
+    }
+
+    m_pathRequests.AddToStateHash( hash );
+    return hash.GetHash();
+}
+
+
+unsigned int Map::GetRollingStateHash() const {
+    return m_rollingStateHash;
 }
 
 
-void Map::AddEntityToList( Entity& entity, EntityList& list ) {
-    int numEntities = (int)list.size();
+int Map::GetNumTicks() const {
+    return m_numTicks;
+}
+
+
+void Map::SaveSnapshot( ByteBuffer& out_buffer ) const {
+    out_buffer.clear();
+    BufferWriter writer( out_buffer );
+
+    writer.WriteUint32( MAP_SNAPSHOT_MAGIC );
+    writer.WriteUint16( MAP_SNAPSHOT_VERSION );
+    writer.WriteInt32( m_mapDimensions.x );
+    writer.WriteInt32( m_mapDimensions.y );
+    writer.WriteBool( m_arenaMode );
+    writer.WriteUint32( m_seed );
+    writer.WriteUint32( m_rng.GetPosition() );
+    writer.WriteInt32( m_numTicks );
+    writer.WriteUint32( m_rollingStateHash );
+
+    static_assert( sizeof( Tile ) == 1, "Snapshot writes tiles as one byte each" );
+    writer.WriteBytes( m_tiles.data(), m_tiles.size() );
+
+    // Registry layout first, then each entity's data in its dense order
+    m_entityRegistry.WriteSnapshot( writer );
+
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    int numEntities = (int)entities.size();
 
     for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
-        if( list[entityIndex] == nullptr ) {
-            list[entityIndex] = &entity;
-            return;
+        const Entity* entity = entities[entityIndex];
+        EntityType type = entity->GetEntityType();
+        writer.WriteUint8( (unsigned char)type );
+
+        if( type == ENTITY_TYPE_PLAYERTANK ) {
+            writer.WriteUint8( (unsigned char)((const PlayerTank*)entity)->GetPlayerID() );
         }
+
+        // Handles go in as index and generation, the registry snapshot keeps them valid after a restore
+        writer.WriteInt32( entity->m_handle.index );
+        writer.WriteUint32( entity->m_handle.generation );
+
+        size_t entityStart = writer.GetNumBytesWritten();
+        entity->WriteSnapshot( writer );
+        ASSERT_OR_DIE( writer.GetNumBytesWritten() - entityStart == (size_t)GetEntitySnapshotNumBytes( type ), "Entity snapshot size doesn't match its type's GetSnapshotNumBytes" );
     }
 
-    list.push_back( &entity );
+    m_explosionParticles.WriteSnapshot( writer );
+    m_projectiles.WriteSnapshot( writer );
+    m_pathRequests.WriteSnapshot( writer );
 }
 
 
-void Map::RemoveEntityFromMap( Entity& entity ) {
-    RemoveEntityFromList( entity, m_entities );
+bool Map::RestoreSnapshot( const ByteBuffer& buffer ) {
+    // Nothing changes until the whole snapshot has been read once, so a bad one leaves the map as it was
+    if( !CheckSnapshot( buffer ) ) {
+        return false;
+    }
+
+    BufferReader reader( buffer );
+    reader.SkipBytes( MAP_SNAPSHOT_HEADER_NUM_BYTES );
+
+    unsigned int seed = reader.ReadUint32();
+    unsigned int rngPosition = reader.ReadUint32();
+    m_numTicks = reader.ReadInt32();
+    m_rollingStateHash = reader.ReadUint32();
+    SetSeed( seed );
+    m_rng.SetPosition( rngPosition );
+
+    // Only changed tiles are written, so a rewind on the same map barely touches the tile data
+    // Unlike SetTileType, the pathfinder, path cache and flow fields are rebuilt once after all of them
+    int numTiles = (int)m_tiles.size();
+    int numChangedTiles = 0;
+
+    for( int tileIndex = 0; tileIndex < numTiles; tileIndex++ ) {
+        TileType type = (TileType)(signed char)reader.ReadUint8();
+
+        if( type != m_tiles[tileIndex].GetTileType() ) {
+            m_tiles[tileIndex].SetTileType( type );
+            UpdateTileProperties( tileIndex );
+            numChangedTiles++;
+            UpdateTileVerts( tileIndex );
+        }
+    }
+
+    if( numChangedTiles > 0 ) {
+        m_pathfinder.OnTilesChanged( *this );
+        m_pathRequests.OnTileChanged();
+
+        for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+            m_playerFlowFields[playerIndex].OnTilesChanged( *this );
+        }
+    }
+
+    // Current entities become spares, a rewind mostly refills the same objects without allocating or restarting them
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    int numOldEntities = (int)entities.size();
+
+    for( int entityIndex = 0; entityIndex < numOldEntities; entityIndex++ ) {
+        Entity* entity = entities[entityIndex];
+        entity->m_handle = EntityHandle::INVALID;
+        m_snapshotSpares[entity->GetEntityType()].push_back( entity );
+    }
+
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        m_players[playerIndex] = nullptr;
+    }
+
+    bool isRestored = m_entityRegistry.ReadSnapshot( reader );
+    int numEntities = m_entityRegistry.GetNumEntities();
+
+    for( int entityIndex = 0; isRestored && entityIndex < numEntities; entityIndex++ ) {
+        isRestored = RestoreSnapshotEntity( reader );
+    }
+
+    m_explosionParticles.ReadSnapshot( reader );
+    m_projectiles.ReadSnapshot( reader );
+    m_pathRequests.ReadSnapshot( reader );
+
+    for( int typeIndex = 0; typeIndex < NUM_ENTITY_TYPES; typeIndex++ ) {
+        EntityList& spares = m_snapshotSpares[typeIndex];
+        for( int spareIndex = 0; spareIndex < (int)spares.size(); spareIndex++ ) {
+            ReleaseEntity( *spares[spareIndex] );
+        }
+
+        spares.clear();
+    }
+
+    GUARANTEE_OR_DIE( isRestored && !reader.HasOverrun(), "Map snapshot passed CheckSnapshot but didn't restore" );
+    return true;
+}
+
+
+bool Map::CheckSnapshot( const ByteBuffer& buffer ) {
+    BufferReader reader( buffer );
+
+    unsigned int magic = reader.ReadUint32();
+    unsigned short version = reader.ReadUint16();
+    IntVec2 dimensions;
+    dimensions.x = reader.ReadInt32();
+    dimensions.y = reader.ReadInt32();
+    bool arenaMode = reader.ReadBool();
+
+    if( magic != MAP_SNAPSHOT_MAGIC || version != MAP_SNAPSHOT_VERSION ) {
+        ERROR_RECOVERABLE( Stringf( "Map snapshot has an unknown format (version %d, expected %d)", version, MAP_SNAPSHOT_VERSION ) );
+        return false;
+    }
+
+    if( dimensions != m_mapDimensions || arenaMode != m_arenaMode ) {
+        ERROR_RECOVERABLE( Stringf( "Map snapshot is from a different map (%dx%d)", dimensions.x, dimensions.y ) );
+        return false;
+    }
+
+    reader.SkipBytes( 4 * sizeof( unsigned int ) ); // Seed, RNG position, tick count and rolling hash, any value will do
+
+    int numTiles = (int)m_tiles.size();
+    if( !reader.CanRead( numTiles, sizeof( Tile ) ) ) {
+        ERROR_RECOVERABLE( "Map snapshot is corrupt, it ends before its tiles" );
+        return false;
+    }
+
+    const unsigned char* tileTypes = buffer.data() + reader.GetReadOffset();
+
+    for( int tileIndex = 0; tileIndex < numTiles; tileIndex++ ) {
+        TileType type = (TileType)(signed char)tileTypes[tileIndex];
+
+        if( type < 0 || type >= NUM_TILE_TYPES ) {
+            ERROR_RECOVERABLE( Stringf( "Map snapshot is corrupt, tile %d has type %d", tileIndex, (int)type ) );
+            return false;
+        }
+    }
+
+    reader.SkipBytes( numTiles * sizeof( Tile ) );
+
+    // Entity data is a fixed size per type, so only each entity's header needs reading to check it against the layout
+    bool isValid = m_snapshotLayout.ReadSnapshot( reader );
+    int numEntities = m_snapshotLayout.GetNumEntities();
+    bool isPlayerSaved[MAX_CONTROLLERS] = {};
+
+    for( int entityIndex = 0; isValid && entityIndex < numEntities; entityIndex++ ) {
+        EntityType type = (EntityType)reader.ReadUint8();
+        int playerID = (type == ENTITY_TYPE_PLAYERTANK) ? (int)reader.ReadUint8() : -1;
+
+        EntityHandle handle;
+        handle.index = reader.ReadInt32();
+        handle.generation = reader.ReadUint32();
+
+        isValid = m_snapshotLayout.CanRestoreEntity( entityIndex, handle, type );
+
+        if( isValid && type == ENTITY_TYPE_PLAYERTANK ) {
+            isValid = (playerID < MAX_CONTROLLERS) && !isPlayerSaved[playerID]; // One tank per controller
+        }
+
+        if( isValid ) {
+            if( type == ENTITY_TYPE_PLAYERTANK ) {
+                isPlayerSaved[playerID] = true;
+            }
+
+            reader.SkipBytes( GetEntitySnapshotNumBytes( type ) );
+        }
+    }
+
+    isValid = isValid && ParticleSystem::SkipSnapshot( reader ) && ProjectileSystem::SkipSnapshot( reader ) && PathRequestService::SkipSnapshot( reader, m_snapshotLayout.GetNumSlots() ) && !reader.HasOverrun();
+
+    if( !isValid ) {
+        ERROR_RECOVERABLE( "Map snapshot is corrupt, the map was left as it was" );
+    }
+
+    return isValid;
+}
 
-    EntityType type = entity.GetEntityType();
 
-    if( type == ENTITY_TYPE_EXPLOSION ) {
-        RemoveEntityFromList( entity, m_explosions );
-    } else {
-        RemoveEntityFromList( entity, m_entitiesByType[type] );
-    }
+void Map::AddEntityToMap( Entity& entity ) {
+    entity.m_handle = m_entityRegistry.AddEntity( &entity );
+    entity.ClearPreviousTransform();
 
-    if( type == ENTITY_TYPE_PLAYERTANK ) {
+    // Players also keep a fixed slot by controller
+    if( entity.GetEntityType() == ENTITY_TYPE_PLAYERTANK ) {
         PlayerTank* player = (PlayerTank*)&entity;
-        int playerID = player->GetPlayerID();
-        m_entitiesByType[ENTITY_TYPE_PLAYERTANK][playerID] = nullptr;
+        m_players[player->GetPlayerID()] = player;
     }
 }
 
 
-void Map::RemoveEntityFromList( Entity& entity, EntityList& list ) {
-    int numEntities = (int)list.size();
+void Map::RemoveEntityFromMap( Entity& entity ) {
+    m_entityRegistry.RemoveEntity( entity.m_handle );
+    entity.m_handle = EntityHandle::INVALID;
 
-    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
-        if( list[entityIndex] == &entity ) {
-            list[entityIndex] = nullptr;
-            return;
-        }
+    if( entity.GetEntityType() == ENTITY_TYPE_PLAYERTANK ) {
+        PlayerTank* player = (PlayerTank*)&entity;
+        m_players[player->GetPlayerID()] = nullptr;
     }
 }
 
@@ -425,16 +1253,27 @@ void Map::PushEntitiesOutOfEachOther( Entity* entity1, Entity* entity2 ) {
 
 void Map::StartupMakeAllGroundTiles() {
     int numTiles = m_mapDimensions.x * m_mapDimensions.y;
-    int tileCoordsX;
-    int tileCoordsY;
 
     // Make the entire map Grass Tiles
-    for( int i = 0; i < numTiles; i++ ) {
-        m_tiles.push_back( Tile( m_groundType ) );
-        tileCoordsX = i % m_mapDimensions.x;
-        tileCoordsY = i / m_mapDimensions.x;
-        m_tiles[i].SetIndexAndCoords( i, IntVec2( tileCoordsX, tileCoordsY ) );
-    }
+    m_tiles.assign( numTiles, Tile( m_groundType ) );
+
+    const TileDef& groundDef = TileDef::GetTileDef( m_groundType );
+    int numSolidWords = (numTiles + 31) / 32;
+    m_tileSolidBits.assign( numSolidWords, groundDef.IsSolid() ? 0xFFFFFFFFu : 0u );
+    m_tileMovementModifiers.assign( numTiles, groundDef.GetMovementModifier() );
+}
+
+
+void Map::UpdateTileProperties( int tileIndex ) {
+    // Only place TileDefs are read after startup, everything else uses the flat arrays
+    TileType type = m_tiles[tileIndex].GetTileType();
+    const TileDef& tileDef = TileDef::GetTileDef( type );
+
+    unsigned int solidBit = 1u << (tileIndex & 31);
+    unsigned int& solidWord = m_tileSolidBits[tileIndex >> 5];
+    solidWord = tileDef.IsSolid() ? (solidWord | solidBit) : (solidWord & ~solidBit);
+
+    m_tileMovementModifiers[tileIndex] = tileDef.GetMovementModifier();
 }
 
 
@@ -445,22 +1284,22 @@ void Map::StartupAddWallBorder() {
     for( int x = 0; x < m_mapDimensions.x; x++ ) {
         // Bottom Row
         tileIndex = x;
-        m_tiles[tileIndex].SetTileType( m_wallType );
+        SetTileType( tileIndex, m_wallType );
 
         // Top Row
         tileIndex = (m_mapDimensions.y - 1) * m_mapDimensions.x + x;
-        m_tiles[tileIndex].SetTileType( m_wallType );
+        SetTileType( tileIndex, m_wallType );
     }
 
     // Make left and right Stone Tiles
     for( int y = 0; y < m_mapDimensions.y; y++ ) {
         // Left Column
         tileIndex = m_mapDimensions.x * y;
-        m_tiles[tileIndex].SetTileType( m_wallType );
+        SetTileType( tileIndex, m_wallType );
 
         // Right Column
         tileIndex = (m_mapDimensions.x * y) + (m_mapDimensions.x - 1);
-        m_tiles[tileIndex].SetTileType( m_wallType );
+        SetTileType( tileIndex, m_wallType );
     }
 }
 
@@ -473,10 +1312,10 @@ void Map::StartupAddRandomTiles( TileType type, float fraction ) {
 
     for( int i = 0; i < numTiles * fraction; i++ ) {
         // Only pick tiles on the interior of the border
-        tileCoordX = g_RNG->GetRandomIntInRange( 1, m_mapDimensions.x - 2 );
-        tileCoordY = g_RNG->GetRandomIntInRange( 1, m_mapDimensions.y - 2 );
+        tileCoordX = m_rng.GetRandomIntInRange( 1, m_mapDimensions.x - 2 );
+        tileCoordY = m_rng.GetRandomIntInRange( 1, m_mapDimensions.y - 2 );
         tileIndex = GetTileIndexFromTileCoords( tileCoordX, tileCoordY );
-        m_tiles[tileIndex].SetTileType( type );
+        SetTileType( tileIndex, type );
     }
 }
 
@@ -504,14 +1343,14 @@ void Map::StartupAddSafeBunkers() {
     for( int xIndex = xMinLeft; xIndex <= xMaxLeft; xIndex++ ) {
         for( int yIndex = yMinBot; yIndex <= yMaxBot; yIndex++ ) {
             tileIndex = GetTileIndexFromTileCoords( xIndex, yIndex );
-            m_tiles[tileIndex].SetTileType( type );
+            SetTileType( tileIndex, type );
         }
     }
 
     for( int xIndex = xMinRight; xIndex <= xMaxRight; xIndex++ ) {
         for( int yIndex = yMinTop; yIndex <= yMaxTop; yIndex++ ) {
             tileIndex = GetTileIndexFromTileCoords( xIndex, yIndex );
-            m_tiles[tileIndex].SetTileType( TILE_TYPE_MUD );
+            SetTileType( tileIndex, TILE_TYPE_MUD );
         }
     }
 
@@ -520,7 +1359,7 @@ void Map::StartupAddSafeBunkers() {
         for( int xIndex = xMinLeft; xIndex <= xMaxLeft; xIndex++ ) {
             for( int yIndex = yMinTop; yIndex <= yMaxTop; yIndex++ ) {
                 tileIndex = GetTileIndexFromTileCoords( xIndex, yIndex );
-                m_tiles[tileIndex].SetTileType( TILE_TYPE_MUD );
+                SetTileType( tileIndex, TILE_TYPE_MUD );
             }
         }
 
@@ -528,7 +1367,7 @@ void Map::StartupAddSafeBunkers() {
         for( int xIndex = xMinRight; xIndex <= xMaxRight; xIndex++ ) {
             for( int yIndex = yMinBot; yIndex <= yMaxBot; yIndex++ ) {
                 tileIndex = GetTileIndexFromTileCoords( xIndex, yIndex );
-                m_tiles[tileIndex].SetTileType( TILE_TYPE_MUD );
+                SetTileType( tileIndex, TILE_TYPE_MUD );
             }
         }
 
@@ -536,7 +1375,7 @@ void Map::StartupAddSafeBunkers() {
         for( int xIndex = xCenter - 4; xIndex <= xCenter + 4; xIndex++ ) {
             for( int yIndex = yCenter - 4; yIndex <= yCenter + 4; yIndex++ ) {
                 tileIndex = GetTileIndexFromTileCoords( xIndex, yIndex );
-                m_tiles[tileIndex].SetTileType( TILE_TYPE_MUD );
+                SetTileType( tileIndex, TILE_TYPE_MUD );
             }
         }
     }
@@ -561,7 +1400,7 @@ void Map::StartupAddSafeBunkers() {
 
     for( IntVec2 tileCoords : bunkerCoords ) {
         tileIndex = GetTileIndexFromTileCoords( tileCoords );
-        m_tiles[tileIndex].SetTileType( m_wallType );
+        SetTileType( tileIndex, m_wallType );
     }
 
     if( m_arenaMode ) {
@@ -619,7 +1458,7 @@ void Map::StartupAddSafeBunkers() {
 
         for( IntVec2 tileCoords : arenaBunkerCoords ) {
             tileIndex = GetTileIndexFromTileCoords( tileCoords );
-            m_tiles[tileIndex].SetTileType( m_wallType );
+            SetTileType( tileIndex, m_wallType );
         }
     }
 
@@ -628,7 +1467,7 @@ void Map::StartupAddSafeBunkers() {
     } else {
         tileIndex = GetTileIndexFromTileCoords( xMaxRight, yMaxTop );
     }
-    m_tiles[tileIndex].SetTileType( TILE_TYPE_EXIT );
+    SetTileType( tileIndex, TILE_TYPE_EXIT );
 }
 
 
@@ -636,29 +1475,98 @@ void Map::StartupAddEntities( EntityType type, int numEntities ) {
     for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
         int xPos;
         int yPos;
-        const Tile* tile;
 
         do { // Repeat until we get a tile that's NOT solid
-            xPos = g_RNG->GetRandomIntLessThan( m_mapDimensions.x );
-            yPos = g_RNG->GetRandomIntLessThan( m_mapDimensions.y );
-
-            tile = &GetTileFromTileCoords( xPos, yPos );
-        } while( tile->IsSolid() );
+            xPos = m_rng.GetRandomIntLessThan( m_mapDimensions.x );
+            yPos = m_rng.GetRandomIntLessThan( m_mapDimensions.y );
+        } while( IsTileSolid( xPos, yPos ) );
 
         Vec2 entityPos( (float)xPos + 0.5f, (float)yPos + 0.5f );
-        float orientationDegrees = g_RNG->GetRandomFloatInRange( 0.f, 360.f );
+        float orientationDegrees = m_rng.GetRandomFloatInRange( 0.f, 360.f );
         SpawnNewEntity( type, entityPos, orientationDegrees );
     }
 }
 
 
-std::vector<Vertex_PCU> Map::BuildMapVerts() const {
-    std::vector<Vertex_PCU> mapVerts;
-    // Tile Verts
-    for( int i = 0; i < (int)m_tiles.size(); i++ ) {
-        Tile tile = m_tiles[i];
-        mapVerts.insert( mapVerts.end(), tile.m_tileVerts.begin(), tile.m_tileVerts.end() );
+const IntVec2 Map::GetNumMeshChunks() const {
+    int numChunksX = (m_mapDimensions.x + MAP_MESH_CHUNK_SIZE - 1) / MAP_MESH_CHUNK_SIZE;
+    int numChunksY = (m_mapDimensions.y + MAP_MESH_CHUNK_SIZE - 1) / MAP_MESH_CHUNK_SIZE;
+    return IntVec2( numChunksX, numChunksY );
+}
+
+
+const IntVec2 Map::GetMeshChunkTileMins( int chunkIndex ) const {
+    int numChunksX = GetNumMeshChunks().x;
+    return IntVec2( (chunkIndex % numChunksX) * MAP_MESH_CHUNK_SIZE, (chunkIndex / numChunksX) * MAP_MESH_CHUNK_SIZE );
+}
+
+
+const IntVec2 Map::GetMeshChunkTileDimensions( int chunkIndex ) const {
+    // Chunks on the top and right edges are cut short by the map
+    IntVec2 tileMins = GetMeshChunkTileMins( chunkIndex );
+    int chunkWidth = ClampInt( m_mapDimensions.x - tileMins.x, 0, MAP_MESH_CHUNK_SIZE );
+    int chunkHeight = ClampInt( m_mapDimensions.y - tileMins.y, 0, MAP_MESH_CHUNK_SIZE );
+    return IntVec2( chunkWidth, chunkHeight );
+}
+
+
+void Map::RenderMeshChunks( const AABB2& viewBounds ) const {
+    IntVec2 numChunks = GetNumMeshChunks();
+    int minChunkX = ClampInt( (int)floorf( viewBounds.mins.x / (float)MAP_MESH_CHUNK_SIZE ), 0, numChunks.x - 1 );
+    int minChunkY = ClampInt( (int)floorf( viewBounds.mins.y / (float)MAP_MESH_CHUNK_SIZE ), 0, numChunks.y - 1 );
+    int maxChunkX = ClampInt( (int)floorf( viewBounds.maxs.x / (float)MAP_MESH_CHUNK_SIZE ), 0, numChunks.x - 1 );
+    int maxChunkY = ClampInt( (int)floorf( viewBounds.maxs.y / (float)MAP_MESH_CHUNK_SIZE ), 0, numChunks.y - 1 );
+
+    // Chunks more than one chunk out of view are freed, so the camera can wander without rebuilding at every edge
+    for( int builtIndex = 0; builtIndex < (int)m_builtMeshChunks.size(); ) {
+        int chunkIndex = m_builtMeshChunks[builtIndex];
+        int chunkX = chunkIndex % numChunks.x;
+        int chunkY = chunkIndex / numChunks.x;
+
+        if( chunkX < minChunkX - 1 || chunkX > maxChunkX + 1 || chunkY < minChunkY - 1 || chunkY > maxChunkY + 1 ) {
+            std::vector<Vertex_PCU>().swap( m_meshChunks[chunkIndex] );
+            m_builtMeshChunks[builtIndex] = m_builtMeshChunks.back();
+            m_builtMeshChunks.pop_back();
+        } else {
+            builtIndex++;
+        }
+    }
+
+    const SpriteSheet& terrainSprites = TileDef::GetSpriteSheet();
+    const Texture* terrainTexture = terrainSprites.GetTexture();
+    g_theRenderer->BindTexture( terrainTexture );
+
+    for( int chunkY = minChunkY; chunkY <= maxChunkY; chunkY++ ) {
+        for( int chunkX = minChunkX; chunkX <= maxChunkX; chunkX++ ) {
+            int chunkIndex = (chunkY * numChunks.x) + chunkX;
+            std::vector<Vertex_PCU>& chunkVerts = m_meshChunks[chunkIndex];
+
+            if( chunkVerts.empty() ) {
+                BuildMeshChunk( chunkIndex );
+            }
+
+            g_theRenderer->DrawVertexArray( (int)chunkVerts.size(), chunkVerts.data() );
+        }
+    }
+}
+
+
+void Map::BuildMeshChunk( int chunkIndex ) const {
+    IntVec2 tileMins = GetMeshChunkTileMins( chunkIndex );
+    IntVec2 chunkDimensions = GetMeshChunkTileDimensions( chunkIndex );
+    std::vector<Vertex_PCU>& chunkVerts = m_meshChunks[chunkIndex];
+    chunkVerts.resize( chunkDimensions.x * chunkDimensions.y * 6 );
+
+    // Row by row within the chunk, UpdateTileVerts finds tiles the same way
+    for( int localY = 0; localY < chunkDimensions.y; localY++ ) {
+        for( int localX = 0; localX < chunkDimensions.x; localX++ ) {
+            int tileIndex = GetTileIndexFromTileCoords( tileMins.x + localX, tileMins.y + localY );
+            int localIndex = (localY * chunkDimensions.x) + localX;
+            WriteTileVerts( tileIndex, &chunkVerts[localIndex * 6] );
+        }
     }
+
+    m_builtMeshChunks.push_back( chunkIndex );
 /*
     // Vertical Grid Lines
     for( int i = 1; i < m_mapDimensions.x; i++ ) {
@@ -670,7 +1578,226 @@ std::vector<Vertex_PCU> Map::BuildMapVerts() const {
         AddVertsForLine2D( mapVerts, Vec2( 0.f, (float)i ), Vec2( (float)m_mapDimensions.x, (float)i ), .05f, Rgba::BLACK );
     }
 */
-    return mapVerts;
+}
+
+
+void Map::UpdateTileVerts( int tileIndex ) {
+    if( m_meshChunks.empty() ) { // Startup changes tiles before the chunks exist
+        return;
+    }
+
+    IntVec2 tileCoords = GetTileCoordsFromTileIndex( tileIndex );
+    int chunkX = tileCoords.x / MAP_MESH_CHUNK_SIZE;
+    int chunkY = tileCoords.y / MAP_MESH_CHUNK_SIZE;
+    int chunkIndex = (chunkY * GetNumMeshChunks().x) + chunkX;
+    std::vector<Vertex_PCU>& chunkVerts = m_meshChunks[chunkIndex];
+
+    if( chunkVerts.empty() ) { // Out of view, built with the new type when it comes back
+        return;
+    }
+
+    IntVec2 tileMins = GetMeshChunkTileMins( chunkIndex );
+    int chunkWidth = GetMeshChunkTileDimensions( chunkIndex ).x;
+    int localIndex = ((tileCoords.y - tileMins.y) * chunkWidth) + (tileCoords.x - tileMins.x);
+    WriteTileVerts( tileIndex, &chunkVerts[localIndex * 6] );
+}
+
+
+void Map::WriteTileVerts( int tileIndex, Vertex_PCU* out_verts ) const {
+    const TileDef& tileDef = TileDef::GetTileDef( m_tiles[tileIndex].GetTileType() );
+    const Rgba& tint = tileDef.GetTint();
+    AABB2 bounds = GetTileBounds( tileIndex );
+
+    Vec2 uvMins;
+    Vec2 uvMaxs;
+    tileDef.GetUVs( uvMins, uvMaxs );
+    Vec2 uvTL = Vec2( uvMins.x, uvMaxs.y );
+    Vec2 uvBR = Vec2( uvMaxs.x, uvMins.y );
+
+    // Same layout as AddVertsForAABB2D, written in place
+    out_verts[0] = Vertex_PCU( Vec3( bounds.mins.x, bounds.mins.y, 0.f ), tint, uvMins );
+    out_verts[1] = Vertex_PCU( Vec3( bounds.mins.x, bounds.maxs.y, 0.f ), tint, uvTL );
+    out_verts[2] = Vertex_PCU( Vec3( bounds.maxs.x, bounds.mins.y, 0.f ), tint, uvBR );
+
+    out_verts[3] = Vertex_PCU( Vec3( bounds.mins.x, bounds.maxs.y, 0.f ), tint, uvTL );
+    out_verts[4] = Vertex_PCU( Vec3( bounds.maxs.x, bounds.mins.y, 0.f ), tint, uvBR );
+    out_verts[5] = Vertex_PCU( Vec3( bounds.maxs.x, bounds.maxs.y, 0.f ), tint, uvMaxs );
+}
+
+
+const RayQuery Map::MakeLineOfSightQuery( const Entity* source, const Entity* destination ) const {
+    RayQuery query;
+    query.startPosition = source->GetPosition();
+
+    Vec2 direction = destination->GetPosition() - query.startPosition;
+    query.maxDistance = direction.NormalizeGetPreviousLength();
+    query.normalizedDirection = direction;
+
+    return query;
+}
+
+
+void Map::RaycastFourLanes( const RayQuery* queries, RaycastResult* out_results ) const {
+    // Same traversal as Raycast, four rays at a time in SSE lanes
+    // Lanes that finish early keep stepping but are masked out, so the loop has no per-lane branches
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps( 1.f );
+    const __m128 maxFloat = _mm_set1_ps( FLT_MAX );
+    const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+    const __m128i zeroInt = _mm_setzero_si128();
+    const __m128i oneInt = _mm_set1_epi32( 1 );
+    const __m128i allBits = _mm_set1_epi32( -1 );
+    const __m128i mapWidth = _mm_set1_epi32( m_mapDimensions.x );
+    const __m128i mapHeight = _mm_set1_epi32( m_mapDimensions.y );
+    const unsigned int* solidBits = m_tileSolidBits.data();
+
+    // RayQuery starts with four floats, load one query per register and transpose
+    __m128 startX = _mm_loadu_ps( &queries[0].startPosition.x );
+    __m128 startY = _mm_loadu_ps( &queries[1].startPosition.x );
+    __m128 directionX = _mm_loadu_ps( &queries[2].startPosition.x );
+    __m128 directionY = _mm_loadu_ps( &queries[3].startPosition.x );
+    _MM_TRANSPOSE4_PS( startX, startY, directionX, directionY );
+    __m128 maxDistance = _mm_setr_ps( queries[0].maxDistance, queries[1].maxDistance, queries[2].maxDistance, queries[3].maxDistance );
+
+    // floorf: truncate, then step down where truncating rounded up
+    __m128i tileX = _mm_cvttps_epi32( startX );
+    __m128i tileY = _mm_cvttps_epi32( startY );
+    tileX = _mm_add_epi32( tileX, _mm_castps_si128( _mm_cmpgt_ps( _mm_cvtepi32_ps( tileX ), startX ) ) );
+    tileY = _mm_add_epi32( tileY, _mm_castps_si128( _mm_cmpgt_ps( _mm_cvtepi32_ps( tileY ), startY ) ) );
+
+    __m128 isNegativeX = _mm_cmplt_ps( directionX, zero );
+    __m128 isNegativeY = _mm_cmplt_ps( directionY, zero );
+    __m128 isZeroX = _mm_cmpeq_ps( directionX, zero );
+    __m128 isZeroY = _mm_cmpeq_ps( directionY, zero );
+
+    __m128i stepX = _mm_or_si128( _mm_castps_si128( isNegativeX ), oneInt );
+    __m128i stepY = _mm_or_si128( _mm_castps_si128( isNegativeY ), oneInt );
+    __m128i stepIndexY = SelectInt4( _mm_castps_si128( isNegativeY ), _mm_sub_epi32( zeroInt, mapWidth ), mapWidth );
+
+    __m128 deltaDistX = SelectFloat4( isZeroX, maxFloat, _mm_and_ps( _mm_div_ps( one, directionX ), absMask ) );
+    __m128 deltaDistY = SelectFloat4( isZeroY, maxFloat, _mm_and_ps( _mm_div_ps( one, directionY ), absMask ) );
+
+    __m128 tileMinX = _mm_cvtepi32_ps( tileX );
+    __m128 tileMinY = _mm_cvtepi32_ps( tileY );
+    __m128 tileMaxX = _mm_cvtepi32_ps( _mm_add_epi32( tileX, oneInt ) );
+    __m128 tileMaxY = _mm_cvtepi32_ps( _mm_add_epi32( tileY, oneInt ) );
+    __m128 edgeOffsetX = SelectFloat4( isNegativeX, _mm_sub_ps( startX, tileMinX ), _mm_sub_ps( tileMaxX, startX ) );
+    __m128 edgeOffsetY = SelectFloat4( isNegativeY, _mm_sub_ps( startY, tileMinY ), _mm_sub_ps( tileMaxY, startY ) );
+    __m128 nextDistX = SelectFloat4( isZeroX, maxFloat, _mm_mul_ps( edgeOffsetX, deltaDistX ) );
+    __m128 nextDistY = SelectFloat4( isZeroY, maxFloat, _mm_mul_ps( edgeOffsetY, deltaDistY ) );
+
+    // tileY * width, SSE2 only multiplies even lanes so do evens and odds separately then interleave
+    __m128i rowStartEven = _mm_mul_epu32( tileY, mapWidth );
+    __m128i rowStartOdd = _mm_mul_epu32( _mm_srli_si128( tileY, 4 ), mapWidth );
+    __m128i rowStart = _mm_unpacklo_epi32( _mm_shuffle_epi32( rowStartEven, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( rowStartOdd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+    __m128i tileIndex = _mm_add_epi32( rowStart, tileX );
+
+    __m128i isActive = allBits;
+    __m128i didImpact = zeroInt;
+    __m128i startedInWall = zeroInt;
+    __m128 distance = zero;
+    __m128 steppedOnX = zero;
+
+    __m128 impactDistance = zero;
+    __m128i impactTileX = zeroInt;
+    __m128i impactTileY = zeroInt;
+    __m128i impactNormalX = zeroInt;
+    __m128i impactNormalY = zeroInt;
+    bool isStartTile = true;
+
+    while( true ) {
+        // Everything past the edge of the map counts as wall
+        __m128i isInBoundsX = _mm_and_si128( _mm_cmpgt_epi32( tileX, allBits ), _mm_cmplt_epi32( tileX, mapWidth ) );
+        __m128i isInBoundsY = _mm_and_si128( _mm_cmpgt_epi32( tileY, allBits ), _mm_cmplt_epi32( tileY, mapHeight ) );
+        __m128i isInBounds = _mm_and_si128( isInBoundsX, isInBoundsY );
+        __m128i safeIndex = _mm_and_si128( tileIndex, isInBounds );
+
+        // No gather or per-lane shifts in SSE2, pull the four solid bits out individually
+        int index0 = _mm_cvtsi128_si32( safeIndex );
+        int index1 = _mm_cvtsi128_si32( _mm_shuffle_epi32( safeIndex, _MM_SHUFFLE( 1, 1, 1, 1 ) ) );
+        int index2 = _mm_cvtsi128_si32( _mm_shuffle_epi32( safeIndex, _MM_SHUFFLE( 2, 2, 2, 2 ) ) );
+        int index3 = _mm_cvtsi128_si32( _mm_shuffle_epi32( safeIndex, _MM_SHUFFLE( 3, 3, 3, 3 ) ) );
+        __m128i solidity = _mm_setr_epi32(
+            (solidBits[index0 >> 5] >> (index0 & 31)) & 1,
+            (solidBits[index1 >> 5] >> (index1 & 31)) & 1,
+            (solidBits[index2 >> 5] >> (index2 & 31)) & 1,
+            (solidBits[index3 >> 5] >> (index3 & 31)) & 1
+        );
+
+        __m128i isSolid = _mm_or_si128( _mm_cmpgt_epi32( solidity, zeroInt ), _mm_xor_si128( isInBounds, allBits ) );
+        __m128i isNewImpact = _mm_and_si128( isSolid, isActive );
+        __m128i steppedOnXInt = _mm_castps_si128( steppedOnX );
+
+        if( isStartTile ) {
+            startedInWall = isNewImpact;
+            isStartTile = false;
+        }
+
+        impactDistance = SelectFloat4( _mm_castsi128_ps( isNewImpact ), distance, impactDistance );
+        impactTileX = SelectInt4( isNewImpact, tileX, impactTileX );
+        impactTileY = SelectInt4( isNewImpact, tileY, impactTileY );
+        impactNormalX = SelectInt4( isNewImpact, _mm_and_si128( steppedOnXInt, stepX ), impactNormalX );
+        impactNormalY = SelectInt4( isNewImpact, _mm_andnot_si128( steppedOnXInt, stepY ), impactNormalY );
+        didImpact = _mm_or_si128( didImpact, isNewImpact );
+        isActive = _mm_andnot_si128( isNewImpact, isActive );
+
+        // Each lane steps whichever axis reaches its next tile edge first
+        steppedOnX = _mm_cmplt_ps( nextDistX, nextDistY );
+        steppedOnXInt = _mm_castps_si128( steppedOnX );
+        distance = SelectFloat4( steppedOnX, nextDistX, nextDistY );
+
+        __m128i moveX = _mm_and_si128( steppedOnXInt, stepX );
+        __m128i moveY = _mm_andnot_si128( steppedOnXInt, stepY );
+        tileX = _mm_add_epi32( tileX, moveX );
+        tileY = _mm_add_epi32( tileY, moveY );
+        tileIndex = _mm_add_epi32( tileIndex, _mm_or_si128( moveX, _mm_andnot_si128( steppedOnXInt, stepIndexY ) ) );
+        nextDistX = _mm_add_ps( nextDistX, _mm_and_ps( steppedOnX, deltaDistX ) );
+        nextDistY = _mm_add_ps( nextDistY, _mm_andnot_ps( steppedOnX, deltaDistY ) );
+
+        isActive = _mm_andnot_si128( _mm_castps_si128( _mm_cmpgt_ps( distance, maxDistance ) ), isActive );
+
+        if( _mm_movemask_ps( _mm_castsi128_ps( isActive ) ) == 0 ) {
+            break;
+        }
+    }
+
+    alignas( 16 ) float laneImpactDistance[4];
+    alignas( 16 ) int laneImpactTileX[4];
+    alignas( 16 ) int laneImpactTileY[4];
+    alignas( 16 ) int laneImpactNormalX[4];
+    alignas( 16 ) int laneImpactNormalY[4];
+    _mm_store_ps( laneImpactDistance, impactDistance );
+    _mm_store_si128( (__m128i*)laneImpactTileX, impactTileX );
+    _mm_store_si128( (__m128i*)laneImpactTileY, impactTileY );
+    _mm_store_si128( (__m128i*)laneImpactNormalX, impactNormalX );
+    _mm_store_si128( (__m128i*)laneImpactNormalY, impactNormalY );
+
+    int impactLanes = _mm_movemask_ps( _mm_castsi128_ps( didImpact ) );
+    int startedInWallLanes = _mm_movemask_ps( _mm_castsi128_ps( startedInWall ) );
+
+    for( int lane = 0; lane < 4; lane++ ) {
+        const RayQuery& query = queries[lane];
+        RaycastResult& result = out_results[lane];
+        result = RaycastResult();
+
+        if( (impactLanes & (1 << lane)) == 0 ) {
+            continue;
+        }
+
+        result.impactTile = GetImpactTile( laneImpactTileX[lane], laneImpactTileY[lane] );
+        result.didImpact = true;
+
+        if( (startedInWallLanes & (1 << lane)) != 0 ) {
+            result.impactPosition = query.startPosition;
+            result.impactNormal = Vec2( -query.normalizedDirection.x, -query.normalizedDirection.y );
+        } else {
+            float laneDistance = laneImpactDistance[lane];
+            result.impactDistance = laneDistance;
+            result.impactFraction = laneDistance / query.maxDistance;
+            result.impactPosition = query.startPosition + (laneDistance * query.normalizedDirection);
+            result.impactNormal = Vec2( (float)-laneImpactNormalX[lane], (float)-laneImpactNormalY[lane] );
+        }
+    }
 }
 
 
@@ -681,10 +1808,11 @@ void Map::UpdateFromController( float deltaSeconds ) {
         const XboxController& controller = g_theInput->GetController( playerIndex );
         
         if( controller.IsConnected() && GetPlayer(playerIndex) == nullptr ) {
-            PlayerTank* player = new PlayerTank( this, playerIndex );
-            m_entitiesByType[ENTITY_TYPE_PLAYERTANK][playerIndex] = player;
-            m_entities.push_back( player );
-            player->Startup();
+            MapCommand command;
+            command.type = MAP_COMMAND_SPAWN_ENTITY;
+            command.entityType = ENTITY_TYPE_PLAYERTANK;
+            command.playerID = playerIndex;
+            QueueStructuralCommand( command );
 
             SoundID newPlayerID = g_theAudio->CreateOrGetSound( AUDIO_PLAYERTANK_JOIN );
             g_theAudio->PlaySound( newPlayerID );
@@ -693,6 +1821,153 @@ void Map::UpdateFromController( float deltaSeconds ) {
 }
 
 
+void Map::UpdateFlowFields() {
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS; playerIndex++ ) {
+        FlowField& flowField = m_playerFlowFields[playerIndex];
+        PlayerTank* player = GetPlayer( playerIndex );
+
+        if( player == nullptr || !player->IsAlive() ) {
+            flowField.ClearGoal();
+            m_flowFieldTargets[playerIndex] = EntityHandle::INVALID;
+            continue;
+        }
+
+        // No-op until the player crosses into another tile
+        flowField.SetGoal( *this, GetTileIndexFromWorldCoords( player->GetPosition() ) );
+        m_flowFieldTargets[playerIndex] = player->GetHandle();
+    }
+}
+
+
+void Map::StorePreviousTransforms() {
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    int numEntities = (int)entities.size();
+
+    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
+        entities[entityIndex]->StorePreviousTransform();
+    }
+}
+
+
+void Map::UpdateRaycasts() {
+    m_rayQueries.clear();
+
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    int numEntities = (int)entities.size();
+    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
+        Entity* entity = entities[entityIndex];
+        if( entity->IsAlive() && !entity->IsGarbage() ) {
+            entity->QueueRaycasts();
+        }
+    }
+
+    int numRays = (int)m_rayQueries.size();
+    m_rayResults.resize( numRays );
+    RaycastBatch( numRays, m_rayQueries.data(), m_rayResults.data() );
+}
+
+
+void Map::UpdateEntities( float deltaSeconds ) {
+    StoreTickStates();
+
+    // Players drive game state (next map, end of game), so they update on this thread first
+    for( int playerIndex = 0; playerIndex < MAX_CONTROLLERS && !m_arePlayersLeaving; playerIndex++ ) {
+        PlayerTank* player = GetPlayer( playerIndex );
+
+        if( player != nullptr ) {
+            player->Update( deltaSeconds );
+        }
+    }
+
+    // Everything else updates in contiguous jobs, each recording its effects into its own buffer
+    // Applying the buffers in job order gives the same result for any number of threads
+    m_jobDeltaSeconds = deltaSeconds;
+    m_jobStartIndex = 0;
+    m_jobEndIndex = m_entityRegistry.GetNumEntities();
+    int numJobs = (m_jobEndIndex - m_jobStartIndex + MAP_UPDATE_ENTITIES_PER_JOB - 1) / MAP_UPDATE_ENTITIES_PER_JOB;
+
+    if( (int)m_commandBuffers.size() < numJobs ) {
+        m_commandBuffers.resize( numJobs );
+    }
+
+    g_theJobSystem->ParallelFor( numJobs, &Map::UpdateEntitiesJob, this );
+
+    for( int jobIndex = 0; jobIndex < numJobs; jobIndex++ ) {
+        ApplyCommandBuffer( m_commandBuffers[jobIndex] );
+        m_commandBuffers[jobIndex].clear();
+    }
+}
+
+
+void Map::StoreTickStates() {
+    // Cleared first so handles to destroyed entities don't find an old state
+    m_tickStates.assign( m_entityRegistry.GetNumSlots(), EntityTickState() );
+
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    int numEntities = (int)entities.size();
+
+    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
+        const Entity* entity = entities[entityIndex];
+        EntityTickState& state = m_tickStates[entity->m_handle.index];
+
+        state.handle = entity->m_handle;
+        state.position = entity->m_position;
+        state.health = entity->m_health;
+        state.isAlive = entity->IsAlive();
+    }
+}
+
+
+void Map::ApplyCommandBuffer( const MapCommandBuffer& commands ) {
+    int numCommands = (int)commands.size();
+
+    for( int commandIndex = 0; commandIndex < numCommands; commandIndex++ ) {
+        const MapCommand& command = commands[commandIndex];
+
+        switch( command.type ) {
+            case(MAP_COMMAND_SPAWN_ENTITY): {
+                QueueStructuralCommand( command );
+                break;
+            } case(MAP_COMMAND_SPAWN_EXPLOSION): {
+                SpawnNewExplosion( command.position, command.scale, command.duration );
+                break;
+            } case(MAP_COMMAND_PLAY_SOUND): {
+                PlaySound( command.sound );
+                break;
+            } case(MAP_COMMAND_TRANSFER_PLAYERS): {
+                QueueStructuralCommand( command );
+                break;
+            } case(MAP_COMMAND_REQUEST_PATH): {
+                m_pathRequests.SubmitRequest( command.sourceHandle, command.startTileIndex, command.goalTileIndex, m_numTicks );
+                break;
+            }
+        }
+    }
+}
+
+
+void Map::UpdateEntitiesJob( void* userData, int jobIndex ) {
+    Map* map = (Map*)userData;
+    int startIndex = map->m_jobStartIndex + (jobIndex * MAP_UPDATE_ENTITIES_PER_JOB);
+    int endIndex = startIndex + MAP_UPDATE_ENTITIES_PER_JOB;
+    endIndex = (endIndex < map->m_jobEndIndex) ? endIndex : map->m_jobEndIndex;
+
+    // Entities only write their own state, anything that touches the map goes into this job's buffer
+    s_jobCommandBuffer = &map->m_commandBuffers[jobIndex];
+
+    const EntityList& entities = map->m_entityRegistry.GetEntities();
+    for( int entityIndex = startIndex; entityIndex < endIndex; entityIndex++ ) {
+        Entity* entity = entities[entityIndex];
+
+        if( entity->GetEntityType() != ENTITY_TYPE_PLAYERTANK ) {
+            entity->Update( map->m_jobDeltaSeconds );
+        }
+    }
+
+    s_jobCommandBuffer = nullptr;
+}
+
+
 void Map::UpdateCollision() {
     //---------------------------------
     // Update Entity v Tile Collision
@@ -709,21 +1984,52 @@ void Map::UpdateCollision() {
         IntVec2(  1, -1 )  // Southeast
     };
 
-    Entity* entity1 = nullptr;
-    Tile* tile = nullptr;
-    int numEntities = (int)m_entities.size();
+    // Positions and flags come from the component stores, entities are only touched when they hit something
+    const EntityComponentStore* bulletStore = &EntityComponentStore::GetStore( ENTITY_TYPE_BULLET );
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    const std::vector<EntityComponentRef>& entityComponents = m_entityRegistry.GetEntityComponents();
+    int numEntities = (int)entityComponents.size();
+    m_numAwakeEntities = 0;
+    m_numAsleepEntities = 0;
 
     for( int entityIter = 0; entityIter < numEntities; entityIter++ ) {
-        entity1 = m_entities[entityIter];
+        const EntityComponentRef& components = entityComponents[entityIter];
+        EntityComponentChunk& chunk = components.store->GetChunk( components.row );
+        int indexInChunk = EntityComponentStore::GetIndexInChunk( components.row );
+
+        if( chunk.isDead[indexInChunk] || chunk.isGarbage[indexInChunk] ) {
+            continue;
+        }
+
+        // Anything its update moved since the end of the last pass is awake
+        Vec2& position = chunk.positions[indexInChunk];
+        int& numStillTicks = chunk.numStillTicks[indexInChunk];
+
+        if( position != chunk.restPositions[indexInChunk] ) {
+            chunk.restPositions[indexInChunk] = position;
+            numStillTicks = 0;
+        } else if( numStillTicks < MAP_SLEEP_STILL_TICKS ) {
+            numStillTicks++;
+        }
+
+        // Asleep means neither its update nor collision has moved it for a while, so the same tiles can't move it now
+        if( numStillTicks >= MAP_SLEEP_STILL_TICKS ) {
+            m_numAsleepEntities++;
+            continue;
+        }
+
+        m_numAwakeEntities++;
 
-        if( entity1 != nullptr && entity1->IsAlive() && !entity1->IsGarbage() && entity1->GetEntityType() != ENTITY_TYPE_BULLET ) {
-            // Bullets handle tile collision in their own update preventatively
-            IntVec2 currentTileCoords = GetTileCoordsFromWorldCoords( entity1->GetPosition() );
+        // Bullets handle tile collision in their own update preventatively
+        if( components.store != bulletStore ) {
+            IntVec2 currentTileCoords = GetTileCoordsFromWorldCoords( chunk.positions[indexInChunk] );
 
             for( int tileIter = 0; tileIter < numTileOffsets; tileIter++ ) {
                 int tileIndex = GetTileIndexFromTileCoords( currentTileCoords + tileOffsets[tileIter] );
-                tile = &m_tiles[tileIndex];
-                entity1->OnCollisionTile( tile );
+
+                if( IsTileSolid( tileIndex ) ) {
+                    entities[entityIter]->OnCollisionTile( GetTileBounds( tileIndex ) );
+                }
             }
         }
     }
@@ -731,48 +2037,269 @@ void Map::UpdateCollision() {
     //---------------------------------
     // Update Entity v Entity Collision
     //---------------------------------
-    Entity* entity2 = nullptr;
+    // Broadphase: only pairs sharing a grid cell reach the disc test
+    m_spatialHash.Rebuild( entities, entityComponents );
+    m_numCandidatePairs = m_spatialHash.GetCandidatePairs( m_collisionLayers, m_collisionPairs, m_numSkippedPairs, m_numSleepingPairs );
 
-    for( int entity1Index = 0; entity1Index < numEntities - 1; entity1Index++ ) {
-        entity1 = m_entities[entity1Index];
+    int numObjects = m_spatialHash.GetNumObjects();
+    m_numBruteForcePairs = (numObjects * (numObjects - 1)) / 2;
 
-        if( entity1 != nullptr && entity1->IsAlive() && !entity1->IsGarbage() ) {
-            for( int entity2Index = entity1Index + 1; entity2Index < numEntities; entity2Index++ ) {
-                entity2 = m_entities[entity2Index];
+    for( int pairIndex = 0; pairIndex < m_numCandidatePairs; pairIndex++ ) {
+        const CollisionPair& pair = m_collisionPairs[pairIndex];
 
-                if( entity2 != nullptr && entity2->IsAlive() && !entity2->IsGarbage() ) {
-                    Vec2 entity1Center;
-                    Vec2 entity2Center;
-                    float entity1Radius;
-                    float entity2Radius;
+        EntityComponentChunk& chunk1 = pair.components1.store->GetChunk( pair.components1.row );
+        EntityComponentChunk& chunk2 = pair.components2.store->GetChunk( pair.components2.row );
+        int index1 = EntityComponentStore::GetIndexInChunk( pair.components1.row );
+        int index2 = EntityComponentStore::GetIndexInChunk( pair.components2.row );
 
-                    entity1->GetPhysicsDisc( entity1Center, entity1Radius );
-                    entity2->GetPhysicsDisc( entity2Center, entity2Radius );
+        // Earlier pairs may have killed either entity this frame, and collision responses move entities,
+        //  so flags and discs are read live rather than from the broadphase
+        if( chunk1.isDead[index1] || chunk1.isGarbage[index1] || chunk2.isDead[index2] || chunk2.isGarbage[index2] ) {
+            continue;
+        }
 
-                    if( DoDiscsOverlap(entity1Center, entity1Radius, entity2Center, entity2Radius) ) {
-                        entity1->OnCollisionEntity( entity2 );
-                        entity2->OnCollisionEntity( entity1 );
-                    }
-                }
+        bool isTouching = false;
+        if( chunk1.isSwept[index1] || chunk2.isSwept[index2] ) {
+            isTouching = DoSweptDiscsTouch( chunk1, index1, chunk2, index2 );
+        } else {
+            isTouching = DoDiscsOverlap( chunk1.positions[index1], chunk1.physicsRadii[index1], chunk2.positions[index2], chunk2.physicsRadii[index2] );
+        }
+
+        if( isTouching ) {
+            pair.entity1->OnCollisionEntity( pair.entity2 );
+            pair.entity2->OnCollisionEntity( pair.entity1 );
+
+            // Touched by a moving body, back to full collision next tick
+            if( pair.isAsleep1 ) {
+                chunk1.numStillTicks[index1] = 0;
+            }
+
+            if( pair.isAsleep2 ) {
+                chunk2.numStillTicks[index2] = 0;
             }
         }
     }
+
+    // Anything collision moved is awake too, rest positions become this pass's results
+    for( int entityIter = 0; entityIter < numEntities; entityIter++ ) {
+        const EntityComponentRef& components = entityComponents[entityIter];
+        EntityComponentChunk& chunk = components.store->GetChunk( components.row );
+        int indexInChunk = EntityComponentStore::GetIndexInChunk( components.row );
+
+        if( chunk.positions[indexInChunk] != chunk.restPositions[indexInChunk] ) {
+            chunk.restPositions[indexInChunk] = chunk.positions[indexInChunk];
+            chunk.numStillTicks[indexInChunk] = 0;
+        }
+    }
 }
 
 
 void Map::CollectGarbage() {
-    int numEntities = (int)m_entities.size();
-    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
-        Entity* entity = m_entities[entityIndex];
-        if( entity != nullptr && entity->IsGarbage() ) {
+    // Backwards, removal swaps the last entity into the freed spot
+    const EntityList& entities = m_entityRegistry.GetEntities();
+    for( int entityIndex = (int)entities.size() - 1; entityIndex >= 0; entityIndex-- ) {
+        Entity* entity = entities[entityIndex];
+        if( entity->IsGarbage() ) {
             DestroyEntity( *entity );
         }
     }
 }
 
 
+void Map::QueueStructuralCommand( const MapCommand& command ) {
+    if( s_jobCommandBuffer != nullptr ) {
+        s_jobCommandBuffer->push_back( command );
+        return;
+    }
+
+    m_structuralCommands.push_back( command );
+
+    if( !m_isDeferringStructuralChanges ) {
+        ApplyStructuralChanges();
+    }
+}
+
+
+void Map::ApplyStructuralChanges() {
+    // Garbage flags are the destroy requests, destroyed first so their slots are reused by this batch's spawns
+    CollectGarbage();
+
+    // Swapped out, so anything requested while applying (a Startup that spawns) lands in the next batch
+    while( !m_structuralCommands.empty() ) {
+        m_applyingStructuralCommands.swap( m_structuralCommands );
+        std::stable_sort( m_applyingStructuralCommands.begin(), m_applyingStructuralCommands.end(), IsStructuralCommandBefore );
+
+        int numCommands = (int)m_applyingStructuralCommands.size();
+        int numSpawns = 0;
+        int numSpawnsByType[NUM_ENTITY_TYPES] = {};
+
+        for( int commandIndex = 0; commandIndex < numCommands; commandIndex++ ) {
+            const MapCommand& command = m_applyingStructuralCommands[commandIndex];
+
+            if( command.type == MAP_COMMAND_SPAWN_ENTITY ) {
+                numSpawnsByType[command.entityType]++;
+                numSpawns++;
+            }
+        }
+
+        m_entityRegistry.Reserve( numSpawns, numSpawnsByType );
+
+        for( int commandIndex = 0; commandIndex < numCommands; commandIndex++ ) {
+            const MapCommand& command = m_applyingStructuralCommands[commandIndex];
+
+            if( command.type == MAP_COMMAND_TRANSFER_PLAYERS ) {
+                TransferPlayersNow( command.destinationMap );
+            } else {
+                SpawnEntityNow( command );
+            }
+        }
+
+        m_applyingStructuralCommands.clear();
+    }
+}
+
+
+void Map::SpawnEntityNow( const MapCommand& command ) {
+    if( command.entityType == ENTITY_TYPE_PLAYERTANK && GetPlayer( command.playerID ) != nullptr ) {
+        return; // Already joined, or arrived from the previous map
+    }
+
+    if( command.entityType == ENTITY_TYPE_BULLET && m_areBulletsProjectiles ) {
+        m_projectiles.SpawnProjectile( command.position, command.orientationDegrees, command.sourceFaction );
+        return;
+    }
+
+    Entity* entity = AllocateEntity( command.entityType, command.playerID );
+    if( entity == nullptr ) {
+        return;
+    }
+
+    if( command.entityType == ENTITY_TYPE_BULLET ) {
+        ((Bullet*)entity)->Reset( command.sourceFaction, command.sourceHandle );
+    }
+
+    entity->m_position = command.position;
+    entity->m_orientationDegrees = command.orientationDegrees;
+
+    AddEntityToMap( *entity );
+    entity->Startup();
+}
+
+
+Entity* Map::AllocateEntity( EntityType type, int playerID /*= -1*/ ) {
+    switch(type) {
+        case(ENTITY_TYPE_BOULDER): {
+            return (Entity*)(new Boulder( this ));
+        } case(ENTITY_TYPE_BULLET): {
+            Bullet* bullet = m_bulletPool.Acquire();
+            if( bullet == nullptr ) { // Pool exhausted, fall back to the heap
+                bullet = new Bullet( this );
+            }
+
+            return (Entity*)bullet;
+        } case(ENTITY_TYPE_ENEMYTANK): {
+            return (Entity*)(new EnemyTank( this ));
+        } case(ENTITY_TYPE_ENEMYTURRET): {
+            return (Entity*)(new EnemyTurret( this ));
+        } case(ENTITY_TYPE_PLAYERTANK): {
+            if( playerID >= 0 && playerID < MAX_CONTROLLERS ) {
+                return (Entity*)(new PlayerTank( this, playerID ));
+            }
+
+            return nullptr;
+        } default: {
+            return nullptr;
+        }
+    }
+}
+
+
 void Map::DestroyEntity( Entity& entity ) {
     RemoveEntityFromMap( entity );
+    ReleaseEntity( entity );
+}
+
+
+void Map::ReleaseEntity( Entity& entity ) {
     entity.Shutdown();
-    delete &entity;
+
+    // Pooled entities are recycled, anything else (including pool overflow) came from new
+    bool wasPooled = false;
+    EntityType type = entity.GetEntityType();
+
+    if( type == ENTITY_TYPE_BULLET ) {
+        wasPooled = m_bulletPool.Release( (Bullet*)&entity );
+    }
+
+    if( !wasPooled ) {
+        delete &entity;
+    }
+}
+
+
+bool Map::RestoreSnapshotEntity( BufferReader& reader ) {
+    EntityType type = (EntityType)reader.ReadUint8();
+    int playerID = (type == ENTITY_TYPE_PLAYERTANK) ? (int)reader.ReadUint8() : -1;
+
+    EntityHandle handle;
+    handle.index = reader.ReadInt32();
+    handle.generation = reader.ReadUint32();
+
+    Entity* entity = TakeSnapshotSpare( type, playerID );
+
+    if( entity == nullptr ) {
+        entity = AllocateEntity( type, playerID );
+        if( entity == nullptr ) {
+            return false;
+        }
+
+        // Startup sets up textures and constants, the snapshot then overwrites all simulation state
+        entity->Startup();
+    }
+
+    entity->ReadSnapshot( reader );
+    entity->m_handle = handle;
+    entity->ClearPreviousTransform();
+
+    if( !m_entityRegistry.RestoreEntity( entity ) ) {
+        entity->m_handle = EntityHandle::INVALID;
+        ReleaseEntity( *entity );
+        return false;
+    }
+
+    if( type == ENTITY_TYPE_PLAYERTANK ) {
+        m_players[playerID] = (PlayerTank*)entity;
+    }
+
+    return true;
+}
+
+
+Entity* Map::TakeSnapshotSpare( EntityType type, int playerID ) {
+    if( type < 0 || type >= NUM_ENTITY_TYPES ) {
+        return nullptr;
+    }
+
+    EntityList& spares = m_snapshotSpares[type];
+    int numSpares = (int)spares.size();
+
+    for( int spareIndex = numSpares - 1; spareIndex >= 0; spareIndex-- ) {
+        Entity* spare = spares[spareIndex];
+
+        // Players can only be reused by the same controller
+        if( type != ENTITY_TYPE_PLAYERTANK || ((PlayerTank*)spare)->GetPlayerID() == playerID ) {
+            spares[spareIndex] = spares[numSpares - 1];
+            spares.pop_back();
+            return spare;
+        }
+    }
+
+    return nullptr;
+}
+
+
+double Map::EndPhase( MapUpdatePhase phase, double phaseStartSeconds ) {
+    double phaseEndSeconds = GetCurrentTimeSeconds();
+    m_phaseSeconds[phase] += phaseEndSeconds - phaseStartSeconds;
+    return phaseEndSeconds;
 }
@@ -1,18 +1,83 @@
 #pragma once
+#include "Engine/Core/BufferUtils.hpp"
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/RNG.hpp"
 
 #include "Game/GameCommon.hpp"
+#include "Game/Bullet.hpp"
+#include "Game/CollisionLayers.hpp"
 #include "Game/Entity.hpp"
+#include "Game/EntityPool.hpp"
+#include "Game/EntityRegistry.hpp"
+#include "Game/FlowField.hpp"
+#include "Game/GridPathfinder.hpp"
+#include "Game/PathRequestService.hpp"
+#include "Game/ParticleSystem.hpp"
+#include "Game/ProjectileSystem.hpp"
+#include "Game/RaycastResult.hpp"
+#include "Game/SpatialHash.hpp"
 #include "Game/Tile.hpp"
 
 #include "vector"
 
-class Explosion;
 class PlayerTank;
-struct RaycastResult;
 class SpriteSheet;
 
+// Stages of Map::Update, timed every tick
+enum MapUpdatePhase {
+    MAP_PHASE_CONTROLLER,
+    MAP_PHASE_FLOW_FIELDS,
+    MAP_PHASE_RAYCASTS,
+    MAP_PHASE_ENTITIES,
+    MAP_PHASE_PATHS,
+    MAP_PHASE_PARTICLES,
+    MAP_PHASE_COLLISION,
+    MAP_PHASE_PROJECTILES,
+    MAP_PHASE_STRUCTURAL,
+
+    NUM_MAP_PHASES
+};
+
+// Entity state from before the entity update, safe to read from any entity's Update while others write their own
+struct EntityTickState {
+    public:
+    EntityHandle handle;
+    Vec2 position;
+    int health = 0;
+    bool isAlive = false;
+};
+
+// Cross-entity effects recorded by the parallel entity update, applied in entity order once every job is done
+// Spawns and player transfers change the entity lists, so they wait for the map's structural sync point
+// Path requests join the queue in entity order, so the budget picks the same ones on any thread count
+enum MapCommandType {
+    MAP_COMMAND_SPAWN_ENTITY,
+    MAP_COMMAND_SPAWN_EXPLOSION,
+    MAP_COMMAND_PLAY_SOUND,
+    MAP_COMMAND_TRANSFER_PLAYERS,
+    MAP_COMMAND_REQUEST_PATH
+};
+
+struct MapCommand {
+    public:
+    MapCommandType type = MAP_COMMAND_SPAWN_ENTITY;
+    EntityType entityType = ENTITY_TYPE_UNKNOWN;
+    int playerID = -1;
+    Vec2 position;
+    float orientationDegrees = 0.f;
+    float scale = 0.f;
+    float duration = 0.f;
+    FactionID sourceFaction = FACTION_UNKNOWN;
+    EntityHandle sourceHandle;
+    SoundID sound = MISSING_SOUND_ID;
+    Map* destinationMap = nullptr;
+    int startTileIndex = -1;
+    int goalTileIndex = -1;
+};
+
+typedef std::vector<MapCommand> MapCommandBuffer;
+
 class Map {
     public:
     //Map();
@@ -20,42 +85,109 @@ class Map {
     ~Map() {};
 
 	void Startup();
+	void StartupTiles(); // Tile layout only, no entities or players
 	void Shutdown();
 
 	void Update( float deltaSeconds );
-	void Render() const;
+	void Render( const AABB2& viewBounds, float tickAlpha = 1.f ) const; // Blends entities between the previous and current tick, terrain only inside viewBounds
 
     bool HandleKeyPressed( unsigned char keyCode );
     //bool HandleKeyReleased( unsigned char keyCode );
 
     const IntVec2& GetDimensions() const;
+    const std::vector<unsigned int>& GetTileSolidBits() const; // One bit per tile, 32 tiles per word
     const IntVec2 GetTileCoordsFromWorldCoords( const Vec2& worldCoords ) const;
     int GetTileIndexFromTileCoords( const IntVec2& tileCoords ) const;
     int GetTileIndexFromTileCoords( int xIndex, int yIndex ) const;
     int GetTileIndexFromWorldCoords( const Vec2& worldCoords ) const;
+    const IntVec2 GetTileCoordsFromTileIndex( int tileIndex ) const;
+    const AABB2 GetTileBounds( int tileIndex ) const;
     const Tile& GetTileFromTileCoords( const IntVec2& tileCoords ) const;
     const Tile& GetTileFromTileCoords( int xIndex, int yIndex ) const;
     const Tile& GetTileFromWorldCoords( const Vec2& worldCoords ) const;
+    bool IsTileSolid( int tileIndex ) const;
+    bool IsTileSolid( int tileX, int tileY ) const;
+    bool IsTileSolidAtWorldCoords( const Vec2& worldCoords ) const;
+    float GetMovementModifierAtWorldCoords( const Vec2& worldCoords ) const;
+    TileType GetTileTypeAtWorldCoords( const Vec2& worldCoords ) const;
+    void SetTileType( int tileIndex, TileType type );
+    size_t GetTileMemoryBytes() const; // Tiles and everything sized by them: flat arrays, built mesh chunks, flow fields, jump tables, broadphase cells
     PlayerTank* GetPlayer( int playerIndex ) const;
+    int GetNumEntities() const;
+    const EntityRegistry& GetEntityRegistry() const; // Benchmarks walk the lists directly
+    Entity* GetEntity( const EntityHandle& handle ) const;
+    const EntityTickState* GetTickState( const EntityHandle& handle ) const; // nullptr if the handle is stale
     bool AreAllPlayersDead() const;
     bool IsOnlyOnePlayerAlive() const;
     bool IsArenaMode() const;
 
-    Entity* SpawnNewEntity( EntityType type, const Vec2& position, float orientationDegrees, Entity* source = nullptr );
-    Explosion* SpawnNewExplosion( const Vec2& position, float scale, float duration = EXPLOSION_DURATION );
+    // Explosions and sounds from the parallel entity update are recorded and applied after it
+    // Spawns (and SendPlayersToNewMap) requested during Update or Startup wait for its structural sync point at the end,
+    //	grouped by type, anything requested outside them applies right away
+    void SpawnNewEntity( EntityType type, const Vec2& position, float orientationDegrees, Entity* source = nullptr );
+    void SpawnNewExplosion( const Vec2& position, float scale, float duration = EXPLOSION_DURATION );
+    void PlaySound( SoundID sound );
 
     void AddEntityToMap( Entity& entity );
-    void AddEntityToList( Entity& entity, EntityList& list );
-
     void RemoveEntityFromMap( Entity& entity );
-    void RemoveEntityFromList( Entity& entity, EntityList& list );
 
     const RaycastResult Raycast( const Vec2& startPosition, const Vec2& normalizedDirection, float maxDistance = MAP_RAYCAST_MAX_DISTANCE ) const;
+    bool SweepDiscVsTiles( const Vec2& start, const Vec2& displacement, float radius, float& out_impactFraction, AABB2& out_tileBounds ) const; // First solid tile the moving disc touches
+    void RaycastBatch( int numRays, const RayQuery* queries, RaycastResult* out_results ) const;
     bool HasLineOfSight( const Entity* source, const Entity* destination ) const;
-    Entity* AcquireNewTarget() const;
+    Entity* AcquireNewTarget(); // Draws from the map RNG
+    Entity* GetOrAcquireTarget( EntityHandle& targetHandle );
+
+    // One flow field per player, rebuilt when the player moves to a new tile and repaired when tiles change
+    // Read only during the entity update, so any number of tanks can look up from worker threads
+    bool GetFlowDirectionToward( const EntityHandle& targetHandle, const Vec2& position, Vec2& out_direction, int& out_distance ) const; // False if the target has no field or can't be walked to
+    void GetFlowFieldStats( int& out_numRebuilds, int& out_numRepairs ) const;
+
+    // Jump Point Search+ between two open tiles, safe from any thread during the entity update and doesn't allocate
+    // Returns the number of waypoints (start and goal included), 0 if there's no path, only the first maxWaypoints are written
+    int FindPath( const IntVec2& startTileCoords, const IntVec2& goalTileCoords, IntVec2* out_waypoints, int maxWaypoints ) const;
+
+    // Asynchronous FindPath for entities, requested during Update and solved after the entity update within a per-tick budget
+    // The result is readable by the requester's handle from the next tick on, and stays until its next path arrives
+    void RequestPath( const EntityHandle& requester, const IntVec2& startTileCoords, const IntVec2& goalTileCoords );
+    const PathResult* GetPathResult( const EntityHandle& requester ) const; // nullptr until the first path arrives
+    const PathRequestStats& GetPathRequestStats() const;
+
+    // Per-tick ray batch, entities submit during QueueRaycasts and read results during Update
+    int SubmitRaycast( const Vec2& startPosition, const Vec2& normalizedDirection, float maxDistance = MAP_RAYCAST_MAX_DISTANCE );
+    int SubmitLineOfSight( const Entity* source, const Entity* destination );
+    const RaycastResult& GetSubmittedRaycastResult( int rayIndex ) const;
+    int GetNumBatchedRaycasts() const;
+
+    void QueryEntitiesInRadius( const Vec2& center, float radius, EntityList& out_entities ) const;
+    void QueryEntitiesInAABB2( const AABB2& bounds, EntityList& out_entities ) const;
+    Entity* GetFirstEntityHitByBullet( const Vec2& position, float radius, FactionID faction ) const; // Broadphase from the last collision pass, filtered by the collision layers
+    void GetCollisionPairStats( int& out_candidatePairs, int& out_bruteForcePairs ) const;
+    int GetNumSkippedPairs() const; // Broadphase pairs the collision layers filtered out last tick
+    void GetSleepStats( int& out_numAwake, int& out_numAsleep, int& out_numSleepingPairs ) const; // Last tick's collision pass
+    void GetPoolStats( EntityType type, int& out_numInUse, int& out_highWaterMark, int& out_capacity, int& out_numExhausted ) const;
+    void GetExplosionParticleStats( int& out_numParticles, int& out_highWaterMark ) const;
+    void GetProjectileStats( int& out_numProjectiles, int& out_highWaterMark ) const;
+    double GetPhaseSeconds( MapUpdatePhase phase ) const; // Accumulated since the last ResetPhaseTimings
+    void ResetPhaseTimings();
+    static const char* GetPhaseName( MapUpdatePhase phase );
 
     void SendPlayersToNewMap( Map* newMap );
 
+    // Deterministic simulation, all gameplay randomness comes from the map's own RNG
+    void SetSeed( unsigned int seed ); // Also restarts the random sequence, Startup restarts it again
+    void SetStateHashingEnabled( bool isEnabled );
+    void SetBulletProjectilesEnabled( bool isEnabled ); // Bullets spawn into the projectile kernel instead of as entities, also on with bulletProjectiles in the game config
+    unsigned int GetSeed() const;
+    unsigned int ComputeStateHash() const; // Tiles, entities and RNG position right now
+    unsigned int GetRollingStateHash() const; // Every tick's state hash chained together since Startup
+    int GetNumTicks() const;
+
+    // Versioned binary snapshot of tiles, entities, explosions and RNG position, entity references are saved as handles
+    // Restoring onto the map it came from (same dimensions and mode) continues the simulation exactly
+    void SaveSnapshot( ByteBuffer& out_buffer ) const; // Overwrites the buffer, reusing its capacity
+    bool RestoreSnapshot( const ByteBuffer& buffer ); // The whole snapshot is checked first, false leaves the map untouched
+
     static void PushEntitiesOutOfEachOther( Entity* entity1, Entity* entity2 );
 
     private:
@@ -73,24 +205,103 @@ class Map {
     };
     const bool m_arenaMode = false;
 
-    std::vector<Tile> m_tiles = {};
+    unsigned int m_seed = 0;
+    RNG m_rng;
+    bool m_isStateHashingEnabled = false;
+    unsigned int m_rollingStateHash = 0;
+    int m_numTicks = 0;
+
+    std::vector<Tile> m_tiles = {}; // One byte per tile
+
+    // Flat copies of the TileDef properties, kept in sync by SetTileType so hot paths never chase TileDef pointers
+    std::vector<unsigned int> m_tileSolidBits = {}; // One bit per tile, 32 tiles per word
+    std::vector<float> m_tileMovementModifiers = {};
+
+    // Terrain mesh per MAP_MESH_CHUNK_SIZE square, six verts per tile, built by Render when it comes into view and freed once out of it
+    mutable std::vector<std::vector<Vertex_PCU>> m_meshChunks = {}; // Empty until built, patched by SetTileType while built
+    mutable std::vector<int> m_builtMeshChunks = {};
+
+    EntityRegistry m_entityRegistry;
+    PlayerTank* m_players[MAX_CONTROLLERS] = {};
+
+    EntityPool<Bullet> m_bulletPool;
+    ParticleSystem m_explosionParticles;
+    ProjectileSystem m_projectiles;
+    bool m_areBulletsProjectiles = false;
 
-    EntityList m_entities = {};
-    EntityList m_entitiesByType[NUM_ENTITY_TYPES] = {};
+    FlowField m_playerFlowFields[MAX_CONTROLLERS];
+    EntityHandle m_flowFieldTargets[MAX_CONTROLLERS]; // Player each field leads to, INVALID while it has no goal
+    GridPathfinder m_pathfinder; // Jump tables built at Startup, patched by SetTileType, rebuilt once by RestoreSnapshot
+    PathRequestService m_pathRequests;
     //EntityList m_entitiesByFactions[NUM_FACTIONS] = {};
 
-    EntityList m_explosions = {};
+    SpatialHash m_spatialHash;
+    std::vector<CollisionPair> m_collisionPairs = {};
+    int m_numCandidatePairs = 0;
+    int m_numBruteForcePairs = 0;
+    CollisionLayers m_collisionLayers; // Defaults plus the collisionLayers game config, read at Startup
+    int m_numSkippedPairs = 0;
+    int m_numSleepingPairs = 0; // Both asleep, never tested
+    int m_numAwakeEntities = 0;
+    int m_numAsleepEntities = 0;
+
+    EntityList m_snapshotSpares[NUM_ENTITY_TYPES]; // Entities from before a restore, reused instead of reallocated
+    EntityRegistry m_snapshotLayout; // Registry layout of the snapshot being checked, never holds entities
+
+    std::vector<RayQuery> m_rayQueries = {};
+    std::vector<RaycastResult> m_rayResults = {};
+
+    std::vector<EntityTickState> m_tickStates = {}; // By handle index, stored before the entity update
+    std::vector<MapCommandBuffer> m_commandBuffers = {}; // One per update job, reused every tick
+    MapCommandBuffer m_structuralCommands = {}; // Spawns and transfers waiting for the sync point
+    MapCommandBuffer m_applyingStructuralCommands = {};
+    bool m_isDeferringStructuralChanges = false;
+    bool m_arePlayersLeaving = false; // A transfer is queued, players stop updating here
+    float m_jobDeltaSeconds = 0.f;
+    int m_jobStartIndex = 0;
+    int m_jobEndIndex = 0;
+
+    double m_phaseSeconds[NUM_MAP_PHASES] = {};
 
     void StartupMakeAllGroundTiles();
+    void UpdateTileProperties( int tileIndex );
     void StartupAddWallBorder();
     void StartupAddRandomTiles( TileType type, float fraction );
     void StartupAddSafeBunkers();
     void StartupAddEntities( EntityType type, int numEnemies );
 
-    std::vector<Vertex_PCU> BuildMapVerts() const;
+    const IntVec2 GetNumMeshChunks() const;
+    const IntVec2 GetMeshChunkTileMins( int chunkIndex ) const;
+    const IntVec2 GetMeshChunkTileDimensions( int chunkIndex ) const;
+    void RenderMeshChunks( const AABB2& viewBounds ) const;
+    void BuildMeshChunk( int chunkIndex ) const;
+    void UpdateTileVerts( int tileIndex );
+    void WriteTileVerts( int tileIndex, Vertex_PCU* out_verts ) const;
+
+    const Tile* GetImpactTile( int tileX, int tileY ) const; // nullptr past the edge of the map, which rays treat as wall
+    const RayQuery MakeLineOfSightQuery( const Entity* source, const Entity* destination ) const;
+    void RaycastFourLanes( const RayQuery* queries, RaycastResult* out_results ) const;
 
     void UpdateFromController( float deltaSeconds );
+    void UpdateFlowFields();
+    void StorePreviousTransforms();
+    void UpdateRaycasts();
+    void UpdateEntities( float deltaSeconds );
+    void StoreTickStates();
+    void ApplyCommandBuffer( const MapCommandBuffer& commands );
+    static void UpdateEntitiesJob( void* userData, int jobIndex );
     void UpdateCollision();
     void CollectGarbage();
+    void QueueStructuralCommand( const MapCommand& command );
+    void ApplyStructuralChanges(); // Destroys garbage, then transfers, then spawns by type
+    void SpawnEntityNow( const MapCommand& command );
+    void TransferPlayersNow( Map* newMap );
+    Entity* AllocateEntity( EntityType type, int playerID = -1 ); // Bullets come from the pool
     void DestroyEntity( Entity& entity );
+    void ReleaseEntity( Entity& entity ); // Already out of the registry
+    bool CheckSnapshot( const ByteBuffer& buffer ); // Reads the whole snapshot without changing the map
+    bool RestoreSnapshotEntity( BufferReader& reader );
+    Entity* TakeSnapshotSpare( EntityType type, int playerID );
+
+    double EndPhase( MapUpdatePhase phase, double phaseStartSeconds );
 };
\ No newline at end of file
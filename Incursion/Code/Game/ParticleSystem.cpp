@@ -0,0 +1,181 @@
+#include "Game/ParticleSystem.hpp"
+
+#include "Engine/Core/BufferUtils.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Renderer/RenderContext.hpp"
+#include "Engine/Renderer/SpriteAnimDef.hpp"
+#include "Engine/Renderer/SpriteDef.hpp"
+#include "Engine/Renderer/SpriteSheet.hpp"
+
+
+void ParticleSystem::Startup() {
+    m_texture = g_theRenderer->CreateOrGetTextureFromFile( TEXTURE_EXPLOSION );
+    m_spriteSheet = new SpriteSheet( m_texture, IntVec2( 5, 5 ) );
+    m_anim = new SpriteAnimDef( *m_spriteSheet, 0, 24, 1.f, SPRITE_ANIM_PLAYBACK_ONCE );
+
+    m_positions.reserve( PARTICLES_INITIAL_CAPACITY );
+    m_scales.reserve( PARTICLES_INITIAL_CAPACITY );
+    m_ages.reserve( PARTICLES_INITIAL_CAPACITY );
+    m_durations.reserve( PARTICLES_INITIAL_CAPACITY );
+    m_verts.reserve( PARTICLES_INITIAL_CAPACITY * 6 );
+}
+
+
+void ParticleSystem::Shutdown() {
+    delete m_anim;
+    m_anim = nullptr;
+
+    delete m_spriteSheet;
+    m_spriteSheet = nullptr;
+
+    m_positions.clear();
+    m_scales.clear();
+    m_ages.clear();
+    m_durations.clear();
+    m_verts.clear();
+}
+
+
+void ParticleSystem::Update( float deltaSeconds ) {
+    int numParticles = (int)m_ages.size();
+    int particleIndex = 0;
+
+    while( particleIndex < numParticles ) {
+        float age = m_ages[particleIndex] + deltaSeconds;
+
+        if( age < m_durations[particleIndex] ) {
+            m_ages[particleIndex] = age;
+            particleIndex++;
+            continue;
+        }
+
+        // Finished, move the last particle into this spot and look at it next
+        numParticles--;
+        m_positions[particleIndex] = m_positions[numParticles];
+        m_scales[particleIndex] = m_scales[numParticles];
+        m_ages[particleIndex] = m_ages[numParticles];
+        m_durations[particleIndex] = m_durations[numParticles];
+    }
+
+    m_positions.resize( numParticles );
+    m_scales.resize( numParticles );
+    m_ages.resize( numParticles );
+    m_durations.resize( numParticles );
+
+    UpdateVerts();
+}
+
+
+void ParticleSystem::Render() const {
+    if( m_verts.empty() ) {
+        return;
+    }
+
+    g_theRenderer->BindTexture( m_texture );
+    g_theRenderer->DrawVertexArray( (int)m_verts.size(), m_verts.data(), DRAW_MODE_ADDITIVE );
+}
+
+
+void ParticleSystem::SpawnParticle( const Vec2& position, float scale, float duration ) {
+    m_positions.push_back( position );
+    m_scales.push_back( scale );
+    m_ages.push_back( 0.f );
+    m_durations.push_back( duration );
+
+    int numParticles = GetNumParticles();
+    if( numParticles > m_highWaterMark ) {
+        m_highWaterMark = numParticles;
+    }
+}
+
+
+int ParticleSystem::GetNumParticles() const {
+    return (int)m_ages.size();
+}
+
+
+int ParticleSystem::GetHighWaterMark() const {
+    return m_highWaterMark;
+}
+
+
+void ParticleSystem::WriteSnapshot( BufferWriter& writer ) const {
+    int numParticles = GetNumParticles();
+    writer.WriteInt32( numParticles );
+
+    for( int particleIndex = 0; particleIndex < numParticles; particleIndex++ ) {
+        writer.WriteFloat( m_positions[particleIndex].x );
+        writer.WriteFloat( m_positions[particleIndex].y );
+        writer.WriteFloat( m_scales[particleIndex] );
+        writer.WriteFloat( m_ages[particleIndex] );
+        writer.WriteFloat( m_durations[particleIndex] );
+    }
+}
+
+
+void ParticleSystem::ReadSnapshot( BufferReader& reader ) {
+    int numParticles = reader.ReadInt32();
+
+    m_positions.resize( numParticles );
+    m_scales.resize( numParticles );
+    m_ages.resize( numParticles );
+    m_durations.resize( numParticles );
+
+    for( int particleIndex = 0; particleIndex < numParticles; particleIndex++ ) {
+        m_positions[particleIndex].x = reader.ReadFloat();
+        m_positions[particleIndex].y = reader.ReadFloat();
+        m_scales[particleIndex] = reader.ReadFloat();
+        m_ages[particleIndex] = reader.ReadFloat();
+        m_durations[particleIndex] = reader.ReadFloat();
+    }
+
+    if( numParticles > m_highWaterMark ) {
+        m_highWaterMark = numParticles;
+    }
+
+    UpdateVerts();
+}
+
+
+bool ParticleSystem::SkipSnapshot( BufferReader& reader ) {
+    int numParticles = reader.ReadInt32();
+    if( !reader.CanRead( numParticles, 5 * sizeof( float ) ) ) { // Position, scale, age and duration
+        return false;
+    }
+
+    reader.SkipBytes( numParticles * 5 * sizeof( float ) );
+    return !reader.HasOverrun();
+}
+
+
+void ParticleSystem::UpdateVerts() {
+    int numParticles = GetNumParticles();
+    m_verts.resize( numParticles * 6 );
+
+    for( int particleIndex = 0; particleIndex < numParticles; particleIndex++ ) {
+        const SpriteDef& sprite = m_anim->GetSpriteDefAtTime( m_ages[particleIndex] / m_durations[particleIndex] );
+
+        Vec2 uvMins;
+        Vec2 uvMaxs;
+        sprite.GetUVs( uvMins, uvMaxs );
+        Vec2 uvTL = Vec2( uvMins.x, uvMaxs.y );
+        Vec2 uvBR = Vec2( uvMaxs.x, uvMins.y );
+
+        const Vec2& position = m_positions[particleIndex];
+        float halfSize = 0.5f * m_scales[particleIndex];
+        float minX = position.x - halfSize;
+        float minY = position.y - halfSize;
+        float maxX = position.x + halfSize;
+        float maxY = position.y + halfSize;
+
+        // Same layout as AddVertsForAABB2D
+        Vertex_PCU* particleVerts = &m_verts[particleIndex * 6];
+        particleVerts[0] = Vertex_PCU( Vec3( minX, minY, 0.f ), Rgba::WHITE, uvMins );
+        particleVerts[1] = Vertex_PCU( Vec3( minX, maxY, 0.f ), Rgba::WHITE, uvTL );
+        particleVerts[2] = Vertex_PCU( Vec3( maxX, minY, 0.f ), Rgba::WHITE, uvBR );
+
+        particleVerts[3] = Vertex_PCU( Vec3( minX, maxY, 0.f ), Rgba::WHITE, uvTL );
+        particleVerts[4] = Vertex_PCU( Vec3( maxX, minY, 0.f ), Rgba::WHITE, uvBR );
+        particleVerts[5] = Vertex_PCU( Vec3( maxX, maxY, 0.f ), Rgba::WHITE, uvMaxs );
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Math/Vec2.hpp"
+
+#include "Game/GameCommon.hpp"
+
+#include "vector"
+
+
+class BufferReader;
+class BufferWriter;
+class SpriteAnimDef;
+class SpriteSheet;
+class Texture;
+
+// Explosion particles for one Map, stored as structure of arrays
+// Every particle shares one sprite sheet and animation, the whole system draws as a single additive batch
+class ParticleSystem {
+    public:
+    ParticleSystem() {};
+    ~ParticleSystem() {};
+
+    void Startup();
+    void Shutdown();
+
+    void Update( float deltaSeconds );
+    void Render() const;
+
+    void SpawnParticle( const Vec2& position, float scale, float duration );
+
+    int GetNumParticles() const;
+    int GetHighWaterMark() const;
+
+    void WriteSnapshot( BufferWriter& writer ) const;
+    void ReadSnapshot( BufferReader& reader ); // Only for bytes SkipSnapshot accepted
+    static bool SkipSnapshot( BufferReader& reader ); // Same checks as a restore needs, without changing anything
+
+    private:
+    const Texture* m_texture = nullptr;
+    SpriteSheet* m_spriteSheet = nullptr;
+    SpriteAnimDef* m_anim = nullptr; // Authored over one second, particles sample it at age / duration
+
+    // One entry per live particle, finished particles are swapped out with the last one
+    std::vector<Vec2> m_positions;
+    std::vector<float> m_scales;
+    std::vector<float> m_ages;
+    std::vector<float> m_durations;
+    int m_highWaterMark = 0;
+
+    std::vector<Vertex_PCU> m_verts; // Six per particle, rewritten in place every Update
+
+    void UpdateVerts();
+};
@@ -0,0 +1,363 @@
+#include "Game/PathRequestService.hpp"
+
+#include "Engine/Core/BufferUtils.hpp"
+#include "Engine/Core/JobSystem.hpp"
+
+#include "Game/Map.hpp"
+#include "Game/StateHash.hpp"
+
+#include "algorithm"
+
+
+static constexpr int SEARCH_INDEX_WAITING = -1;
+static constexpr int SEARCH_INDEX_CACHED = -2;
+
+
+int PathResult::GetNumStoredWaypoints() const {
+    return (numWaypoints < PATH_RESULT_MAX_WAYPOINTS) ? numWaypoints : PATH_RESULT_MAX_WAYPOINTS;
+}
+
+
+float PathRequestStats::GetCacheHitRate() const {
+    int numLookups = numCacheHits + numSearches;
+    return (numLookups > 0) ? (float)numCacheHits / (float)numLookups : 0.f;
+}
+
+
+float PathRequestStats::GetAverageLatencyTicks() const {
+    return (numDelivered > 0) ? (float)totalLatencyTicks / (float)numDelivered : 0.f;
+}
+
+
+void PathRequestService::Startup() {
+    m_cachedPaths.reserve( PATH_REQUEST_CACHE_SIZE );
+    m_searches.reserve( PATH_REQUEST_SEARCHES_PER_TICK );
+    m_stats = PathRequestStats();
+}
+
+
+void PathRequestService::Shutdown() {
+    m_pendingRequests.clear();
+    m_pendingIndexByHandleIndex.clear();
+    m_resultsByHandleIndex.clear();
+    m_searches.clear();
+    m_searchIndexByRequest.clear();
+    OnTileChanged();
+}
+
+
+void PathRequestService::Update( const Map& map, int tick ) {
+    int numPending = (int)m_pendingRequests.size();
+    m_searches.clear();
+    m_searchIndexByRequest.assign( numPending, SEARCH_INDEX_WAITING );
+
+    // Cache hits go out right away, the first new pairs in queue order get searched
+    for( int requestIndex = 0; requestIndex < numPending; requestIndex++ ) {
+        const PathRequest& request = m_pendingRequests[requestIndex];
+        const CachedPath* cachedPath = FindCachedPath( request.startTileIndex, request.goalTileIndex );
+
+        if( cachedPath != nullptr ) {
+            Deliver( request, *cachedPath, tick );
+            m_searchIndexByRequest[requestIndex] = SEARCH_INDEX_CACHED;
+            m_stats.numCacheHits++;
+            continue;
+        }
+
+        int numSearches = (int)m_searches.size();
+        for( int searchIndex = 0; searchIndex < numSearches; searchIndex++ ) {
+            const CachedPath& search = m_searches[searchIndex];
+
+            if( search.startTileIndex == request.startTileIndex && search.goalTileIndex == request.goalTileIndex ) {
+                m_searchIndexByRequest[requestIndex] = searchIndex;
+                m_stats.numDeduplicated++;
+                break;
+            }
+        }
+
+        if( m_searchIndexByRequest[requestIndex] == SEARCH_INDEX_WAITING && numSearches < PATH_REQUEST_SEARCHES_PER_TICK ) {
+            CachedPath search;
+            search.startTileIndex = request.startTileIndex;
+            search.goalTileIndex = request.goalTileIndex;
+            m_searchIndexByRequest[requestIndex] = numSearches;
+            m_searches.push_back( search );
+        }
+    }
+
+    // Each search only writes its own entry, so the results don't depend on the thread count
+    int numSearches = (int)m_searches.size();
+    m_searchMap = &map;
+    g_theJobSystem->ParallelFor( numSearches, &PathRequestService::SearchJob, this );
+    m_searchMap = nullptr;
+    m_stats.numSearches += numSearches;
+
+    for( int searchIndex = 0; searchIndex < numSearches; searchIndex++ ) {
+        AddCachedPath( m_searches[searchIndex] );
+    }
+
+    // Deliver the searched requests and keep the rest in order for the next tick
+    int numWaiting = 0;
+
+    for( int requestIndex = 0; requestIndex < numPending; requestIndex++ ) {
+        const PathRequest& request = m_pendingRequests[requestIndex];
+        int searchIndex = m_searchIndexByRequest[requestIndex];
+
+        if( searchIndex >= 0 ) {
+            Deliver( request, m_searches[searchIndex], tick );
+        } else if( searchIndex == SEARCH_INDEX_WAITING ) {
+            m_pendingRequests[numWaiting] = request;
+            numWaiting++;
+        }
+    }
+
+    m_pendingRequests.resize( numWaiting );
+    RebuildPendingIndices();
+}
+
+
+void PathRequestService::SubmitRequest( const EntityHandle& requester, int startTileIndex, int goalTileIndex, int tick ) {
+    m_stats.numSubmitted++;
+
+    if( requester.index >= (int)m_pendingIndexByHandleIndex.size() ) {
+        m_pendingIndexByHandleIndex.resize( requester.index + 1, -1 );
+    }
+
+    int pendingIndex = m_pendingIndexByHandleIndex[requester.index];
+
+    if( pendingIndex >= 0 ) {
+        // Still waiting, the new request takes over the old one's place in the queue
+        PathRequest& request = m_pendingRequests[pendingIndex];
+
+        if( request.requester == requester && request.startTileIndex == startTileIndex && request.goalTileIndex == goalTileIndex ) {
+            m_stats.numDeduplicated++;
+            return;
+        }
+
+        if( request.requester != requester ) {
+            request.requester = requester; // Slot reused by a new entity
+            request.submitTick = tick;
+        }
+
+        request.startTileIndex = startTileIndex;
+        request.goalTileIndex = goalTileIndex;
+        return;
+    }
+
+    PathRequest request;
+    request.requester = requester;
+    request.startTileIndex = startTileIndex;
+    request.goalTileIndex = goalTileIndex;
+    request.submitTick = tick;
+
+    m_pendingIndexByHandleIndex[requester.index] = (int)m_pendingRequests.size();
+    m_pendingRequests.push_back( request );
+
+    m_stats.numPending = (int)m_pendingRequests.size();
+    if( m_stats.numPending > m_stats.peakPending ) {
+        m_stats.peakPending = m_stats.numPending;
+    }
+}
+
+
+void PathRequestService::OnTileChanged() {
+    m_cachedPaths.clear();
+    m_cachedPathIndexByKey.clear();
+    m_nextCachedPathIndex = 0;
+}
+
+
+const PathResult* PathRequestService::GetResult( const EntityHandle& requester ) const {
+    if( requester.index < 0 || requester.index >= (int)m_resultsByHandleIndex.size() ) {
+        return nullptr;
+    }
+
+    const PathResult& result = m_resultsByHandleIndex[requester.index];
+    return (result.requester == requester) ? &result : nullptr;
+}
+
+
+const PathRequestStats& PathRequestService::GetStats() const {
+    return m_stats;
+}
+
+
+void PathRequestService::AddToStateHash( StateHash& hash ) const {
+    hash.AddInt( (int)m_pendingRequests.size() );
+    hash.AddBytes( m_pendingRequests.data(), m_pendingRequests.size() * sizeof( PathRequest ) );
+    hash.AddInt( (int)m_resultsByHandleIndex.size() );
+    hash.AddBytes( m_resultsByHandleIndex.data(), m_resultsByHandleIndex.size() * sizeof( PathResult ) );
+
+    // The cache decides which requests wait, so it's part of the state too
+    hash.AddInt( (int)m_cachedPaths.size() );
+    hash.AddBytes( m_cachedPaths.data(), m_cachedPaths.size() * sizeof( CachedPath ) );
+    hash.AddInt( m_nextCachedPathIndex );
+}
+
+
+void PathRequestService::WriteSnapshot( BufferWriter& writer ) const {
+    writer.WriteInt32( (int)m_pendingRequests.size() );
+    writer.WriteBytes( m_pendingRequests.data(), m_pendingRequests.size() * sizeof( PathRequest ) );
+    writer.WriteInt32( (int)m_resultsByHandleIndex.size() );
+    writer.WriteBytes( m_resultsByHandleIndex.data(), m_resultsByHandleIndex.size() * sizeof( PathResult ) );
+    writer.WriteInt32( (int)m_cachedPaths.size() );
+    writer.WriteBytes( m_cachedPaths.data(), m_cachedPaths.size() * sizeof( CachedPath ) );
+    writer.WriteInt32( m_nextCachedPathIndex );
+}
+
+
+void PathRequestService::ReadSnapshot( BufferReader& reader ) {
+    int numPending = reader.ReadInt32();
+    m_pendingRequests.resize( numPending );
+    reader.ReadBytes( m_pendingRequests.data(), numPending * sizeof( PathRequest ) );
+
+    int numResults = reader.ReadInt32();
+    m_resultsByHandleIndex.resize( numResults );
+    reader.ReadBytes( m_resultsByHandleIndex.data(), numResults * sizeof( PathResult ) );
+
+    int numCachedPaths = reader.ReadInt32();
+    m_cachedPaths.resize( numCachedPaths );
+    reader.ReadBytes( m_cachedPaths.data(), numCachedPaths * sizeof( CachedPath ) );
+    m_nextCachedPathIndex = reader.ReadInt32();
+
+    m_cachedPathIndexByKey.clear();
+    for( int pathIndex = 0; pathIndex < numCachedPaths; pathIndex++ ) {
+        const CachedPath& path = m_cachedPaths[pathIndex];
+        m_cachedPathIndexByKey[GetKey( path.startTileIndex, path.goalTileIndex )] = pathIndex;
+    }
+
+    RebuildPendingIndices();
+}
+
+
+bool PathRequestService::SkipSnapshot( BufferReader& reader, int numEntitySlots ) {
+    int numPending = reader.ReadInt32();
+    if( !reader.CanRead( numPending, sizeof( PathRequest ) ) ) {
+        return false;
+    }
+
+    for( int requestIndex = 0; requestIndex < numPending; requestIndex++ ) {
+        PathRequest request;
+        reader.ReadBytes( &request, sizeof( PathRequest ) );
+
+        if( request.requester.index < 0 || request.requester.index >= numEntitySlots ) {
+            return false;
+        }
+    }
+
+    int numResults = reader.ReadInt32();
+    if( !reader.CanRead( numResults, sizeof( PathResult ) ) ) {
+        return false;
+    }
+
+    reader.SkipBytes( numResults * sizeof( PathResult ) );
+
+    int numCachedPaths = reader.ReadInt32();
+    if( numCachedPaths > PATH_REQUEST_CACHE_SIZE || !reader.CanRead( numCachedPaths, sizeof( CachedPath ) ) ) {
+        return false;
+    }
+
+    reader.SkipBytes( numCachedPaths * sizeof( CachedPath ) );
+    int nextCachedPathIndex = reader.ReadInt32();
+
+    if( nextCachedPathIndex < 0 || nextCachedPathIndex >= PATH_REQUEST_CACHE_SIZE ) {
+        return false;
+    }
+
+    return !reader.HasOverrun();
+}
+
+
+unsigned long long PathRequestService::GetKey( int startTileIndex, int goalTileIndex ) {
+    return ((unsigned long long)(unsigned int)startTileIndex << 32) | (unsigned long long)(unsigned int)goalTileIndex;
+}
+
+
+void PathRequestService::SearchJob( void* userData, int jobIndex ) {
+    PathRequestService* service = (PathRequestService*)userData;
+    const Map& map = *service->m_searchMap;
+    CachedPath& search = service->m_searches[jobIndex];
+
+    // Unused waypoints are zeroed, they end up in the snapshot and state hash
+    for( int waypointIndex = 0; waypointIndex < PATH_RESULT_MAX_WAYPOINTS; waypointIndex++ ) {
+        search.waypoints[waypointIndex] = IntVec2( 0, 0 );
+    }
+
+    IntVec2 startTileCoords = map.GetTileCoordsFromTileIndex( search.startTileIndex );
+    IntVec2 goalTileCoords = map.GetTileCoordsFromTileIndex( search.goalTileIndex );
+    search.numWaypoints = map.FindPath( startTileCoords, goalTileCoords, search.waypoints, PATH_RESULT_MAX_WAYPOINTS );
+}
+
+
+const PathRequestService::CachedPath* PathRequestService::FindCachedPath( int startTileIndex, int goalTileIndex ) const {
+    std::map<unsigned long long, int>::const_iterator pathIter = m_cachedPathIndexByKey.find( GetKey( startTileIndex, goalTileIndex ) );
+
+    if( pathIter == m_cachedPathIndexByKey.end() ) {
+        return nullptr;
+    }
+
+    return &m_cachedPaths[pathIter->second];
+}
+
+
+void PathRequestService::AddCachedPath( const CachedPath& path ) {
+    if( (int)m_cachedPaths.size() < PATH_REQUEST_CACHE_SIZE ) {
+        m_cachedPaths.push_back( path );
+    } else {
+        const CachedPath& oldestPath = m_cachedPaths[m_nextCachedPathIndex];
+        m_cachedPathIndexByKey.erase( GetKey( oldestPath.startTileIndex, oldestPath.goalTileIndex ) );
+        m_cachedPaths[m_nextCachedPathIndex] = path;
+    }
+
+    m_cachedPathIndexByKey[GetKey( path.startTileIndex, path.goalTileIndex )] = m_nextCachedPathIndex;
+    m_nextCachedPathIndex = (m_nextCachedPathIndex + 1) % PATH_REQUEST_CACHE_SIZE;
+}
+
+
+void PathRequestService::Deliver( const PathRequest& request, const CachedPath& path, int tick ) {
+    if( request.requester.index >= (int)m_resultsByHandleIndex.size() ) {
+        // Zeroed, empty slots end up in the snapshot and state hash too
+        PathResult emptyResult;
+        for( int waypointIndex = 0; waypointIndex < PATH_RESULT_MAX_WAYPOINTS; waypointIndex++ ) {
+            emptyResult.waypoints[waypointIndex] = IntVec2( 0, 0 );
+        }
+
+        m_resultsByHandleIndex.resize( request.requester.index + 1, emptyResult );
+    }
+
+    PathResult& result = m_resultsByHandleIndex[request.requester.index];
+    result.requester = request.requester;
+    result.startTileIndex = path.startTileIndex;
+    result.goalTileIndex = path.goalTileIndex;
+    result.numWaypoints = path.numWaypoints;
+    result.deliveredTick = tick;
+
+    for( int waypointIndex = 0; waypointIndex < PATH_RESULT_MAX_WAYPOINTS; waypointIndex++ ) {
+        result.waypoints[waypointIndex] = path.waypoints[waypointIndex];
+    }
+
+    // Readable from the next tick's entity update
+    int latencyTicks = (tick + 1) - request.submitTick;
+    m_stats.numDelivered++;
+    m_stats.totalLatencyTicks += latencyTicks;
+
+    if( latencyTicks > m_stats.maxLatencyTicks ) {
+        m_stats.maxLatencyTicks = latencyTicks;
+    }
+}
+
+
+void PathRequestService::RebuildPendingIndices() {
+    std::fill( m_pendingIndexByHandleIndex.begin(), m_pendingIndexByHandleIndex.end(), -1 );
+    int numPending = (int)m_pendingRequests.size();
+
+    for( int requestIndex = 0; requestIndex < numPending; requestIndex++ ) {
+        int handleIndex = m_pendingRequests[requestIndex].requester.index;
+
+        if( handleIndex >= (int)m_pendingIndexByHandleIndex.size() ) {
+            m_pendingIndexByHandleIndex.resize( handleIndex + 1, -1 );
+        }
+
+        m_pendingIndexByHandleIndex[handleIndex] = requestIndex;
+    }
+
+    m_stats.numPending = numPending;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+
+#include "Game/GameCommon.hpp"
+#include "Game/EntityHandle.hpp"
+
+#include "map"
+#include "vector"
+
+
+class BufferReader;
+class BufferWriter;
+class Map;
+class StateHash;
+
+struct PathRequest {
+    public:
+    EntityHandle requester;
+    int startTileIndex = -1;
+    int goalTileIndex = -1;
+    int submitTick = 0;
+};
+
+// Latest path delivered to one requester, only the first PATH_RESULT_MAX_WAYPOINTS waypoints are kept
+struct PathResult {
+    public:
+    EntityHandle requester;
+    int startTileIndex = -1;
+    int goalTileIndex = -1;
+    int numWaypoints = 0; // Whole path, start and goal included, 0 if the goal can't be walked to
+    IntVec2 waypoints[PATH_RESULT_MAX_WAYPOINTS];
+    int deliveredTick = 0;
+
+    int GetNumStoredWaypoints() const;
+};
+
+struct PathRequestStats {
+    public:
+    int numPending = 0;
+    int peakPending = 0;
+    int numSubmitted = 0;
+    int numDeduplicated = 0; // Resubmitted while still pending, or sharing a search with an identical request
+    int numSearches = 0;
+    int numCacheHits = 0;
+    int numDelivered = 0;
+    int totalLatencyTicks = 0; // From the tick a request was submitted to the tick its requester can read it
+    int maxLatencyTicks = 0;
+
+    float GetCacheHitRate() const; // Of the deliveries that didn't share a search this tick
+    float GetAverageLatencyTicks() const;
+};
+
+// Paths for one Map, requested by entity handle during the entity update and delivered on a later tick
+// Requests are deduplicated per requester and by (start tile, goal tile), answered from a cache of recent paths
+//  when possible, and otherwise searched on the job system, at most PATH_REQUEST_SEARCHES_PER_TICK per tick in queue order
+// The budget counts searches rather than milliseconds, so when a path arrives never depends on the machine
+class PathRequestService {
+    public:
+    PathRequestService() {};
+    ~PathRequestService() {};
+
+    void Startup();
+    void Shutdown();
+
+    void Update( const Map& map, int tick ); // Solves and delivers what the budget allows, results are readable next tick
+    void SubmitRequest( const EntityHandle& requester, int startTileIndex, int goalTileIndex, int tick ); // Replaces the requester's pending request
+    void OnTileChanged(); // Every cached path may now be wrong
+
+    const PathResult* GetResult( const EntityHandle& requester ) const; // nullptr until a path was delivered to this handle
+    const PathRequestStats& GetStats() const;
+
+    void AddToStateHash( StateHash& hash ) const;
+    void WriteSnapshot( BufferWriter& writer ) const;
+    void ReadSnapshot( BufferReader& reader ); // Only for bytes SkipSnapshot accepted
+    static bool SkipSnapshot( BufferReader& reader, int numEntitySlots ); // Same checks as a restore needs, without changing anything
+
+    private:
+    // Ints only, so the snapshot and state hash never see padding
+    struct CachedPath {
+        int startTileIndex = -1;
+        int goalTileIndex = -1;
+        int numWaypoints = 0;
+        IntVec2 waypoints[PATH_RESULT_MAX_WAYPOINTS];
+    };
+
+    std::vector<PathRequest> m_pendingRequests; // Oldest first
+    std::vector<int> m_pendingIndexByHandleIndex; // -1 if that handle slot has nothing pending
+    std::vector<PathResult> m_resultsByHandleIndex;
+
+    // Recent paths in a ring, oldest overwritten first
+    std::vector<CachedPath> m_cachedPaths;
+    std::map<unsigned long long, int> m_cachedPathIndexByKey;
+    int m_nextCachedPathIndex = 0;
+
+    const Map* m_searchMap = nullptr;
+    std::vector<CachedPath> m_searches; // This tick's, one job each
+    std::vector<int> m_searchIndexByRequest; // Per pending request, -1 if it waits for a later tick, -2 if the cache answered it
+    PathRequestStats m_stats;
+
+    static unsigned long long GetKey( int startTileIndex, int goalTileIndex );
+    static void SearchJob( void* userData, int jobIndex );
+
+    const CachedPath* FindCachedPath( int startTileIndex, int goalTileIndex ) const;
+    void AddCachedPath( const CachedPath& path );
+    void Deliver( const PathRequest& request, const CachedPath& path, int tick );
+    void RebuildPendingIndices();
+};
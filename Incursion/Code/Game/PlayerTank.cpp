@@ -1,12 +1,15 @@
 #include "Game/PlayerTank.hpp"
 
+#include "Engine/Core/BufferUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Matrix44.hpp"
 #include "Engine/Renderer/RenderContext.hpp"
 
 #include "Game/Game.hpp"
 #include "Game/Map.hpp"
+#include "Game/StateHash.hpp"
 
 PlayerTank::PlayerTank( Map* map, int playerID ) :
     Entity( ENTITY_TYPE_PLAYERTANK, (map->IsArenaMode() ? (FactionID)playerID : (FactionID)0) ),
@@ -51,7 +54,7 @@ void PlayerTank::Startup() {
         life->StartupExtraLife( lifeIndex );
     }
 
-    UpdateTankVerts();
+    m_areVertsDirty = true;
 }
 
 
@@ -77,6 +80,14 @@ void PlayerTank::StartupExtraLife( int lifeIndex ) {
 void PlayerTank::Shutdown() {
     m_tankBaseVerts.clear();
     m_tankTopVerts.clear();
+
+    for( int lifeIndex = 0; lifeIndex < PLAYERTANK_EXTRA_LIVES; lifeIndex++ ) {
+        if( m_extraLives[lifeIndex] != nullptr ) {
+            m_extraLives[lifeIndex]->Shutdown();
+            delete m_extraLives[lifeIndex];
+            m_extraLives[lifeIndex] = nullptr;
+        }
+    }
 }
 
 
@@ -120,18 +131,17 @@ void PlayerTank::Update( float deltaSeconds ) {
         thrustSpeed = PLAYERTANK_MAX_SPEED * m_thrustFraction * deltaSeconds;
     }
 
-    float tileMovementModifier = m_map->GetTileFromWorldCoords( m_position ).GetMovementModifier();
+    float tileMovementModifier = m_map->GetMovementModifierAtWorldCoords( m_position );
 
     m_position += thrustSpeed * tileMovementModifier * GetForwardVector();
 
     maxDeltaDegrees = PLAYERTANK_TOP_TURN_SPEED * deltaSeconds;
     m_orientationTopDegrees = GetTurnedTowards( m_orientationTopDegrees, m_desiredOrientationTopDegrees, maxDeltaDegrees );
 
-    UpdateTankVerts();
+    m_areVertsDirty = true;
 
     // Check for Exit Tile
-    const Tile currentTile = m_map->GetTileFromWorldCoords( m_position );
-    if( currentTile.GetTileType() == TILE_TYPE_EXIT ) {
+    if( m_map->GetTileTypeAtWorldCoords( m_position ) == TILE_TYPE_EXIT ) {
         if( m_map->IsArenaMode() && !m_map->IsOnlyOnePlayerAlive() ) {
             return;
         }
@@ -156,19 +166,16 @@ void PlayerTank::UpdateExtraLife( float deltaSeconds ) {
 
     m_position = Vec2( positionX, positionY );
 
-    UpdateTankVerts();
+    m_areVertsDirty = true;
 }
 
 
 void PlayerTank::Render() const {
-    // Render Extra Lives (even when dead)
-    for( int lifeIndex = 0; lifeIndex < PLAYERTANK_EXTRA_LIVES; lifeIndex++ ) {
-        if( m_extraLives[lifeIndex] != nullptr ) {
-            m_extraLives[lifeIndex]->Render();
+    if( !m_isDead ) {
+        if( m_areVertsDirty ) {
+            UpdateTankVerts();
         }
-    }
 
-    if( !m_isDead ) {
         if( g_theGame->IsDebugDrawingOn() ) {
             g_theRenderer->BindTexture( nullptr );
             g_theRenderer->DrawVertexArray( m_debugCosmeticVerts );
@@ -202,6 +209,30 @@ bool PlayerTank::HandleKeyPressed( unsigned char keyCode ) {
 */
 
 
+void PlayerTank::RenderExtraLives( float tickAlpha ) const {
+    // Rendered even when dead, follows the interpolated camera so they stay fixed on screen
+    for( int lifeIndex = 0; lifeIndex < PLAYERTANK_EXTRA_LIVES; lifeIndex++ ) {
+        const PlayerTank* extraLife = m_extraLives[lifeIndex];
+
+        if( extraLife != nullptr ) {
+            g_theRenderer->SetModelMatrix( extraLife->GetInterpolationTransform( tickAlpha ) );
+            extraLife->Render();
+        }
+    }
+}
+
+
+void PlayerTank::StorePreviousTransform() {
+    Entity::StorePreviousTransform();
+
+    for( int lifeIndex = 0; lifeIndex < PLAYERTANK_EXTRA_LIVES; lifeIndex++ ) {
+        if( m_extraLives[lifeIndex] != nullptr ) {
+            m_extraLives[lifeIndex]->StorePreviousTransform();
+        }
+    }
+}
+
+
 int PlayerTank::GetPlayerID() const {
     return m_playerID;
 }
@@ -233,14 +264,83 @@ void PlayerTank::OnCollisionEntity( Entity* collidingEntity ) {
 }
 
 
-void PlayerTank::OnCollisionTile( Tile* collidingTile ) {
-    if( collidingTile->IsSolid() && m_isSolid ) {
-        PushDiscOutOfAABB2( m_position, m_physicsRadius, collidingTile->GetBounds() );
-        UpdateTankVerts();
+void PlayerTank::OnCollisionTile( const AABB2& tileBounds ) {
+    if( m_isSolid ) {
+        PushDiscOutOfAABB2( m_position, m_physicsRadius, tileBounds );
+        m_areVertsDirty = true;
+    }
+}
+
+
+void PlayerTank::AddToStateHash( StateHash& hash ) const {
+    Entity::AddToStateHash( hash );
+
+    hash.AddBool( m_isThrusting );
+    hash.AddFloat( m_thrustFraction );
+    hash.AddFloat( m_desiredOrientationBaseDegrees );
+    hash.AddFloat( m_desiredOrientationTopDegrees );
+    hash.AddFloat( m_orientationTopDegrees );
+    hash.AddFloat( m_deathCountdown );
+    hash.AddFloat( m_gunCooldown );
+    hash.AddInt( m_extraLifeIndex );
+
+    for( int lifeIndex = 0; lifeIndex < PLAYERTANK_EXTRA_LIVES; lifeIndex++ ) {
+        hash.AddBool( m_extraLives[lifeIndex] != nullptr );
     }
 }
 
 
+void PlayerTank::WriteSnapshot( BufferWriter& writer ) const {
+    Entity::WriteSnapshot( writer );
+
+    writer.WriteBool( m_isThrusting );
+    writer.WriteFloat( m_thrustFraction );
+    writer.WriteFloat( m_desiredOrientationBaseDegrees );
+    writer.WriteFloat( m_desiredOrientationTopDegrees );
+    writer.WriteFloat( m_orientationTopDegrees );
+    writer.WriteFloat( m_deathCountdown );
+    writer.WriteFloat( m_gunCooldown );
+
+    // Extra lives only hold screen positions, which one is left is all that matters
+    for( int lifeIndex = 0; lifeIndex < PLAYERTANK_EXTRA_LIVES; lifeIndex++ ) {
+        writer.WriteBool( m_extraLives[lifeIndex] != nullptr );
+    }
+}
+
+
+void PlayerTank::ReadSnapshot( BufferReader& reader ) {
+    Entity::ReadSnapshot( reader );
+
+    m_isThrusting = reader.ReadBool();
+    m_thrustFraction = reader.ReadFloat();
+    m_desiredOrientationBaseDegrees = reader.ReadFloat();
+    m_desiredOrientationTopDegrees = reader.ReadFloat();
+    m_orientationTopDegrees = reader.ReadFloat();
+    m_deathCountdown = reader.ReadFloat();
+    m_gunCooldown = reader.ReadFloat();
+
+    for( int lifeIndex = 0; lifeIndex < PLAYERTANK_EXTRA_LIVES; lifeIndex++ ) {
+        bool hasLife = reader.ReadBool();
+        PlayerTank*& life = m_extraLives[lifeIndex];
+
+        if( hasLife && life == nullptr ) {
+            life = new PlayerTank( m_map, m_playerID );
+            life->StartupExtraLife( lifeIndex );
+        } else if( !hasLife && life != nullptr ) {
+            life->Shutdown();
+            delete life;
+            life = nullptr;
+        }
+    }
+}
+
+
+int PlayerTank::GetSnapshotNumBytes() {
+    // Thrusting, six floats, one flag per extra life
+    return Entity::GetSnapshotNumBytes() + 1 + (6 * 4) + PLAYERTANK_EXTRA_LIVES;
+}
+
+
 void PlayerTank::SetStartPosition() {
     IntVec2 mapDimensions = m_map->GetDimensions();
     float offsetX = m_map->IsArenaMode() ? mapDimensions.x - 3.f : 1.f;
@@ -252,6 +352,7 @@ void PlayerTank::SetStartPosition() {
 
     m_orientationDegrees = 0;
     m_orientationTopDegrees = 0;
+    ClearPreviousTransform();
 }
 
 
@@ -328,7 +429,7 @@ void PlayerTank::UpdateFromController( float deltaSeconds ) {
 }
 
 
-void PlayerTank::UpdateTankVerts() {
+void PlayerTank::UpdateTankVerts() const {
     m_tankBaseVerts.clear();
     m_tankTopVerts.clear();
 
@@ -343,6 +444,8 @@ void PlayerTank::UpdateTankVerts() {
     if( g_theGame->IsDebugDrawingOn() ) {
         UpdateDebugVerts();
     }
+
+    m_areVertsDirty = false;
 }
 
 
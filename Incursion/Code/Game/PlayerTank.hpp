@@ -20,6 +20,9 @@ class PlayerTank
     void Update( float deltaSeconds );
     void UpdateExtraLife( float deltaSeconds );
     void Render() const;
+    void RenderExtraLives( float tickAlpha ) const; // Drawn by the map on top of all entities
+
+    void StorePreviousTransform() override;
 
     //bool HandleKeyPressed( unsigned char keyCode );
     //bool HandleKeyReleased( unsigned char keyCode );
@@ -28,7 +31,12 @@ class PlayerTank
     bool HasLivesRemaing() const;
 
     void OnCollisionEntity( Entity* collidingEntity );
-    void OnCollisionTile( Tile* collidingTile );
+    void OnCollisionTile( const AABB2& tileBounds );
+
+    void AddToStateHash( StateHash& hash ) const override;
+    void WriteSnapshot( BufferWriter& writer ) const override;
+    void ReadSnapshot( BufferReader& reader ) override;
+    static int GetSnapshotNumBytes();
 
     void SetStartPosition();
     void SetInvincible( bool isInvincible );
@@ -47,8 +55,8 @@ class PlayerTank
     float m_orientationTopDegrees = 0.f;
 
     AABB2 m_tankVertOffsets = AABB2();
-    std::vector<Vertex_PCU> m_tankBaseVerts;
-    std::vector<Vertex_PCU> m_tankTopVerts;
+    mutable std::vector<Vertex_PCU> m_tankBaseVerts;
+    mutable std::vector<Vertex_PCU> m_tankTopVerts;
 
     float m_scale = 1.f;
     float m_deathCountdown = 3.f;
@@ -59,7 +67,7 @@ class PlayerTank
 
     void StartupTexture();
     void UpdateFromController( float deltaSeconds );
-    void UpdateTankVerts();
+    void UpdateTankVerts() const;
 
     const Vec2 GetForwardVectorTop() const;
 
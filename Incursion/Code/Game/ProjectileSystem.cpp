@@ -0,0 +1,350 @@
+#include "Game/ProjectileSystem.hpp"
+
+#include "Engine/Core/BufferUtils.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Renderer/RenderContext.hpp"
+
+#include "Game/Map.hpp"
+#include "Game/StateHash.hpp"
+
+#include "emmintrin.h"
+
+
+// Solid bit of four tiles as lane masks, SSE2 has no gather so they're read one at a time
+static __m128 GetSolidMask4( const unsigned int* tileSolidBits, __m128i tileIndices ) {
+    alignas( 16 ) int indices[4];
+    _mm_store_si128( (__m128i*)indices, tileIndices );
+
+    __m128i solidity = _mm_setr_epi32(
+        (tileSolidBits[indices[0] >> 5] >> (indices[0] & 31)) & 1,
+        (tileSolidBits[indices[1] >> 5] >> (indices[1] & 31)) & 1,
+        (tileSolidBits[indices[2] >> 5] >> (indices[2] & 31)) & 1,
+        (tileSolidBits[indices[3] >> 5] >> (indices[3] & 31)) & 1
+    );
+
+    return _mm_castsi128_ps( _mm_cmpgt_epi32( solidity, _mm_setzero_si128() ) );
+}
+
+
+void ProjectileSystem::Startup() {
+    m_texture = g_theRenderer->CreateOrGetTextureFromFile( TEXTURE_BULLET );
+
+    m_positionsX.reserve( PROJECTILES_INITIAL_CAPACITY );
+    m_positionsY.reserve( PROJECTILES_INITIAL_CAPACITY );
+    m_velocitiesX.reserve( PROJECTILES_INITIAL_CAPACITY );
+    m_velocitiesY.reserve( PROJECTILES_INITIAL_CAPACITY );
+    m_bouncesRemaining.reserve( PROJECTILES_INITIAL_CAPACITY );
+    m_factions.reserve( PROJECTILES_INITIAL_CAPACITY );
+    m_verts.reserve( PROJECTILES_INITIAL_CAPACITY * 6 );
+}
+
+
+void ProjectileSystem::Shutdown() {
+    Clear();
+    m_verts.clear();
+}
+
+
+void ProjectileSystem::Update( float deltaSeconds, Map& map ) {
+    const unsigned int* tileSolidBits = map.GetTileSolidBits().data();
+    const IntVec2& dimensions = map.GetDimensions();
+
+    // Long ticks are split into steps short enough that the tile tests can't skip a wall
+    // Every projectile moves at BULLET_MAX_SPEED, so all lanes share the step count
+    int numSteps = (int)ceilf( (BULLET_MAX_SPEED * deltaSeconds) / PROJECTILES_MAX_STEP_TILES );
+    numSteps = numSteps > 1 ? numSteps : 1;
+    float stepSeconds = deltaSeconds / (float)numSteps;
+
+    // Padding lanes have no velocity, so they never leave their tile or bounce
+    for( int firstIndex = 0; firstIndex < m_numProjectiles; firstIndex += 4 ) {
+        IntegrateFourLanes( firstIndex, stepSeconds, numSteps, tileSolidBits, dimensions );
+    }
+
+    UpdateEntityHits( map );
+    RemoveSpentProjectiles( map );
+    UpdateVerts();
+}
+
+
+void ProjectileSystem::Render() const {
+    if( m_verts.empty() ) {
+        return;
+    }
+
+    g_theRenderer->BindTexture( m_texture );
+    g_theRenderer->DrawVertexArray( (int)m_verts.size(), m_verts.data() );
+}
+
+
+void ProjectileSystem::SpawnProjectile( const Vec2& position, float orientationDegrees, FactionID faction ) {
+    int projectileIndex = m_numProjectiles;
+    Resize( m_numProjectiles + 1 );
+
+    m_positionsX[projectileIndex] = position.x;
+    m_positionsY[projectileIndex] = position.y;
+    m_velocitiesX[projectileIndex] = BULLET_MAX_SPEED * CosDegrees( orientationDegrees );
+    m_velocitiesY[projectileIndex] = BULLET_MAX_SPEED * SinDegrees( orientationDegrees );
+    m_bouncesRemaining[projectileIndex] = BULLET_LIFETIME_BOUNCES;
+    m_factions[projectileIndex] = faction;
+
+    if( m_numProjectiles > m_highWaterMark ) {
+        m_highWaterMark = m_numProjectiles;
+    }
+}
+
+
+void ProjectileSystem::Clear() {
+    m_numProjectiles = 0;
+    m_positionsX.clear();
+    m_positionsY.clear();
+    m_velocitiesX.clear();
+    m_velocitiesY.clear();
+    m_bouncesRemaining.clear();
+    m_factions.clear();
+}
+
+
+int ProjectileSystem::GetNumProjectiles() const {
+    return m_numProjectiles;
+}
+
+
+int ProjectileSystem::GetHighWaterMark() const {
+    return m_highWaterMark;
+}
+
+
+void ProjectileSystem::AddToStateHash( StateHash& hash ) const {
+    hash.AddInt( m_numProjectiles );
+    hash.AddBytes( m_positionsX.data(), m_numProjectiles * sizeof( float ) );
+    hash.AddBytes( m_positionsY.data(), m_numProjectiles * sizeof( float ) );
+    hash.AddBytes( m_velocitiesX.data(), m_numProjectiles * sizeof( float ) );
+    hash.AddBytes( m_velocitiesY.data(), m_numProjectiles * sizeof( float ) );
+    hash.AddBytes( m_bouncesRemaining.data(), m_numProjectiles * sizeof( int ) );
+    hash.AddBytes( m_factions.data(), m_numProjectiles * sizeof( FactionID ) );
+}
+
+
+void ProjectileSystem::WriteSnapshot( BufferWriter& writer ) const {
+    // Arrays are copied in bulk, snapshots only move between little-endian machines
+    writer.WriteInt32( m_numProjectiles );
+    writer.WriteBytes( m_positionsX.data(), m_numProjectiles * sizeof( float ) );
+    writer.WriteBytes( m_positionsY.data(), m_numProjectiles * sizeof( float ) );
+    writer.WriteBytes( m_velocitiesX.data(), m_numProjectiles * sizeof( float ) );
+    writer.WriteBytes( m_velocitiesY.data(), m_numProjectiles * sizeof( float ) );
+    writer.WriteBytes( m_bouncesRemaining.data(), m_numProjectiles * sizeof( int ) );
+    writer.WriteBytes( m_factions.data(), m_numProjectiles * sizeof( FactionID ) );
+}
+
+
+void ProjectileSystem::ReadSnapshot( BufferReader& reader ) {
+    int numProjectiles = reader.ReadInt32();
+
+    Clear();
+    Resize( numProjectiles );
+
+    reader.ReadBytes( m_positionsX.data(), numProjectiles * sizeof( float ) );
+    reader.ReadBytes( m_positionsY.data(), numProjectiles * sizeof( float ) );
+    reader.ReadBytes( m_velocitiesX.data(), numProjectiles * sizeof( float ) );
+    reader.ReadBytes( m_velocitiesY.data(), numProjectiles * sizeof( float ) );
+    reader.ReadBytes( m_bouncesRemaining.data(), numProjectiles * sizeof( int ) );
+    reader.ReadBytes( m_factions.data(), numProjectiles * sizeof( FactionID ) );
+
+    if( numProjectiles > m_highWaterMark ) {
+        m_highWaterMark = numProjectiles;
+    }
+
+    UpdateVerts();
+}
+
+
+bool ProjectileSystem::SkipSnapshot( BufferReader& reader ) {
+    int numProjectiles = reader.ReadInt32();
+    size_t projectileSize = (4 * sizeof( float )) + sizeof( int ) + sizeof( FactionID );
+
+    if( !reader.CanRead( numProjectiles, projectileSize ) ) {
+        return false;
+    }
+
+    reader.SkipBytes( numProjectiles * projectileSize );
+    return !reader.HasOverrun();
+}
+
+
+void ProjectileSystem::Resize( int numProjectiles ) {
+    // New lanes start zeroed, so padding lanes never move
+    int numLanes = (numProjectiles + 3) & ~3;
+    m_positionsX.resize( numLanes, 0.f );
+    m_positionsY.resize( numLanes, 0.f );
+    m_velocitiesX.resize( numLanes, 0.f );
+    m_velocitiesY.resize( numLanes, 0.f );
+    m_bouncesRemaining.resize( numLanes, 0 );
+    m_factions.resize( numLanes, FACTION_UNKNOWN );
+    m_numProjectiles = numProjectiles;
+}
+
+
+void ProjectileSystem::IntegrateFourLanes( int firstIndex, float stepSeconds, int numSteps, const unsigned int* tileSolidBits, const IntVec2& dimensions ) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps( -0.f );
+    const __m128 maxTileX = _mm_set1_ps( (float)(dimensions.x - 1) );
+    const __m128 maxTileY = _mm_set1_ps( (float)(dimensions.y - 1) );
+    const __m128 mapWidth = _mm_set1_ps( (float)dimensions.x );
+    const __m128i one = _mm_set1_epi32( 1 );
+    const __m128 seconds = _mm_set1_ps( stepSeconds );
+
+    __m128 positionX = _mm_loadu_ps( &m_positionsX[firstIndex] );
+    __m128 positionY = _mm_loadu_ps( &m_positionsY[firstIndex] );
+    __m128 velocityX = _mm_loadu_ps( &m_velocitiesX[firstIndex] );
+    __m128 velocityY = _mm_loadu_ps( &m_velocitiesY[firstIndex] );
+    __m128i bouncesRemaining = _mm_loadu_si128( (const __m128i*)&m_bouncesRemaining[firstIndex] );
+
+    for( int stepIndex = 0; stepIndex < numSteps; stepIndex++ ) {
+        // Spent lanes stop where they were spent, that's where they explode
+        __m128 isSpent = _mm_castsi128_ps( _mm_cmplt_epi32( bouncesRemaining, one ) );
+        __m128 moveX = _mm_andnot_ps( isSpent, _mm_mul_ps( velocityX, seconds ) );
+        __m128 moveY = _mm_andnot_ps( isSpent, _mm_mul_ps( velocityY, seconds ) );
+
+        // Tile coordinates clamped to the map, so every lane reads inside the solid bits
+        // Positions are never negative after clamping, so truncating is flooring
+        __m128 oldTileX = _mm_cvtepi32_ps( _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( positionX, zero ), maxTileX ) ) );
+        __m128 oldTileY = _mm_cvtepi32_ps( _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( positionY, zero ), maxTileY ) ) );
+        __m128 newTileX = _mm_cvtepi32_ps( _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( _mm_add_ps( positionX, moveX ), zero ), maxTileX ) ) );
+        __m128 newTileY = _mm_cvtepi32_ps( _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( _mm_add_ps( positionY, moveY ), zero ), maxTileY ) ) );
+
+        // Tile indices in float, exact for any map under 2^24 tiles
+        __m128 oldRowStart = _mm_mul_ps( oldTileY, mapWidth );
+        __m128 newRowStart = _mm_mul_ps( newTileY, mapWidth );
+        __m128 isInWall = GetSolidMask4( tileSolidBits, _mm_cvttps_epi32( _mm_add_ps( oldRowStart, oldTileX ) ) );
+        __m128 isSolidX = GetSolidMask4( tileSolidBits, _mm_cvttps_epi32( _mm_add_ps( oldRowStart, newTileX ) ) );
+        __m128 isSolidY = GetSolidMask4( tileSolidBits, _mm_cvttps_epi32( _mm_add_ps( newRowStart, oldTileX ) ) );
+        __m128 isSolidXY = GetSolidMask4( tileSolidBits, _mm_cvttps_epi32( _mm_add_ps( newRowStart, newTileX ) ) );
+
+        // A step moves under a tile per axis, so the new tile is the old one or a neighbour and no wall is skipped
+        // Entering a wall across one axis flips that axis, diagonally into a lone corner flips both
+        // A bouncing axis stays put this step, like Bullet's original tile check
+        __m128 isCorner = _mm_andnot_ps( _mm_or_ps( isSolidX, isSolidY ), isSolidXY );
+        __m128 didHitX = _mm_andnot_ps( isSpent, _mm_or_ps( isSolidX, isCorner ) );
+        __m128 didHitY = _mm_andnot_ps( isSpent, _mm_or_ps( isSolidY, isCorner ) );
+        __m128 didBounce = _mm_or_ps( didHitX, didHitY );
+
+        positionX = _mm_add_ps( positionX, _mm_andnot_ps( didHitX, moveX ) );
+        positionY = _mm_add_ps( positionY, _mm_andnot_ps( didHitY, moveY ) );
+        velocityX = _mm_xor_ps( velocityX, _mm_and_ps( didHitX, signBit ) );
+        velocityY = _mm_xor_ps( velocityY, _mm_and_ps( didHitY, signBit ) );
+
+        // Each bounce spends one, starting inside a wall spends them all
+        bouncesRemaining = _mm_add_epi32( bouncesRemaining, _mm_castps_si128( didBounce ) );
+        bouncesRemaining = _mm_andnot_si128( _mm_castps_si128( isInWall ), bouncesRemaining );
+    }
+
+    _mm_storeu_ps( &m_positionsX[firstIndex], positionX );
+    _mm_storeu_ps( &m_positionsY[firstIndex], positionY );
+    _mm_storeu_ps( &m_velocitiesX[firstIndex], velocityX );
+    _mm_storeu_ps( &m_velocitiesY[firstIndex], velocityY );
+    _mm_storeu_si128( (__m128i*)&m_bouncesRemaining[firstIndex], bouncesRemaining );
+}
+
+
+void ProjectileSystem::UpdateEntityHits( Map& map ) {
+    // Against the broadphase from this tick's collision pass, most projectiles are in empty cells
+    for( int projectileIndex = 0; projectileIndex < m_numProjectiles; projectileIndex++ ) {
+        if( m_bouncesRemaining[projectileIndex] <= 0 ) {
+            continue;
+        }
+
+        Vec2 position = Vec2( m_positionsX[projectileIndex], m_positionsY[projectileIndex] );
+        Entity* hitEntity = map.GetFirstEntityHitByBullet( position, BULLET_PHYSICS_RADIUS, m_factions[projectileIndex] );
+
+        if( hitEntity == nullptr ) {
+            continue;
+        }
+
+        // Same responses as Bullet::OnCollisionEntity
+        if( hitEntity->IsKillable() ) {
+            hitEntity->TakeDamage( 1 );
+            m_bouncesRemaining[projectileIndex] = 0;
+            continue;
+        }
+
+        Vec2 hitPosition;
+        float hitRadius;
+        hitEntity->GetPhysicsDisc( hitPosition, hitRadius );
+        PushDiscOutOfDisc( position, BULLET_PHYSICS_RADIUS, hitPosition, hitRadius );
+
+        Vec2 normal = hitPosition - position;
+        normal.Normalize();
+        Vec2 velocity = GetReflectedVector( Vec2( m_velocitiesX[projectileIndex], m_velocitiesY[projectileIndex] ), normal );
+
+        m_positionsX[projectileIndex] = position.x;
+        m_positionsY[projectileIndex] = position.y;
+        m_velocitiesX[projectileIndex] = velocity.x;
+        m_velocitiesY[projectileIndex] = velocity.y;
+        m_bouncesRemaining[projectileIndex]--;
+    }
+}
+
+
+void ProjectileSystem::RemoveSpentProjectiles( Map& map ) {
+    int numProjectiles = m_numProjectiles;
+    int projectileIndex = 0;
+
+    while( projectileIndex < numProjectiles ) {
+        if( m_bouncesRemaining[projectileIndex] > 0 ) {
+            projectileIndex++;
+            continue;
+        }
+
+        map.SpawnNewExplosion( Vec2( m_positionsX[projectileIndex], m_positionsY[projectileIndex] ), EXPLOSION_SCALE_SMALL );
+
+        // Spent, move the last projectile into this spot and look at it next
+        numProjectiles--;
+        m_positionsX[projectileIndex] = m_positionsX[numProjectiles];
+        m_positionsY[projectileIndex] = m_positionsY[numProjectiles];
+        m_velocitiesX[projectileIndex] = m_velocitiesX[numProjectiles];
+        m_velocitiesY[projectileIndex] = m_velocitiesY[numProjectiles];
+        m_bouncesRemaining[projectileIndex] = m_bouncesRemaining[numProjectiles];
+        m_factions[projectileIndex] = m_factions[numProjectiles];
+    }
+
+    // Vacated lanes go back to still padding
+    int numLanes = (int)m_positionsX.size();
+    for( int laneIndex = numProjectiles; laneIndex < numLanes; laneIndex++ ) {
+        m_velocitiesX[laneIndex] = 0.f;
+        m_velocitiesY[laneIndex] = 0.f;
+    }
+
+    Resize( numProjectiles );
+}
+
+
+void ProjectileSystem::UpdateVerts() {
+    m_verts.resize( m_numProjectiles * 6 );
+
+    // Speed never changes, so velocity over speed is the forward vector, no trig per projectile
+    float inverseSpeed = 1.f / BULLET_MAX_SPEED;
+    float halfSize = BULLET_COSMETIC_BOX_OFFSET;
+
+    for( int projectileIndex = 0; projectileIndex < m_numProjectiles; projectileIndex++ ) {
+        float positionX = m_positionsX[projectileIndex];
+        float positionY = m_positionsY[projectileIndex];
+        float forwardX = m_velocitiesX[projectileIndex] * inverseSpeed * halfSize;
+        float forwardY = m_velocitiesY[projectileIndex] * inverseSpeed * halfSize;
+
+        // Corners of the rotated box, left is forward turned 90 degrees
+        Vec3 backRight = Vec3( positionX - forwardX + forwardY, positionY - forwardY - forwardX, 0.f );
+        Vec3 backLeft = Vec3( positionX - forwardX - forwardY, positionY - forwardY + forwardX, 0.f );
+        Vec3 frontRight = Vec3( positionX + forwardX + forwardY, positionY + forwardY - forwardX, 0.f );
+        Vec3 frontLeft = Vec3( positionX + forwardX - forwardY, positionY + forwardY + forwardX, 0.f );
+
+        // Same layout as AddVertsForAABB2D
+        Vertex_PCU* projectileVerts = &m_verts[projectileIndex * 6];
+        projectileVerts[0] = Vertex_PCU( backRight, Rgba::WHITE, Vec2( 0.f, 0.f ) );
+        projectileVerts[1] = Vertex_PCU( backLeft, Rgba::WHITE, Vec2( 0.f, 1.f ) );
+        projectileVerts[2] = Vertex_PCU( frontRight, Rgba::WHITE, Vec2( 1.f, 0.f ) );
+
+        projectileVerts[3] = Vertex_PCU( backLeft, Rgba::WHITE, Vec2( 0.f, 1.f ) );
+        projectileVerts[4] = Vertex_PCU( frontRight, Rgba::WHITE, Vec2( 1.f, 0.f ) );
+        projectileVerts[5] = Vertex_PCU( frontLeft, Rgba::WHITE, Vec2( 1.f, 1.f ) );
+    }
+}
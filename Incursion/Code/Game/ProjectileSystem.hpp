@@ -0,0 +1,64 @@
+#pragma once
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+
+#include "Game/GameCommon.hpp"
+#include "Game/Entity.hpp"
+
+#include "vector"
+
+
+class BufferReader;
+class BufferWriter;
+class Map;
+class StateHash;
+class Texture;
+
+// Bullets for one Map in bullet-hell mode, stored as structure of arrays instead of Bullet entities
+// Integrated four at a time with SSE2, bouncing off tiles found in the map's solid tile bits,
+//  then tested against the broadphase for entity hits, the whole system draws as a single batch
+class ProjectileSystem {
+    public:
+    ProjectileSystem() {};
+    ~ProjectileSystem() {};
+
+    void Startup();
+    void Shutdown();
+
+    void Update( float deltaSeconds, Map& map );
+    void Render() const;
+
+    void SpawnProjectile( const Vec2& position, float orientationDegrees, FactionID faction );
+    void Clear();
+
+    int GetNumProjectiles() const;
+    int GetHighWaterMark() const;
+
+    void AddToStateHash( StateHash& hash ) const;
+    void WriteSnapshot( BufferWriter& writer ) const;
+    void ReadSnapshot( BufferReader& reader ); // Only for bytes SkipSnapshot accepted
+    static bool SkipSnapshot( BufferReader& reader ); // Same checks as a restore needs, without changing anything
+
+    private:
+    const Texture* m_texture = nullptr;
+
+    // One entry per live projectile, padded to a multiple of four with still lanes so the kernel never needs a tail loop
+    // Dead projectiles are swapped out with the last one
+    int m_numProjectiles = 0;
+    std::vector<float> m_positionsX;
+    std::vector<float> m_positionsY;
+    std::vector<float> m_velocitiesX;
+    std::vector<float> m_velocitiesY;
+    std::vector<int> m_bouncesRemaining;
+    std::vector<FactionID> m_factions;
+    int m_highWaterMark = 0;
+
+    std::vector<Vertex_PCU> m_verts; // Six per projectile, rewritten in place every Update
+
+    void Resize( int numProjectiles );
+    void IntegrateFourLanes( int firstIndex, float stepSeconds, int numSteps, const unsigned int* tileSolidBits, const IntVec2& dimensions );
+    void UpdateEntityHits( Map& map );
+    void RemoveSpentProjectiles( Map& map );
+    void UpdateVerts();
+};
@@ -2,5 +2,5 @@
 
 
 bool RaycastResult::DidImpact() const {
-    return (impactTile != nullptr);
+    return didImpact;
 }
@@ -5,13 +5,21 @@
 
 class Tile;
 
+struct RayQuery {
+    public:
+    Vec2 startPosition = Vec2::ZERO;
+    Vec2 normalizedDirection = Vec2::ZERO;
+    float maxDistance = MAP_RAYCAST_MAX_DISTANCE;
+};
+
 struct RaycastResult {
     public:
     float impactFraction = 0.f;
     Vec2 impactPosition = Vec2::ONE;
     Vec2 impactNormal = Vec2::ONE;
     float impactDistance = 0.f;
-    const Tile* impactTile;
+    const Tile* impactTile = nullptr; // nullptr when the ray hit the edge of the map
+    bool didImpact = false;
 
     bool DidImpact() const;
 };
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "Game/SpatialHash.hpp"
+
+#include "Engine/Math/MathUtils.hpp"
+
+#include "Game/Entity.hpp"
+
+
+void SpatialHash::Startup( const IntVec2& dimensions ) {
+    m_dimensions = dimensions;
+
+    int numCells = m_dimensions.x * m_dimensions.y;
+    m_cellHeads.assign( numCells, -1 );
+    m_occupiedCells.clear();
+    m_nodes.clear();
+    m_objects.clear();
+}
+
+
+void SpatialHash::Shutdown() {
+    m_cellHeads.clear();
+    m_occupiedCells.clear();
+    m_nodes.clear();
+    m_objects.clear();
+}
+
+
+void SpatialHash::Rebuild( const EntityList& entities, const std::vector<EntityComponentRef>& entityComponents ) {
+    Clear();
+
+    int numEntities = (int)entityComponents.size();
+    for( int entityIndex = 0; entityIndex < numEntities; entityIndex++ ) {
+        const EntityComponentRef& components = entityComponents[entityIndex];
+        const EntityComponentChunk& chunk = components.store->GetChunk( components.row );
+        int indexInChunk = EntityComponentStore::GetIndexInChunk( components.row );
+
+        if( !chunk.isDead[indexInChunk] && !chunk.isGarbage[indexInChunk] && chunk.physicsRadii[indexInChunk] > 0.f ) {
+            bool isAsleep = chunk.numStillTicks[indexInChunk] >= MAP_SLEEP_STILL_TICKS;
+            Vec2 center = chunk.positions[indexInChunk];
+            float radius = chunk.physicsRadii[indexInChunk];
+
+            if( chunk.isSwept[indexInChunk] ) {
+                // One disc around the whole move this tick, bounces included
+                Vec2 points[ENTITY_MAX_SWEEP_CORNERS + 2];
+                float tickFractions[ENTITY_MAX_SWEEP_CORNERS + 2];
+                int numPoints = GetSweepPoints( chunk, indexInChunk, points, tickFractions );
+                AABB2 moveBounds = AABB2( points[0], points[0] );
+
+                for( int pointIndex = 1; pointIndex < numPoints; pointIndex++ ) {
+                    moveBounds.GrowToIncludePoint( points[pointIndex] );
+                }
+
+                Vec2 halfExtents = 0.5f * moveBounds.GetDimensions();
+                center = moveBounds.mins + halfExtents;
+                radius += halfExtents.GetLength();
+            }
+
+            InsertObject( entities[entityIndex], components, chunk.factions[indexInChunk], isAsleep, center, radius );
+        }
+    }
+}
+
+
+void SpatialHash::Clear() {
+    int numOccupied = (int)m_occupiedCells.size();
+    for( int occupiedIndex = 0; occupiedIndex < numOccupied; occupiedIndex++ ) {
+        m_cellHeads[m_occupiedCells[occupiedIndex]] = -1;
+    }
+
+    m_occupiedCells.clear();
+    m_nodes.clear();
+    m_objects.clear();
+}
+
+
+int SpatialHash::GetCandidatePairs( const CollisionLayers& layers, std::vector<CollisionPair>& out_pairs, int& out_numSkippedPairs, int& out_numSleepingPairs ) const {
+    out_pairs.clear();
+    out_numSkippedPairs = 0;
+    out_numSleepingPairs = 0;
+
+    int numOccupied = (int)m_occupiedCells.size();
+    for( int occupiedIndex = 0; occupiedIndex < numOccupied; occupiedIndex++ ) {
+        int cellIndex = m_occupiedCells[occupiedIndex];
+        int cellX = cellIndex % m_dimensions.x;
+        int cellY = cellIndex / m_dimensions.x;
+
+        for( int nodeA = m_cellHeads[cellIndex]; nodeA != -1; nodeA = m_nodes[nodeA].nextNode ) {
+            const SpatialHashObject& objectA = m_objects[m_nodes[nodeA].objectIndex];
+
+            for( int nodeB = m_nodes[nodeA].nextNode; nodeB != -1; nodeB = m_nodes[nodeB].nextNode ) {
+                const SpatialHashObject& objectB = m_objects[m_nodes[nodeB].objectIndex];
+
+                // Objects spanning several cells share more than one cell
+                // Only report the pair from the lowest cell they share
+                int firstSharedX = objectA.minCell.x > objectB.minCell.x ? objectA.minCell.x : objectB.minCell.x;
+                int firstSharedY = objectA.minCell.y > objectB.minCell.y ? objectA.minCell.y : objectB.minCell.y;
+
+                if( firstSharedX != cellX || firstSharedY != cellY ) {
+                    continue;
+                }
+
+                if( !layers.ShouldCollide( objectA.components.entityType, objectA.faction, objectB.components.entityType, objectB.faction ) ) {
+                    out_numSkippedPairs++;
+                    continue;
+                }
+
+                if( objectA.isAsleep && objectB.isAsleep ) {
+                    out_numSleepingPairs++;
+                    continue;
+                }
+
+                CollisionPair pair;
+                pair.entity1 = objectA.entity;
+                pair.entity2 = objectB.entity;
+                pair.components1 = objectA.components;
+                pair.components2 = objectB.components;
+                pair.isAsleep1 = objectA.isAsleep;
+                pair.isAsleep2 = objectB.isAsleep;
+                out_pairs.push_back( pair );
+            }
+        }
+    }
+
+    return (int)out_pairs.size();
+}
+
+
+void SpatialHash::QueryEntitiesInRadius( const Vec2& center, float radius, EntityList& out_entities ) const {
+    out_entities.clear();
+
+    if( m_cellHeads.empty() ) {
+        return;
+    }
+
+    Vec2 radiusVec = Vec2( radius, radius );
+    IntVec2 queryMinCell;
+    IntVec2 queryMaxCell;
+    GetCellRange( center - radiusVec, center + radiusVec, queryMinCell, queryMaxCell );
+
+    for( int cellY = queryMinCell.y; cellY <= queryMaxCell.y; cellY++ ) {
+        for( int cellX = queryMinCell.x; cellX <= queryMaxCell.x; cellX++ ) {
+            int cellIndex = GetCellIndex( cellX, cellY );
+
+            for( int node = m_cellHeads[cellIndex]; node != -1; node = m_nodes[node].nextNode ) {
+                const SpatialHashObject& object = m_objects[m_nodes[node].objectIndex];
+
+                // Only report from the first cell shared with the query
+                int firstSharedX = object.minCell.x > queryMinCell.x ? object.minCell.x : queryMinCell.x;
+                int firstSharedY = object.minCell.y > queryMinCell.y ? object.minCell.y : queryMinCell.y;
+
+                if( firstSharedX == cellX && firstSharedY == cellY && DoDiscsOverlap( center, radius, object.center, object.radius ) ) {
+                    out_entities.push_back( object.entity );
+                }
+            }
+        }
+    }
+}
+
+
+void SpatialHash::QueryEntitiesInAABB2( const AABB2& bounds, EntityList& out_entities ) const {
+    out_entities.clear();
+
+    if( m_cellHeads.empty() ) {
+        return;
+    }
+
+    IntVec2 queryMinCell;
+    IntVec2 queryMaxCell;
+    GetCellRange( bounds.mins, bounds.maxs, queryMinCell, queryMaxCell );
+
+    for( int cellY = queryMinCell.y; cellY <= queryMaxCell.y; cellY++ ) {
+        for( int cellX = queryMinCell.x; cellX <= queryMaxCell.x; cellX++ ) {
+            int cellIndex = GetCellIndex( cellX, cellY );
+
+            for( int node = m_cellHeads[cellIndex]; node != -1; node = m_nodes[node].nextNode ) {
+                const SpatialHashObject& object = m_objects[m_nodes[node].objectIndex];
+
+                int firstSharedX = object.minCell.x > queryMinCell.x ? object.minCell.x : queryMinCell.x;
+                int firstSharedY = object.minCell.y > queryMinCell.y ? object.minCell.y : queryMinCell.y;
+
+                if( firstSharedX == cellX && firstSharedY == cellY && DoesDiscOverlapAABB2( object.center, object.radius, bounds ) ) {
+                    out_entities.push_back( object.entity );
+                }
+            }
+        }
+    }
+}
+
+
+Entity* SpatialHash::GetFirstEntityTouchingDisc( const Vec2& center, float radius, const CollisionLayers& layers, EntityType type, FactionID faction ) const {
+    if( m_cellHeads.empty() ) {
+        return nullptr;
+    }
+
+    Vec2 radiusVec = Vec2( radius, radius );
+    IntVec2 queryMinCell;
+    IntVec2 queryMaxCell;
+    GetCellRange( center - radiusVec, center + radiusVec, queryMinCell, queryMaxCell );
+
+    for( int cellY = queryMinCell.y; cellY <= queryMaxCell.y; cellY++ ) {
+        for( int cellX = queryMinCell.x; cellX <= queryMaxCell.x; cellX++ ) {
+            int cellIndex = GetCellIndex( cellX, cellY );
+
+            for( int node = m_cellHeads[cellIndex]; node != -1; node = m_nodes[node].nextNode ) {
+                const SpatialHashObject& object = m_objects[m_nodes[node].objectIndex];
+
+                if( !layers.ShouldCollide( type, faction, object.components.entityType, object.faction ) || !DoDiscsOverlap( center, radius, object.center, object.radius ) ) {
+                    continue;
+                }
+
+                // Earlier hits this tick may have killed it
+                if( object.entity->IsAlive() && !object.entity->IsGarbage() ) {
+                    return object.entity;
+                }
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+
+int SpatialHash::GetNumObjects() const {
+    return (int)m_objects.size();
+}
+
+
+size_t SpatialHash::GetMemoryBytes() const {
+    size_t cellBytes = (m_cellHeads.capacity() + m_occupiedCells.capacity()) * sizeof( int );
+    size_t nodeBytes = m_nodes.capacity() * sizeof( SpatialHashNode );
+    size_t objectBytes = m_objects.capacity() * sizeof( SpatialHashObject );
+    return cellBytes + nodeBytes + objectBytes;
+}
+
+
+void SpatialHash::InsertObject( Entity* entity, const EntityComponentRef& components, FactionID faction, bool isAsleep, const Vec2& center, float radius ) {
+    SpatialHashObject object;
+    object.entity = entity;
+    object.components = components;
+    object.faction = faction;
+    object.isAsleep = isAsleep;
+    object.center = center;
+    object.radius = radius;
+
+    Vec2 radiusVec = Vec2( radius, radius );
+    GetCellRange( center - radiusVec, center + radiusVec, object.minCell, object.maxCell );
+
+    int objectIndex = (int)m_objects.size();
+    m_objects.push_back( object );
+
+    for( int cellY = object.minCell.y; cellY <= object.maxCell.y; cellY++ ) {
+        for( int cellX = object.minCell.x; cellX <= object.maxCell.x; cellX++ ) {
+            int cellIndex = GetCellIndex( cellX, cellY );
+
+            if( m_cellHeads[cellIndex] == -1 ) {
+                m_occupiedCells.push_back( cellIndex );
+            }
+
+            SpatialHashNode node;
+            node.objectIndex = objectIndex;
+            node.nextNode = m_cellHeads[cellIndex];
+
+            m_cellHeads[cellIndex] = (int)m_nodes.size();
+            m_nodes.push_back( node );
+        }
+    }
+}
+
+
+void SpatialHash::GetCellRange( const Vec2& mins, const Vec2& maxs, IntVec2& out_minCell, IntVec2& out_maxCell ) const {
+    out_minCell.x = ClampInt( (int)floorf( mins.x ), 0, m_dimensions.x - 1 );
+    out_minCell.y = ClampInt( (int)floorf( mins.y ), 0, m_dimensions.y - 1 );
+    out_maxCell.x = ClampInt( (int)floorf( maxs.x ), 0, m_dimensions.x - 1 );
+    out_maxCell.y = ClampInt( (int)floorf( maxs.y ), 0, m_dimensions.y - 1 );
+}
+
+
+int SpatialHash::GetCellIndex( int cellX, int cellY ) const {
+    return (cellY * m_dimensions.x) + cellX;
+}
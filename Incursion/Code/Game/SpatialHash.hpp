@@ -0,0 +1,75 @@
+#pragma once
+#include "Engine/Math/AABB2.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+
+#include "Game/GameCommon.hpp"
+#include "Game/CollisionLayers.hpp"
+#include "Game/EntityComponents.hpp"
+
+#include "vector"
+
+
+struct CollisionPair {
+    Entity* entity1 = nullptr;
+    Entity* entity2 = nullptr;
+    EntityComponentRef components1;
+    EntityComponentRef components2;
+    bool isAsleep1 = false;
+    bool isAsleep2 = false;
+};
+
+
+// Uniform grid broadphase keyed by tile cell
+// Entities are inserted into every cell their physics disc touches, so any disc radius is supported
+// Queries use the discs cached by the last Rebuild, not live entity positions
+// Rebuild reads discs and flags straight from the component stores, entities are only carried through to the results
+// Entities with no physics radius are left out entirely, pairs of two sleeping entities are never reported
+// Swept entities are inserted as one disc covering their whole move this tick
+class SpatialHash {
+    public:
+    SpatialHash() {};
+    ~SpatialHash() {};
+
+    void Startup( const IntVec2& dimensions );
+    void Shutdown();
+
+    void Rebuild( const EntityList& entities, const std::vector<EntityComponentRef>& entityComponents ); // Lists in the same order
+    void Clear();
+
+    int GetCandidatePairs( const CollisionLayers& layers, std::vector<CollisionPair>& out_pairs, int& out_numSkippedPairs, int& out_numSleepingPairs ) const;
+    void QueryEntitiesInRadius( const Vec2& center, float radius, EntityList& out_entities ) const;
+    void QueryEntitiesInAABB2( const AABB2& bounds, EntityList& out_entities ) const;
+    Entity* GetFirstEntityTouchingDisc( const Vec2& center, float radius, const CollisionLayers& layers, EntityType type, FactionID faction ) const; // Live entities the layers let this type and faction hit
+
+    int GetNumObjects() const;
+    size_t GetMemoryBytes() const; // Cell heads are one per tile, nodes and objects grow with the entities
+
+    private:
+    struct SpatialHashObject {
+        Entity* entity = nullptr;
+        EntityComponentRef components;
+        FactionID faction = FACTION_UNKNOWN;
+        bool isAsleep = false;
+        Vec2 center;
+        float radius = 0.f;
+        IntVec2 minCell;
+        IntVec2 maxCell;
+    };
+
+    struct SpatialHashNode {
+        int objectIndex = -1;
+        int nextNode = -1;
+    };
+
+    IntVec2 m_dimensions = IntVec2( 0, 0 );
+
+    std::vector<int> m_cellHeads;       // First node per cell, -1 when empty
+    std::vector<int> m_occupiedCells;   // Cells touched since the last Clear, so Clear never walks the whole grid
+    std::vector<SpatialHashNode> m_nodes;
+    std::vector<SpatialHashObject> m_objects;
+
+    void InsertObject( Entity* entity, const EntityComponentRef& components, FactionID faction, bool isAsleep, const Vec2& center, float radius );
+    void GetCellRange( const Vec2& mins, const Vec2& maxs, IntVec2& out_minCell, IntVec2& out_maxCell ) const;
+    int GetCellIndex( int cellX, int cellY ) const;
+};
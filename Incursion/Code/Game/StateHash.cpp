@@ -0,0 +1,61 @@
+#include "Game/StateHash.hpp"
+
+#include "string.h"
+
+
+static constexpr unsigned int STATE_HASH_PRIME = 16777619u;
+
+
+StateHash::StateHash( unsigned int previousHash /*= STATE_HASH_OFFSET_BASIS*/ ) :
+    m_hash( previousHash ) {
+}
+
+
+void StateHash::AddBytes( const void* data, size_t numBytes ) {
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    for( size_t byteIndex = 0; byteIndex < numBytes; byteIndex++ ) {
+        m_hash ^= bytes[byteIndex];
+        m_hash *= STATE_HASH_PRIME;
+    }
+}
+
+
+void StateHash::AddInt( int value ) {
+    AddBytes( &value, sizeof( value ) );
+}
+
+
+void StateHash::AddUint( unsigned int value ) {
+    AddBytes( &value, sizeof( value ) );
+}
+
+
+void StateHash::AddFloat( float value ) {
+    unsigned int bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    AddUint( bits );
+}
+
+
+void StateHash::AddBool( bool value ) {
+    unsigned char byte = value ? 1 : 0;
+    AddBytes( &byte, sizeof( byte ) );
+}
+
+
+void StateHash::AddVec2( const Vec2& value ) {
+    AddFloat( value.x );
+    AddFloat( value.y );
+}
+
+
+void StateHash::AddHandle( const EntityHandle& handle ) {
+    AddInt( handle.index );
+    AddUint( handle.generation );
+}
+
+
+unsigned int StateHash::GetHash() const {
+    return m_hash;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+
+#include "Game/EntityHandle.hpp"
+
+
+constexpr unsigned int STATE_HASH_OFFSET_BASIS = 2166136261u;
+
+
+// FNV-1a over the raw bits of simulation state, used to compare runs and lockstep peers tick by tick
+// Floats are hashed bitwise, so two runs only match if they are bit-for-bit identical
+class StateHash {
+    public:
+    explicit StateHash( unsigned int previousHash = STATE_HASH_OFFSET_BASIS ); // Chain off the previous tick for a rolling hash
+
+    void AddBytes( const void* data, size_t numBytes );
+    void AddInt( int value );
+    void AddUint( unsigned int value );
+    void AddFloat( float value );
+    void AddBool( bool value );
+    void AddVec2( const Vec2& value );
+    void AddHandle( const EntityHandle& handle );
+
+    unsigned int GetHash() const;
+
+    private:
+    unsigned int m_hash = STATE_HASH_OFFSET_BASIS;
+};